@@ -0,0 +1,238 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file main.cxx
+ *
+ * Microbenchmark for the AliasCache implementations. Measures the throughput
+ * of alias and Node ID lookups, lookup misses and adds that evict the oldest
+ * entry, for the Map-based and the flat storage.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "os/os.h"
+#include "openlcb/AliasCache.hxx"
+
+using openlcb::AliasCache;
+using openlcb::NodeAlias;
+using openlcb::NodeID;
+
+unsigned num_entries = 2000;
+unsigned num_ops = 1000000;
+const char *implementation = "both";
+
+void usage(const char *e)
+{
+    fprintf(stderr,
+        "Usage: %s [-n entries] [-m operations] [-r tree|flat|both]\n", e);
+    fprintf(stderr,
+        "Fills an alias cache with the given number of entries, then measures "
+        "the throughput of lookups by alias, lookups by Node ID, lookup misses "
+        "and adds that evict an old entry.\n");
+    fprintf(stderr,
+        "\n-r selects the cache implementation to measure. Default both.\n");
+    exit(1);
+}
+
+void parse_args(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:m:r:")) >= 0)
+    {
+        switch (opt)
+        {
+            case 'h':
+                usage(argv[0]);
+                break;
+            case 'n':
+                num_entries = atoi(optarg);
+                break;
+            case 'm':
+                num_ops = atoi(optarg);
+                break;
+            case 'r':
+                implementation = optarg;
+                break;
+            default:
+                fprintf(stderr, "Unknown option %c\n", opt);
+                usage(argv[0]);
+        }
+    }
+    if (!num_entries || num_entries > 4000 || !num_ops ||
+        (strcmp(implementation, "tree") && strcmp(implementation, "flat") &&
+            strcmp(implementation, "both")))
+    {
+        usage(argv[0]);
+    }
+}
+
+/// @param i index of a node. @return the Node ID of the node.
+static NodeID node_id(unsigned i)
+{
+    return 0x050101000000ULL + i * 0x10001ULL;
+}
+
+/// @param i index of a node. @return the alias of the node. There are 4095
+/// valid aliases; nodes that are more than 4095 apart share the alias.
+static NodeAlias node_alias(unsigned i)
+{
+    return 1 + (i * 2671) % 4095;
+}
+
+/// Deterministic pseudo-random sequence of node indexes.
+class RandomNodes
+{
+public:
+    /// @param range nodes will be between base and base + range - 1.
+    /// @param base first node index.
+    RandomNodes(unsigned range, unsigned base = 0)
+        : range_(range)
+        , base_(base)
+    {
+    }
+
+    /// @return the next node index.
+    unsigned next()
+    {
+        seed_ = seed_ * 1103515245 + 12345;
+        return base_ + (seed_ >> 8) % range_;
+    }
+
+private:
+    /// Number of different nodes.
+    unsigned range_;
+    /// Smallest node index.
+    unsigned base_;
+    /// State of the generator.
+    uint32_t seed_{0x12345};
+};
+
+/// Prints the throughput of one measurement.
+/// @param impl name of the implementation. @param name name of the
+/// operation. @param start time when the measurement started.
+/// @param checksum prevents the compiler from optimizing away the lookups.
+static void report(
+    const char *impl, const char *name, long long start, unsigned checksum)
+{
+    long long elapsed = os_get_time_monotonic() - start;
+    printf("%s %-16s %8.1f nsec/op %12.0f ops/sec (check %u)\n", impl, name,
+        (double)elapsed / num_ops, num_ops * 1e9 / elapsed, checksum);
+}
+
+/// Runs all measurements for one implementation.
+/// @param use_flat true for the flat storage, false for the Maps.
+static void run(bool use_flat)
+{
+    const char *impl = use_flat ? "flat" : "tree";
+    AliasCache cache(0, num_entries, nullptr, nullptr, use_flat);
+    for (unsigned i = 0; i < num_entries; ++i)
+    {
+        cache.add(node_id(i), node_alias(i));
+    }
+
+    // The lookup keys are precomputed so that only the cache is measured.
+    std::vector<NodeAlias> aliases(num_ops);
+    std::vector<NodeID> ids(num_ops);
+    RandomNodes hits(num_entries);
+    for (unsigned i = 0; i < num_ops; ++i)
+    {
+        unsigned n = hits.next();
+        aliases[i] = node_alias(n);
+        ids[i] = node_id(n);
+    }
+
+    unsigned checksum = 0;
+    long long start = os_get_time_monotonic();
+    for (unsigned i = 0; i < num_ops; ++i)
+    {
+        checksum += cache.lookup(aliases[i]);
+    }
+    report(impl, "lookup alias", start, checksum);
+
+    checksum = 0;
+    start = os_get_time_monotonic();
+    for (unsigned i = 0; i < num_ops; ++i)
+    {
+        checksum += cache.lookup(ids[i]);
+    }
+    report(impl, "lookup node id", start, checksum);
+
+    RandomNodes misses(1000000, 10000);
+    for (unsigned i = 0; i < num_ops; ++i)
+    {
+        ids[i] = node_id(misses.next());
+    }
+    checksum = 0;
+    start = os_get_time_monotonic();
+    for (unsigned i = 0; i < num_ops; ++i)
+    {
+        checksum += cache.lookup(ids[i]);
+    }
+    report(impl, "lookup miss", start, checksum);
+
+    // Every add evicts the oldest entry. Since the cache has fewer than 4095
+    // entries, the node that had the same alias was already evicted.
+    for (unsigned i = 0; i < num_ops; ++i)
+    {
+        unsigned n = num_entries + i;
+        ids[i] = node_id(n);
+        aliases[i] = node_alias(n);
+    }
+    start = os_get_time_monotonic();
+    for (unsigned i = 0; i < num_ops; ++i)
+    {
+        cache.add(ids[i], aliases[i]);
+    }
+    report(impl, "add and evict", start, cache.lookup(ids[num_ops - 1]));
+}
+
+/** Entry point to application.
+ * @param argc number of command line arguments
+ * @param argv array of command line arguments
+ * @return 0
+ */
+int appl_main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+    printf("entries: %u, operations: %u\n", num_entries, num_ops);
+    if (strcmp(implementation, "flat"))
+    {
+        run(false);
+    }
+    if (strcmp(implementation, "tree"))
+    {
+        run(true);
+    }
+    return 0;
+}
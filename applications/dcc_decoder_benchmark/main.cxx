@@ -0,0 +1,383 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file main.cxx
+ *
+ * Benchmark for the DCC signal decoder. Replays a capture of edge timings
+ * (recorded from a track, or synthesized) through dcc::DccDecoder, one edge
+ * at a time and in batches, and compares the throughput and the decoded
+ * packets.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "os/os.h"
+#include "dcc/Receiver.hxx"
+
+const char *input_file = nullptr;
+const char *output_file = nullptr;
+unsigned num_packets = 10000;
+unsigned repeats = 100;
+unsigned batch_size = 64;
+unsigned ticks_per_usec = 1;
+
+void usage(const char *e)
+{
+    fprintf(stderr,
+        "Usage: %s [-f capture] [-o capture] [-n packets] [-r repeats] "
+        "[-b batch] [-t ticks]\n",
+        e);
+    fprintf(stderr,
+        "Decodes a capture of DCC signal edge timings per edge and in "
+        "batches, then prints edges/sec and packets/sec for both and checks "
+        "that they decoded the same packets.\n");
+    fprintf(stderr,
+        "\n-f capture: text file with one timing (in timer ticks) per line. "
+        "If not given, a capture of random DCC and Marklin-Motorola packets "
+        "is synthesized.\n");
+    fprintf(stderr, "\n-o capture: saves the synthesized capture.\n");
+    fprintf(stderr, "\n-n packets: size of the synthesized capture. Default "
+                    "10000.\n");
+    fprintf(stderr,
+        "\n-r repeats: how many times to decode the capture. Default 100.\n");
+    fprintf(stderr, "\n-b batch: number of timings per batch call. Default "
+                    "64.\n");
+    fprintf(stderr, "\n-t ticks: timer ticks per usec in the capture. "
+                    "Default 1.\n");
+    exit(1);
+}
+
+void parse_args(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "hf:o:n:r:b:t:")) >= 0)
+    {
+        switch (opt)
+        {
+            case 'h':
+                usage(argv[0]);
+                break;
+            case 'f':
+                input_file = optarg;
+                break;
+            case 'o':
+                output_file = optarg;
+                break;
+            case 'n':
+                num_packets = atoi(optarg);
+                break;
+            case 'r':
+                repeats = atoi(optarg);
+                break;
+            case 'b':
+                batch_size = atoi(optarg);
+                break;
+            case 't':
+                ticks_per_usec = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Unknown option %c\n", opt);
+                usage(argv[0]);
+        }
+    }
+    if (!num_packets || !repeats || !batch_size || !ticks_per_usec)
+    {
+        usage(argv[0]);
+    }
+}
+
+/// State of the pseudo-random generator.
+uint32_t seed = 0x12345;
+
+/// @return a deterministic pseudo-random number.
+uint32_t next_random()
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+/// Appends a half-wave with a few usec of jitter.
+/// @param capture where to append @param usec nominal length
+void add_half(std::vector<uint32_t> *capture, unsigned usec)
+{
+    capture->push_back((usec + next_random() % 7 - 3) * ticks_per_usec);
+}
+
+/// Appends a DCC packet with preamble, error check byte and RailCom cutout.
+/// @param capture where to append @param expected gets the decoded packet
+void add_dcc_packet(std::vector<uint32_t> *capture, DCCPacket *expected)
+{
+    unsigned len = 2 + next_random() % 3;
+    uint8_t ec = 0;
+    for (unsigned i = 0; i < len; ++i)
+    {
+        expected->payload[i] = next_random();
+        ec ^= expected->payload[i];
+    }
+    expected->payload[len] = ec;
+    expected->dlc = len + 1;
+    expected->packet_header.skip_ec = 1;
+    for (unsigned i = 0; i < 2 * 14; ++i)
+    {
+        add_half(capture, 58);
+    }
+    for (unsigned i = 0; i < expected->dlc; ++i)
+    {
+        add_half(capture, 100);
+        add_half(capture, 100);
+        for (int bit = 7; bit >= 0; --bit)
+        {
+            unsigned half = (expected->payload[i] >> bit) & 1 ? 58 : 100;
+            add_half(capture, half);
+            add_half(capture, half);
+        }
+    }
+    add_half(capture, 58);
+    add_half(capture, 58);
+    // Cutout.
+    add_half(capture, 30);
+    add_half(capture, 420);
+}
+
+/// Appends a Marklin-Motorola packet.
+/// @param capture where to append @param expected gets the decoded packet
+void add_mm_packet(std::vector<uint32_t> *capture, DCCPacket *expected)
+{
+    uint32_t bits = next_random() & 0x7FFFF;
+    expected->payload[0] = bits >> 16;
+    expected->payload[1] = bits >> 8;
+    expected->payload[2] = bits;
+    expected->dlc = 3;
+    expected->packet_header.is_marklin = 1;
+    add_half(capture, 1500);
+    for (int bit = 18; bit >= 0; --bit)
+    {
+        bool one = (bits >> bit) & 1;
+        add_half(capture, one ? 26 : 208);
+        add_half(capture, one ? 208 : 26);
+    }
+}
+
+/// Synthesizes a capture.
+/// @param capture where to append @param expected gets the decoded packets
+void synthesize(
+    std::vector<uint32_t> *capture, std::vector<DCCPacket> *expected)
+{
+    for (unsigned i = 0; i < num_packets; ++i)
+    {
+        DCCPacket pkt;
+        memset(&pkt, 0, sizeof(pkt));
+        if (next_random() % 10 == 0)
+        {
+            add_mm_packet(capture, &pkt);
+        }
+        else
+        {
+            add_dcc_packet(capture, &pkt);
+        }
+        expected->push_back(pkt);
+    }
+    // Idle signal between the repetitions.
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        add_half(capture, 58);
+    }
+}
+
+/// @param a first packet @param b second packet
+/// @return true if two decoded packets are the same.
+bool same_packet(const DCCPacket &a, const DCCPacket &b)
+{
+    return a.header_raw_data == b.header_raw_data && a.dlc == b.dlc &&
+        !memcmp(a.payload, b.payload, a.dlc);
+}
+
+/// Decodes the capture one edge at a time, the way a capture interrupt does.
+/// @param capture edge timings @param decoded gets the packets of the first
+/// repetition. @return number of packets decoded overall.
+unsigned long run_single(
+    const std::vector<uint32_t> &capture, std::vector<DCCPacket> *decoded)
+{
+    dcc::DccDecoder decoder(ticks_per_usec);
+    unsigned long count = 0;
+    for (unsigned r = 0; r < repeats; ++r)
+    {
+        for (uint32_t value : capture)
+        {
+            decoder.process_data(value);
+            if (decoder.state() == dcc::DccDecoder::DCC_PACKET_FINISHED ||
+                decoder.state() == dcc::DccDecoder::MM_PACKET_FINISHED)
+            {
+                DCCPacket pkt;
+                decoder.packet(&pkt);
+                if (!r)
+                {
+                    decoded->push_back(pkt);
+                }
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+/// Decodes the capture in batches into a ring.
+/// @param capture edge timings @param decoded gets the packets of the first
+/// repetition. @return number of packets decoded overall.
+unsigned long run_batch(
+    const std::vector<uint32_t> &capture, std::vector<DCCPacket> *decoded)
+{
+    dcc::DccDecoder decoder(ticks_per_usec);
+    // A batch may not finish more packets than it has timings.
+    auto *ring = RingBuffer<DCCPacket>::create(batch_size);
+    std::vector<DCCPacket> pkts(batch_size);
+    unsigned long count = 0;
+    for (unsigned r = 0; r < repeats; ++r)
+    {
+        for (size_t ofs = 0; ofs < capture.size(); ofs += batch_size)
+        {
+            size_t len = std::min((size_t)batch_size, capture.size() - ofs);
+            count += decoder.process_data(capture.data() + ofs, len, ring);
+            unsigned n = ring->get(pkts.data(), pkts.size());
+            if (!r)
+            {
+                decoded->insert(decoded->end(), pkts.begin(), pkts.begin() + n);
+            }
+        }
+    }
+    ring->destroy();
+    return count;
+}
+
+/// Compares two lists of decoded packets.
+/// @param name what we compare @param a first list @param b second list
+/// @return true if they are the same.
+bool compare(const char *name, const std::vector<DCCPacket> &a,
+    const std::vector<DCCPacket> &b)
+{
+    if (a.size() != b.size())
+    {
+        printf("MISMATCH %s: %u vs %u packets\n", name, (unsigned)a.size(),
+            (unsigned)b.size());
+        return false;
+    }
+    for (unsigned i = 0; i < a.size(); ++i)
+    {
+        if (!same_packet(a[i], b[i]))
+        {
+            printf("MISMATCH %s: packet %u differs\n", name, i);
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Entry point to application.
+ * @param argc number of command line arguments
+ * @param argv array of command line arguments
+ * @return 0 if the decoded packets were correct, 1 otherwise.
+ */
+int appl_main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+
+    std::vector<uint32_t> capture;
+    std::vector<DCCPacket> expected;
+    if (input_file)
+    {
+        FILE *f = fopen(input_file, "r");
+        if (!f)
+        {
+            perror(input_file);
+            return 1;
+        }
+        unsigned value;
+        while (fscanf(f, "%u", &value) == 1)
+        {
+            capture.push_back(value);
+        }
+        fclose(f);
+    }
+    else
+    {
+        synthesize(&capture, &expected);
+    }
+    if (output_file)
+    {
+        FILE *f = fopen(output_file, "w");
+        if (!f)
+        {
+            perror(output_file);
+            return 1;
+        }
+        for (uint32_t value : capture)
+        {
+            fprintf(f, "%u\n", (unsigned)value);
+        }
+        fclose(f);
+    }
+    if (capture.empty())
+    {
+        fprintf(stderr, "Empty capture.\n");
+        return 1;
+    }
+
+    std::vector<DCCPacket> single_pkts;
+    std::vector<DCCPacket> batch_pkts;
+    long long start = os_get_time_monotonic();
+    unsigned long single_count = run_single(capture, &single_pkts);
+    long long single_time = os_get_time_monotonic() - start;
+    start = os_get_time_monotonic();
+    unsigned long batch_count = run_batch(capture, &batch_pkts);
+    long long batch_time = os_get_time_monotonic() - start;
+
+    double edges = (double)capture.size() * repeats;
+    printf("capture: %s, edges: %u, packets: %u, repeats: %u, batch: %u\n",
+        input_file ? input_file : "synthesized", (unsigned)capture.size(),
+        (unsigned)single_pkts.size(), repeats, batch_size);
+    printf("single: %.0f edges/sec, %.0f packets/sec\n",
+        edges * 1e9 / single_time, single_count * 1e9 / single_time);
+    printf("batch:  %.0f edges/sec, %.0f packets/sec\n",
+        edges * 1e9 / batch_time, batch_count * 1e9 / batch_time);
+
+    bool ok = single_count == batch_count &&
+        compare("single vs batch", single_pkts, batch_pkts);
+    if (!input_file)
+    {
+        ok = compare("decoded vs synthesized", expected, single_pkts) && ok;
+    }
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
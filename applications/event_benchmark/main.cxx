@@ -0,0 +1,345 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file main.cxx
+ *
+ * Benchmark for the event dispatch path. Registers a configurable set of event
+ * handlers, pushes event reports through a real EventService and measures the
+ * throughput, the per-report latency and the number of memory allocations.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "os/os.h"
+#include "utils/Hub.hxx"
+#include "executor/Executor.hxx"
+#include "executor/Service.hxx"
+#include "executor/StateFlow.hxx"
+
+#include "openlcb/IfCan.hxx"
+#include "openlcb/EventService.hxx"
+#include "openlcb/EventServiceImpl.hxx"
+#include "openlcb/EventHandlerContainer.hxx"
+#include "openlcb/EventHandlerTemplates.hxx"
+
+// Counts every heap allocation in the process, so that we can report how many
+// allocations the stack makes per dispatched event. glibc-specific.
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+std::atomic<unsigned long> g_alloc_count{0};
+
+void *malloc(size_t size)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+
+NO_THREAD nt;
+Executor<1> g_executor(nt);
+Service g_service(&g_executor);
+CanHubFlow can_hub0(&g_service);
+
+openlcb::IfCan g_if_can(&g_executor, &can_hub0, 3, 3, 2);
+
+/// Source node of the generated event reports.
+static const openlcb::NodeID SRC_NODE_ID = 0x050101011899ULL;
+/// Event ID of the first handler group. Consecutive groups are 2^16 apart, so
+/// that range registrations of a group do not cover other groups.
+static const uint64_t EVENT_BASE = 0x0501010118990000ULL;
+
+unsigned num_handlers = 1000;
+unsigned num_reports = 100000;
+unsigned fanout = 1;
+const char *distribution = "exact";
+bool use_vector_registry = false;
+bool batched_dispatch = false;
+
+void usage(const char *e)
+{
+    fprintf(stderr,
+        "Usage: %s [-n handlers] [-m reports] [-f fanout] "
+        "[-d exact|mixed|range] [-r tree|vector] [-b]\n",
+        e);
+    fprintf(stderr,
+        "Registers the given number of event handlers and sends event reports "
+        "through an EventService, then prints events/sec, latency "
+        "percentiles and heap allocations per event.\n");
+    fprintf(stderr,
+        "\n-f fanout: this many handlers are registered for each event (each "
+        "report matches at least this many handlers). Default 1.\n");
+    fprintf(stderr,
+        "\n-d selects the registration masks: 'exact' registers single "
+        "events, 'range' registers ranges of 16 to 4096 events, 'mixed' "
+        "registers every 8th handler as a range. Default exact.\n");
+    fprintf(stderr, "\n-r selects the event registry implementation. Default "
+                    "tree.\n");
+    fprintf(stderr, "\n-b turns on batched dispatch of matching handlers.\n");
+    exit(1);
+}
+
+void parse_args(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:m:f:d:r:b")) >= 0)
+    {
+        switch (opt)
+        {
+            case 'h':
+                usage(argv[0]);
+                break;
+            case 'n':
+                num_handlers = atoi(optarg);
+                break;
+            case 'm':
+                num_reports = atoi(optarg);
+                break;
+            case 'f':
+                fanout = atoi(optarg);
+                break;
+            case 'd':
+                distribution = optarg;
+                break;
+            case 'r':
+                use_vector_registry = !strcmp(optarg, "vector");
+                break;
+            case 'b':
+                batched_dispatch = true;
+                break;
+            default:
+                fprintf(stderr, "Unknown option %c\n", opt);
+                usage(argv[0]);
+        }
+    }
+    if (!num_handlers || !num_reports || !fanout || fanout > num_handlers ||
+        (strcmp(distribution, "exact") && strcmp(distribution, "mixed") &&
+            strcmp(distribution, "range")))
+    {
+        usage(argv[0]);
+    }
+}
+
+/// Event handler that counts the event reports it gets.
+class CountingHandler : public openlcb::SimpleEventHandler
+{
+public:
+    void handle_event_report(const EventRegistryEntry &entry,
+        EventReport *event, BarrierNotifiable *done) override
+    {
+        ++count_;
+        done->notify();
+    }
+
+    void handle_identify_global(const EventRegistryEntry &entry,
+        EventReport *event, BarrierNotifiable *done) override
+    {
+        done->notify();
+    }
+
+    /// @return how many event reports this handler has seen.
+    unsigned count()
+    {
+        return count_;
+    }
+
+private:
+    unsigned count_{0};
+};
+
+/// Sends event reports one at a time into the interface, and measures how
+/// long each one takes until all handlers are done with it.
+class BenchmarkFlow : public StateFlowBase
+{
+public:
+    BenchmarkFlow(unsigned num_groups)
+        : StateFlowBase(&g_service)
+        , numGroups_(num_groups)
+    {
+    }
+
+    /// Sends a given number of event reports, then notifies done.
+    /// @param count how many reports to send.
+    /// @param latencies if not null, the latency of each report in
+    /// nanoseconds is appended to it.
+    /// @param done will be notified when all reports are processed.
+    void run(unsigned count, std::vector<long long> *latencies,
+        Notifiable *done)
+    {
+        remaining_ = count;
+        latencies_ = latencies;
+        done_ = done;
+        start_flow(STATE(send_next));
+    }
+
+private:
+    Action send_next()
+    {
+        if (!remaining_)
+        {
+            done_->notify();
+            return exit();
+        }
+        --remaining_;
+        // Deterministic pseudo-random group, so that the hash index and the
+        // caches see a realistic access pattern.
+        seed_ = seed_ * 1103515245 + 12345;
+        unsigned group = (seed_ >> 8) % numGroups_;
+        auto *b = g_if_can.dispatcher()->alloc();
+        b->data()->reset(openlcb::Defs::MTI_EVENT_REPORT, SRC_NODE_ID,
+            openlcb::eventid_to_buffer(EVENT_BASE + ((uint64_t)group << 16)));
+        // The incoming message is released when all handlers are done.
+        b->set_done(bn_.reset(this));
+        sendTime_ = os_get_time_monotonic();
+        g_if_can.dispatcher()->send(b);
+        return wait_and_call(STATE(report_done));
+    }
+
+    Action report_done()
+    {
+        if (latencies_)
+        {
+            latencies_->push_back(os_get_time_monotonic() - sendTime_);
+        }
+        return call_immediately(STATE(send_next));
+    }
+
+    /// Number of distinct event IDs registered.
+    unsigned numGroups_;
+    /// Reports still to send.
+    unsigned remaining_;
+    /// State of the pseudo-random generator.
+    uint32_t seed_{0x12345};
+    /// When the current report was sent.
+    long long sendTime_;
+    /// Where to store the per-report latencies (or null).
+    std::vector<long long> *latencies_;
+    /// Notified when we are done.
+    Notifiable *done_;
+    /// Notified when a report is processed.
+    BarrierNotifiable bn_;
+};
+
+/** Entry point to application.
+ * @param argc number of command line arguments
+ * @param argv array of command line arguments
+ * @return 0, should never return
+ */
+int appl_main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+
+    openlcb::EventService event_service(&g_executor);
+    if (use_vector_registry)
+    {
+        // There can be only one registry instance at a time.
+        event_service.impl()->registry.reset();
+        event_service.impl()->registry.reset(
+            new openlcb::VectorEventHandlers());
+    }
+    event_service.set_batched_dispatch(batched_dispatch);
+    event_service.register_interface(&g_if_can);
+
+    unsigned num_groups = num_handlers / fanout;
+    std::vector<CountingHandler> handlers(num_handlers);
+    for (unsigned i = 0; i < num_handlers; ++i)
+    {
+        unsigned group = i % num_groups;
+        uint64_t event = EVENT_BASE + ((uint64_t)group << 16);
+        unsigned mask = 0;
+        if (!strcmp(distribution, "range") ||
+            (!strcmp(distribution, "mixed") && (i % 8) == 7))
+        {
+            mask = 4 + (i * 7) % 9;
+            event &= ~((1ULL << mask) - 1);
+        }
+        openlcb::EventRegistry::instance()->register_handler(
+            openlcb::EventRegistryEntry(&handlers[i], event), mask);
+    }
+
+    g_executor.start_thread("g_executor", 0, 1024);
+
+    BenchmarkFlow flow(num_groups);
+    SyncNotifiable n;
+    // Warms up the buffer pools and the registry indexes.
+    flow.run(std::min(num_reports, 1000u), nullptr, &n);
+    n.wait_for_notification();
+
+    std::vector<long long> latencies;
+    latencies.reserve(num_reports);
+    unsigned long allocs_before = g_alloc_count.load();
+    long long start = os_get_time_monotonic();
+    flow.run(num_reports, &latencies, &n);
+    n.wait_for_notification();
+    long long elapsed = os_get_time_monotonic() - start;
+    unsigned long allocs = g_alloc_count.load() - allocs_before;
+
+    unsigned long long calls = 0;
+    for (auto &h : handlers)
+    {
+        calls += h.count();
+    }
+    std::sort(latencies.begin(), latencies.end());
+    printf("registry: %s, dispatch: %s, distribution: %s\n",
+        use_vector_registry ? "vector" : "tree",
+        batched_dispatch ? "batched" : "fair-yield", distribution);
+    printf("handlers: %u, fanout: %u, reports: %u, handler calls: %llu\n",
+        num_handlers, fanout, num_reports, calls);
+    printf("events/sec: %.0f\n", num_reports * 1e9 / elapsed);
+    printf("latency p50: %.2f usec, p99: %.2f usec\n",
+        latencies[latencies.size() / 2] / 1000.0,
+        latencies[latencies.size() * 99 / 100] / 1000.0);
+    printf("allocations/event: %.2f\n", (double)allocs / num_reports);
+    fflush(stdout);
+    // The executor thread is still running; skip the global destructors.
+    _exit(0);
+}
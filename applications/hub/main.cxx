@@ -43,6 +43,7 @@
 #include "utils/constants.hxx"
 #include "utils/Hub.hxx"
 #include "utils/GcTcpHub.hxx"
+#include "utils/ShardedCanHub.hxx"
 #include "utils/ClientConnection.hxx"
 #include "executor/Executor.hxx"
 #include "executor/Service.hxx"
@@ -54,6 +55,12 @@ CanHubFlow can_hub0(&g_service);
 OVERRIDE_CONST(gc_generate_newlines, 1);
 OVERRIDE_CONST(gridconnect_buffer_size, 1300);
 OVERRIDE_CONST(gridconnect_buffer_delay_usec, 2000);
+// Serves the TCP clients from the executor with select instead of two threads
+// per client; writes queued data to each client with a single writev.
+OVERRIDE_CONST_TRUE(gridconnect_tcp_use_select);
+// The shard executors allocate and free frame buffers concurrently; keeps a
+// few free buffers in each thread instead of locking the pool every time.
+OVERRIDE_CONST(buffer_pool_thread_cache_size, 32);
 
 
 int port = 12021;
@@ -64,11 +71,13 @@ bool timestamped = false;
 bool export_mdns = false;
 const char* mdns_name = "openmrn_hub";
 bool printpackets = false;
+unsigned num_threads = 1;
 
 void usage(const char *e)
 {
     fprintf(stderr, "Usage: %s [-p port] [-d device_path] [-u upstream_host] "
-                    "[-q upstream_port] [-m] [-n mdns_name] [-t] [-l]\n\n",
+                    "[-q upstream_port] [-m] [-n mdns_name] [-t] [-l] "
+                    "[-j threads]\n\n",
             e);
     fprintf(stderr, "GridConnect CAN HUB.\nListens to a specific TCP port, "
                     "reads CAN packets from the incoming connections using "
@@ -88,6 +97,9 @@ void usage(const char *e)
             "\t-t prints timestamps for each packet.\n");
     fprintf(stderr,
             "\t-l print all packets.\n");
+    fprintf(stderr,
+            "\t-j threads   spreads the TCP connections across this many "
+            "executor threads. Use the number of CPU cores. Default is 1.\n");
 #ifdef HAVE_AVAHI_CLIENT
     fprintf(stderr,
             "\t-m exports the current service on mDNS.\n");
@@ -100,7 +112,7 @@ void usage(const char *e)
 void parse_args(int argc, char *argv[])
 {
     int opt;
-    while ((opt = getopt(argc, argv, "hp:d:u:q:tlmn:")) >= 0)
+    while ((opt = getopt(argc, argv, "hp:d:u:q:tlmn:j:")) >= 0)
     {
         switch (opt)
         {
@@ -132,11 +144,18 @@ void parse_args(int argc, char *argv[])
             case 'l':
                 printpackets = true;
                 break;
+            case 'j':
+                num_threads = atoi(optarg);
+                break;
             default:
                 fprintf(stderr, "Unknown option %c\n", opt);
                 usage(argv[0]);
         }
     }
+    if (num_threads < 1)
+    {
+        usage(argv[0]);
+    }
 }
 
 /** Entry point to application.
@@ -147,13 +166,21 @@ void parse_args(int argc, char *argv[])
 int appl_main(int argc, char *argv[])
 {
     parse_args(argc, argv);
+    // Every frame goes to every client; the copies of a frame for all clients
+    // come from one allocation, without an executor round-trip per client.
+    can_hub0.set_inline_fanout(true);
+    ShardedCanHub sharded_hub(&can_hub0, num_threads);
+    for (unsigned i = 1; i < sharded_hub.size(); ++i)
+    {
+        sharded_hub.shard(i)->set_inline_fanout(true);
+    }
     //GcPacketPrinter packet_printer(&can_hub0, timestamped);
     GcPacketPrinter *packet_printer = NULL;
     if (printpackets) {
         packet_printer = new GcPacketPrinter(&can_hub0, timestamped);
     }
     fprintf(stderr,"packet_printer points to %p\n",packet_printer);
-    GcTcpHub hub(&can_hub0, port);
+    GcTcpHub hub(&sharded_hub, port);
     vector<std::unique_ptr<ConnectionClient>> connections;
 
 #ifdef HAVE_AVAHI_CLIENT
@@ -0,0 +1,245 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file main.cxx
+ *
+ * Benchmark for the fan-out of a CAN hub. Sends frames through a hub with
+ * many ports, like the hub application serving many TCP clients, and
+ * compares copying the frame for every port with the inline fan-out mode.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "os/os.h"
+#include "executor/Executor.hxx"
+#include "executor/Service.hxx"
+#include "executor/StateFlow.hxx"
+#include "utils/Hub.hxx"
+
+// Counts every heap allocation in the process, so that we can report how many
+// allocations the hub makes per frame. glibc-specific.
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+std::atomic<unsigned long> g_alloc_count{0};
+
+void *malloc(size_t size)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+
+NO_THREAD nt;
+Executor<1> g_executor(nt);
+Service g_service(&g_executor);
+CanHubFlow can_hub0(&g_service);
+
+unsigned num_clients = 40;
+unsigned num_frames = 100000;
+unsigned batch_size = 100;
+
+void usage(const char *e)
+{
+    fprintf(stderr, "Usage: %s [-c clients] [-n frames] [-b batch]\n", e);
+    fprintf(stderr,
+        "Sends CAN frames through a hub with the given number of ports, "
+        "first copying each frame for every port, then with inline fan-out. "
+        "Prints frames/sec, copies, pool allocations and heap allocations per "
+        "frame for both.\n");
+    fprintf(stderr, "\n-c clients: number of hub ports. Default 40.\n");
+    fprintf(stderr, "\n-n frames: number of frames to send. Default "
+                    "100000.\n");
+    fprintf(stderr,
+        "\n-b batch: how many frames are sent before waiting for the ports "
+        "to finish. Default 100.\n");
+    exit(1);
+}
+
+void parse_args(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "hc:n:b:")) >= 0)
+    {
+        switch (opt)
+        {
+            case 'h':
+                usage(argv[0]);
+                break;
+            case 'c':
+                num_clients = atoi(optarg);
+                break;
+            case 'n':
+                num_frames = atoi(optarg);
+                break;
+            case 'b':
+                batch_size = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Unknown option %c\n", opt);
+                usage(argv[0]);
+        }
+    }
+    if (num_clients < 2 || !num_frames || !batch_size)
+    {
+        usage(argv[0]);
+    }
+}
+
+/// Hub port that counts the frames it gets, standing in for a client
+/// connection.
+class CountingPort : public CanHubPort
+{
+public:
+    CountingPort()
+        : CanHubPort(&g_service)
+    {
+    }
+
+    Action entry() override
+    {
+        ++count_;
+        return release_and_exit();
+    }
+
+    /// @return how many frames this port has seen.
+    unsigned count()
+    {
+        return count_;
+    }
+
+private:
+    unsigned count_{0};
+};
+
+/// Sends a number of frames into the hub and waits until every port is done
+/// with them. @param count how many frames to send.
+void send_frames(unsigned count)
+{
+    for (unsigned ofs = 0; ofs < count; ofs += batch_size)
+    {
+        SyncNotifiable n;
+        BarrierNotifiable bn(&n);
+        for (unsigned i = ofs; i < count && i < ofs + batch_size; ++i)
+        {
+            Buffer<CanHubData> *b;
+            mainBufferPool->alloc(&b);
+            SET_CAN_FRAME_ID_EFF(*b->data()->mutable_frame(), 0x195B4000 | i);
+            b->data()->can_dlc = 8;
+            b->set_done(bn.new_child());
+            can_hub0.send(b);
+        }
+        bn.notify();
+        n.wait_for_notification();
+    }
+}
+
+/// Sends the frames and prints the results of one run. @param inline_fanout
+/// selects the fan-out mode of the hub.
+void run(bool inline_fanout)
+{
+    can_hub0.set_inline_fanout(inline_fanout);
+    // Warms up the buffer pools.
+    send_frames(std::min(num_frames, 1000u));
+
+    size_t copies_before = can_hub0.num_copies();
+    size_t copy_allocs_before = can_hub0.num_copy_allocations();
+    unsigned long allocs_before = g_alloc_count.load();
+    long long start = os_get_time_monotonic();
+    send_frames(num_frames);
+    long long elapsed = os_get_time_monotonic() - start;
+    unsigned long allocs = g_alloc_count.load() - allocs_before;
+    size_t copies = can_hub0.num_copies() - copies_before;
+    size_t copy_allocs = can_hub0.num_copy_allocations() - copy_allocs_before;
+
+    printf("%s: %.0f frames/sec, copies/frame: %.2f, pool allocations/frame: "
+           "%.2f, heap allocations/frame: %.2f\n",
+        inline_fanout ? "inline fan-out" : "copy per port ",
+        num_frames * 1e9 / elapsed, (double)copies / num_frames,
+        (double)copy_allocs / num_frames, (double)allocs / num_frames);
+}
+
+/** Entry point to application.
+ * @param argc number of command line arguments
+ * @param argv array of command line arguments
+ * @return 0 if every port got every frame.
+ */
+int appl_main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+    std::vector<std::unique_ptr<CountingPort>> ports;
+    for (unsigned i = 0; i < num_clients; ++i)
+    {
+        ports.emplace_back(new CountingPort());
+        can_hub0.register_port(ports.back().get());
+    }
+    g_executor.start_thread("g_executor", 0, 1024);
+
+    printf("clients: %u, frames: %u, batch: %u\n", num_clients, num_frames,
+        batch_size);
+    run(false);
+    run(true);
+
+    int ret = 0;
+    unsigned expected = 2 * (num_frames + std::min(num_frames, 1000u));
+    for (auto &p : ports)
+    {
+        if (p->count() != expected)
+        {
+            printf("FAILED: a port got %u frames instead of %u\n", p->count(),
+                expected);
+            ret = 1;
+            break;
+        }
+    }
+    fflush(stdout);
+    // The executor thread is still running; skip the global destructors.
+    _exit(ret);
+}
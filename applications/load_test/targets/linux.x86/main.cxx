@@ -48,6 +48,11 @@ OVERRIDE_CONST(gc_generate_newlines, 1);
 // Specifies how much RAM (in bytes) we allocate to the stack of the main
 // thread. Useful tuning parameter in case the application runs out of memory.
 OVERRIDE_CONST(main_thread_stack_size, 2500);
+// Keeps freed message payloads for reuse, so that datagrams and other long
+// messages do not need a malloc and free each.
+OVERRIDE_CONST(payload_cache_size, 4);
+// Sends every frame of a datagram or long addressed message in one burst.
+OVERRIDE_CONST(can_write_burst_frames, 64);
 
 // Specifies the 48-bit OpenLCB node identifier. This must be unique for every
 // hardware manufactured, so in production this should be replaced by some
@@ -89,12 +89,13 @@ static uint64_t destination_alias = 0;
 static int memory_space_id = openlcb::MemoryConfigDefs::SPACE_CONFIG;
 static bool do_read = false;
 static bool do_write = false;
+static unsigned window = 1;
 
 void usage(const char *e)
 {
     fprintf(stderr,
         "Usage: %s ([-i destination_host] [-p port] | [-d device_path]) [-s "
-        "memory_space_id] [-c csum_algo] (-r|-w)  (-n nodeid | -a "
+        "memory_space_id] [-c csum_algo] [-W window] (-r|-w)  (-n nodeid | -a "
         "alias) -f filename\n",
         e);
     fprintf(stderr, "Connects to an openlcb bus and performs the "
@@ -114,13 +115,17 @@ void usage(const char *e)
     fprintf(stderr, "memory_space_id defines which memory space to use "
                     "data into. Default is '-s 0xF0'.\n");
     fprintf(stderr, "-r or -w  defines whether to read or write.\n");
+    fprintf(stderr,
+        "window is the number of datagrams to keep in flight, 1 to %u. "
+        "Default is 1.\n",
+        openlcb::MemoryConfigClient::MAX_WINDOW);
     exit(1);
 }
 
 void parse_args(int argc, char *argv[])
 {
     int opt;
-    while ((opt = getopt(argc, argv, "hp:i:d:n:a:s:f:rw")) >= 0)
+    while ((opt = getopt(argc, argv, "hp:i:d:n:a:s:f:rwW:")) >= 0)
     {
         switch (opt)
         {
@@ -154,6 +159,9 @@ void parse_args(int argc, char *argv[])
             case 'w':
                 do_write = true;
                 break;
+            case 'W':
+                window = atoi(optarg);
+                break;
             default:
                 fprintf(stderr, "Unknown option %c\n", opt);
                 usage(argv[0]);
@@ -163,6 +171,10 @@ void parse_args(int argc, char *argv[])
     {
         usage(argv[0]);
     }
+    if (window < 1 || window > openlcb::MemoryConfigClient::MAX_WINDOW)
+    {
+        usage(argv[0]);
+    }
     if ((do_read ? 1 : 0) + (do_write ? 1 : 0) != 1)
     {
         fprintf(stderr, "Must set exactly one of option -r and option -w.\n\n");
@@ -201,6 +213,7 @@ int appl_main(int argc, char *argv[])
     dst.alias = destination_alias;
     dst.id = destination_nodeid;
     HASSERT(do_read);
+    g_memcfg_cli.set_window(window);
     auto b = invoke_flow(&g_memcfg_cli, openlcb::MemoryConfigClientRequest::READ, dst, memory_space_id);
 
     if (0 && do_write)
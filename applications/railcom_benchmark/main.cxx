@@ -0,0 +1,330 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file main.cxx
+ *
+ * Benchmark for the railcom feedback parser. Replays cutout dumps of a
+ * multi-channel detector through dcc::parse_railcom_data, one channel at a
+ * time and all channels of a cutout at once, and compares the throughput and
+ * the decoded packets.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "os/os.h"
+#include "dcc/RailCom.hxx"
+
+const char *input_file = nullptr;
+unsigned num_channels = 16;
+unsigned num_cutouts = 10000;
+unsigned repeats = 100;
+
+/// Cutout dumps of a single channel: channel 1 bytes and channel 2 bytes, as
+/// hex strings ("-" is empty). Taken from real decoders; most of them are in
+/// RailCom.cxxtest.
+static const char *const DUMPS[][2] = {
+    {"-", "-"},                   // no decoder in this section
+    {"F0", "-"},                  // ACK
+    {"F0E1", "0F"},               // ACK, BUSY, NACK
+    {"-", "8BAC"},                // EXT
+    {"-", "8BACA971"},            // EXT and POM
+    {"8B", "AC"},                 // channel boundary problem
+    {"F5", "8BAC"},               // garbage in channel 1
+    {"A6A6", "-"},                // address
+    {"-", "A6A5A5A5A5A5"},        // 32-bit POM
+    {"-", "A65C0F0F0F0F"},        // POM with NACK fill (ESU LokPilot V4)
+    {"-", "4B4B4B"},              // DYN
+    {"-", "F5F5"},                // garbage in channel 2
+};
+
+void usage(const char *e)
+{
+    fprintf(stderr,
+        "Usage: %s [-f dumps] [-c channels] [-n cutouts] [-r repeats]\n", e);
+    fprintf(stderr,
+        "Parses railcom cutout dumps of a multi-channel detector one channel "
+        "at a time and one cutout at a time, then prints channels/sec and "
+        "packets/sec for both and checks that they decoded the same "
+        "packets.\n");
+    fprintf(stderr,
+        "\n-f dumps: text file with the dump of one channel per line: the "
+        "channel 1 and the channel 2 bytes as two hex strings, '-' for no "
+        "bytes. Consecutive lines make up a cutout. If not given, the "
+        "built-in dumps are mixed.\n");
+    fprintf(stderr, "\n-c channels: number of channels per cutout. Default "
+                    "16.\n");
+    fprintf(stderr,
+        "\n-n cutouts: number of generated cutouts. Default 10000.\n");
+    fprintf(stderr,
+        "\n-r repeats: how many times to parse the dumps. Default 100.\n");
+    exit(1);
+}
+
+void parse_args(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "hf:c:n:r:")) >= 0)
+    {
+        switch (opt)
+        {
+            case 'h':
+                usage(argv[0]);
+                break;
+            case 'f':
+                input_file = optarg;
+                break;
+            case 'c':
+                num_channels = atoi(optarg);
+                break;
+            case 'n':
+                num_cutouts = atoi(optarg);
+                break;
+            case 'r':
+                repeats = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Unknown option %c\n", opt);
+                usage(argv[0]);
+        }
+    }
+    if (!num_channels || !num_cutouts || !repeats)
+    {
+        usage(argv[0]);
+    }
+}
+
+/// Parses a hex string into feedback bytes.
+/// @param hex the string, or "-" for empty
+/// @param ch1 true to add to channel 1, false for channel 2
+/// @param fb where to add the bytes.
+/// @return false if the string is not valid hex.
+bool add_hex(const char *hex, bool ch1, dcc::Feedback *fb)
+{
+    if (!strcmp(hex, "-"))
+    {
+        return true;
+    }
+    unsigned len = strlen(hex);
+    if (len % 2)
+    {
+        return false;
+    }
+    for (unsigned i = 0; i < len; i += 2)
+    {
+        char byte[3] = {hex[i], hex[i + 1], 0};
+        char *end;
+        uint8_t value = strtoul(byte, &end, 16);
+        if (*end)
+        {
+            return false;
+        }
+        if (ch1)
+        {
+            fb->add_ch1_data(value);
+        }
+        else
+        {
+            fb->add_ch2_data(value);
+        }
+    }
+    return true;
+}
+
+/// Appends a feedback from one channel's dump.
+/// @param ch1 channel 1 hex @param ch2 channel 2 hex
+/// @param fbs where to append
+/// @return false if the dump is malformed.
+bool add_dump(
+    const char *ch1, const char *ch2, std::vector<dcc::Feedback> *fbs)
+{
+    dcc::Feedback fb;
+    fb.reset(0);
+    fb.channel = fbs->size() % num_channels;
+    if (!add_hex(ch1, true, &fb) || !add_hex(ch2, false, &fb))
+    {
+        return false;
+    }
+    fbs->push_back(fb);
+    return true;
+}
+
+/// State of the pseudo-random generator.
+uint32_t seed = 0x12345;
+
+/// @return a deterministic pseudo-random number.
+uint32_t next_random()
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+/// Parses every channel on its own, the way a per-channel driver callback
+/// does.
+/// @param fbs the feedbacks @param decoded gets the packets of the first
+/// repetition. @return number of packets decoded overall.
+unsigned long run_single(const std::vector<dcc::Feedback> &fbs,
+    std::vector<dcc::RailcomPacket> *decoded)
+{
+    std::vector<dcc::RailcomPacket> output;
+    unsigned long count = 0;
+    for (unsigned r = 0; r < repeats; ++r)
+    {
+        for (const auto &fb : fbs)
+        {
+            dcc::parse_railcom_data(fb, &output);
+            count += output.size();
+            if (!r)
+            {
+                decoded->insert(decoded->end(), output.begin(), output.end());
+            }
+        }
+    }
+    return count;
+}
+
+/// Parses all channels of a cutout in one call.
+/// @param fbs the feedbacks @param decoded gets the packets of the first
+/// repetition. @return number of packets decoded overall.
+unsigned long run_bulk(const std::vector<dcc::Feedback> &fbs,
+    std::vector<dcc::RailcomPacket> *decoded)
+{
+    std::vector<dcc::RailcomPacket> output;
+    unsigned long count = 0;
+    for (unsigned r = 0; r < repeats; ++r)
+    {
+        for (unsigned ofs = 0; ofs < fbs.size(); ofs += num_channels)
+        {
+            unsigned n = std::min((size_t)num_channels, fbs.size() - ofs);
+            dcc::parse_railcom_data(fbs.data() + ofs, n, &output);
+            count += output.size();
+            if (!r)
+            {
+                decoded->insert(decoded->end(), output.begin(), output.end());
+            }
+        }
+    }
+    return count;
+}
+
+/// @param a first packet @param b second packet
+/// @return true if two decoded packets are the same.
+bool same_packet(const dcc::RailcomPacket &a, const dcc::RailcomPacket &b)
+{
+    return a.hw_channel == b.hw_channel &&
+        a.railcom_channel == b.railcom_channel && a.type == b.type &&
+        a.argument == b.argument;
+}
+
+/** Entry point to application.
+ * @param argc number of command line arguments
+ * @param argv array of command line arguments
+ * @return 0 if the decoded packets were the same, 1 otherwise.
+ */
+int appl_main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+
+    std::vector<dcc::Feedback> fbs;
+    if (input_file)
+    {
+        FILE *f = fopen(input_file, "r");
+        if (!f)
+        {
+            perror(input_file);
+            return 1;
+        }
+        char ch1[64], ch2[64];
+        while (fscanf(f, "%63s %63s", ch1, ch2) == 2)
+        {
+            if (!add_dump(ch1, ch2, &fbs))
+            {
+                fprintf(stderr, "Malformed dump in line %u\n",
+                    (unsigned)fbs.size() + 1);
+                return 1;
+            }
+        }
+        fclose(f);
+    }
+    else
+    {
+        for (unsigned i = 0; i < num_cutouts * num_channels; ++i)
+        {
+            // Most sections have no decoder in them.
+            unsigned d = next_random() % (2 * ARRAYSIZE(DUMPS));
+            if (d >= ARRAYSIZE(DUMPS))
+            {
+                d = 0;
+            }
+            add_dump(DUMPS[d][0], DUMPS[d][1], &fbs);
+        }
+    }
+    if (fbs.empty())
+    {
+        fprintf(stderr, "No dumps.\n");
+        return 1;
+    }
+
+    std::vector<dcc::RailcomPacket> single_pkts;
+    std::vector<dcc::RailcomPacket> bulk_pkts;
+    long long start = os_get_time_monotonic();
+    unsigned long single_count = run_single(fbs, &single_pkts);
+    long long single_time = os_get_time_monotonic() - start;
+    start = os_get_time_monotonic();
+    unsigned long bulk_count = run_bulk(fbs, &bulk_pkts);
+    long long bulk_time = os_get_time_monotonic() - start;
+
+    double channels = (double)fbs.size() * repeats;
+    printf("dumps: %s, channels: %u per cutout, %u total, packets: %u, "
+           "repeats: %u\n",
+        input_file ? input_file : "built-in", num_channels,
+        (unsigned)fbs.size(), (unsigned)single_pkts.size(), repeats);
+    printf("single: %.0f channels/sec, %.0f packets/sec\n",
+        channels * 1e9 / single_time, single_count * 1e9 / single_time);
+    printf("bulk:   %.0f channels/sec, %.0f packets/sec\n",
+        channels * 1e9 / bulk_time, bulk_count * 1e9 / bulk_time);
+
+    bool ok = single_count == bulk_count &&
+        single_pkts.size() == bulk_pkts.size();
+    for (unsigned i = 0; ok && i < single_pkts.size(); ++i)
+    {
+        if (!same_packet(single_pkts[i], bulk_pkts[i]))
+        {
+            printf("MISMATCH: packet %u differs\n", i);
+            ok = false;
+        }
+    }
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
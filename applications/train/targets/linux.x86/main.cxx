@@ -63,6 +63,8 @@ const char *device_path = nullptr;
 const char *name = "Deadrail Train";
 int address = 1732;
 OVERRIDE_CONST(num_memory_spaces, 4);
+OVERRIDE_CONST(payload_cache_size, 4);
+OVERRIDE_CONST(can_write_burst_frames, 64);
 
 namespace openlcb
 {
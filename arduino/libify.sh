@@ -153,9 +153,7 @@ rm -f ${TARGET_LIB_DIR}/src/dcc/dcc_test_utils.hxx
 copy_file src/executor src/executor/*.hxx src/executor/*.cxx
 copy_file src/openlcb src/openlcb/*.hxx src/openlcb/*.cxx
 
-rm -f ${TARGET_LIB_DIR}/src/openlcb/CompileCdiMain.cxx \
-    ${TARGET_LIB_DIR}/src/openlcb/Stream.cxx \
-    ${TARGET_LIB_DIR}/src/openlcb/Stream.hxx
+rm -f ${TARGET_LIB_DIR}/src/openlcb/CompileCdiMain.cxx
 
 copy_file src/freertos_drivers/arduino \
           src/freertos_drivers/common/DeviceBuffer.{hxx,cxx} \
@@ -116,6 +116,20 @@ DECLARE_CONST(gridconnect_buffer_delay_usec);
  * two threads per client (multi-threaded) execution model. */
 DECLARE_CONST(gridconnect_tcp_use_select);
 
+/** Maximum number of queued hub buffers that HubDeviceSelect gathers into a
+ * single writev call. 1 writes each buffer separately. */
+DECLARE_CONST(hub_device_write_batch_size);
+
+/** How long (in microsec) HubDeviceSelect may hold back outgoing data to
+ * gather more buffers into a single write call. 0 writes whatever is queued
+ * right away. */
+DECLARE_CONST(hub_device_write_flush_usec);
+
+/** Number of free buffers per bucket that each thread may cache from the
+ * mainBufferPool, to avoid taking the bucket lock on every alloc and free. 0
+ * disables the thread caches. Only used on hosts with thread_local support. */
+DECLARE_CONST(buffer_pool_thread_cache_size);
+
 /** Number of entries in the remote alias cache */
 DECLARE_CONST(remote_alias_cache_size);
 
@@ -146,5 +160,36 @@ DECLARE_CONST(enable_all_memory_space);
  * standard. */
 DECLARE_CONST(node_init_identify);
 
+/** Set to CONSTANT_TRUE if the event service should collect the matching event
+ * handlers and call them back-to-back instead of yielding to the executor
+ * between each handler call. */
+DECLARE_CONST(event_batched_dispatch);
+
+/** Stream buffer size in bytes proposed by the stream senders and accepted by
+ * the stream receivers, unless the caller asks for a different size. */
+DECLARE_CONST(stream_buffer_size);
+
+/** How many stream buffers a stream receiver allows the sender to send ahead
+ * of the data consumed. Each one needs stream_buffer_size bytes of memory. */
+DECLARE_CONST(stream_receiver_window);
+
+/** Number of message payload buffers kept for reuse after the messages
+ * carrying them are freed. Payloads of more than ~15 bytes (datagrams, SNIP
+ * replies, stream data) then do not need a malloc and free each. 0 (the
+ * default) disables the cache. Each cached buffer holds up to 512 bytes of
+ * memory, so this is meant for host applications. */
+DECLARE_CONST(payload_cache_size);
+
+/** Maximum number of CAN frames of a single outgoing message (addressed
+ * message, datagram, stream data) that are allocated, rendered and handed to
+ * the CAN hub back-to-back in one executor step. The frames of a burst are
+ * contiguous in the hub's queue. 1 sends one frame per executor round-trip. */
+DECLARE_CONST(can_write_burst_frames);
+
+/** Maximum number of remote nodes that a NodeInventory sends PIP and SNIP
+ * requests to concurrently. Higher values make enumerating large networks
+ * faster, at the cost of burstier bus traffic. */
+DECLARE_CONST(node_inventory_max_parallel);
+
 
 #endif /* _nmranet_config_h_ */
@@ -55,6 +55,32 @@
 #define OPENMRN_HAVE_PSELECT 1
 #endif
 
+#if defined(__linux__) && !defined(__EMSCRIPTEN__) && OPENMRN_HAVE_PSELECT
+/// Uses epoll instead of ::pselect in the Executor to wait for file
+/// descriptors. Not limited by FD_SETSIZE, and the cost of a wakeup depends on
+/// the number of ready fds only.
+#define OPENMRN_HAVE_EPOLL 1
+#endif
+
+#if OPENMRN_HAVE_PSELECT
+/// ::writev is available for gathering multiple buffers into one write call.
+#define OPENMRN_HAVE_WRITEV 1
+#endif
+
+#if OPENMRN_HAVE_PSELECT
+/// ActiveTimers keeps the scheduled timers in a 4-ary heap instead of a sorted
+/// linked list. Scheduling and cancelling are O(log n) instead of O(n), at the
+/// cost of a dynamically allocated array.
+#define OPENMRN_FEATURE_TIMER_HEAP 1
+#endif
+
+#if OPENMRN_HAVE_PSELECT && !defined(__EMSCRIPTEN__)
+/// DynamicPool may keep a small cache of free buffers in each thread, so that
+/// most allocations and frees do not take the lock of the bucket. Needs
+/// thread_local support.
+#define OPENMRN_FEATURE_BUFFER_THREAD_CACHE 1
+#endif
+
 #if defined(__WINNT__) || defined(ESP32) || defined(ESP_NONOS)
 /// Uses ::select in the executor to sleep (unsure how wakeup is handled)
 #define OPENMRN_HAVE_SELECT 1
@@ -83,6 +83,30 @@ unsigned Dcc28Payload::get_fn_update_code(unsigned address)
 // Generates next outgoing packet.
 template <class Payload>
 void DccTrain<Payload>::get_next_packet(unsigned code, Packet *packet)
+{
+    if (code == REFRESH)
+    {
+        fill_packet(next_refresh_code(), false, packet);
+    }
+    else
+    {
+        fill_packet(code, true, packet);
+    }
+}
+
+template <class Payload> unsigned DccTrain<Payload>::next_refresh_code()
+{
+    unsigned code = MIN_REFRESH + this->p.nextRefresh_++;
+    if (this->p.nextRefresh_ > MAX_REFRESH - MIN_REFRESH)
+    {
+        this->p.nextRefresh_ = 0;
+    }
+    return code;
+}
+
+template <class Payload>
+void DccTrain<Payload>::fill_packet(
+    unsigned code, bool user_action, Packet *packet)
 {
     packet->start_dcc_packet();
     if (this->p.isShortAddress_)
@@ -93,15 +117,7 @@ void DccTrain<Payload>::get_next_packet(unsigned code, Packet *packet)
     {
         packet->add_dcc_address(DccLongAddress(this->p.address_));
     }
-    if (code == REFRESH)
-    {
-        code = MIN_REFRESH + this->p.nextRefresh_++;
-        if (this->p.nextRefresh_ > MAX_REFRESH - MIN_REFRESH)
-        {
-            this->p.nextRefresh_ = 0;
-        }
-    }
-    else
+    if (user_action)
     {
         // User action. Up repeat count.
         packet->packet_header.rept_count = 2;
@@ -156,6 +172,42 @@ void DccTrain<Payload>::get_next_packet(unsigned code, Packet *packet)
     }
 }
 
+// Generates next outgoing packet.
+template <class Payload>
+void CachedDccTrain<Payload>::get_next_packet(unsigned code, Packet *packet)
+{
+    bool user_action = code != REFRESH;
+    if (!user_action)
+    {
+        code = this->next_refresh_code();
+    }
+    if (code < MIN_REFRESH || code > MAX_REFRESH)
+    {
+        // Not part of the refresh sequence.
+        this->fill_packet(code, user_action, packet);
+        return;
+    }
+    unsigned bit = 1 << (code - MIN_REFRESH);
+    CachedPacket *c = &cache_[code - MIN_REFRESH];
+    if (!user_action && (cacheValid_ & bit))
+    {
+        packet->start_dcc_packet();
+        packet->packet_header.skip_ec = 1;
+        packet->dlc = c->dlc;
+        memcpy(packet->payload, c->payload, c->dlc);
+        if (code == SPEED)
+        {
+            this->p.directionChanged_ = 0;
+        }
+        return;
+    }
+    this->fill_packet(code, user_action, packet);
+    HASSERT(packet->dlc <= sizeof(c->payload));
+    c->dlc = packet->dlc;
+    memcpy(c->payload, packet->payload, packet->dlc);
+    cacheValid_ |= bit;
+}
+
 MMOldTrain::MMOldTrain(MMAddress a)
 {
     p.address_ = a.value;
@@ -269,6 +321,8 @@ void MMNewTrain::get_next_packet(unsigned code, Packet *packet)
 void createtrains() {
     Dcc28Train train1(DccShortAddress(1));
     Dcc128Train train2(DccShortAddress(1));
+    Dcc28CachedTrain train5(DccShortAddress(1));
+    Dcc128CachedTrain train6(DccLongAddress(1));
     MMNewTrain train3(MMAddress(1));
     MMOldTrain train4(MMAddress(1));
 }
@@ -131,6 +131,7 @@ public:
         {
             p.speed_ = 0;
         }
+        state_changed(SPEED);
         packet_processor_notify_update(this, SPEED);
     }
 
@@ -155,6 +156,7 @@ public:
         dir0.set_direction(p.direction_);
         p.lastSetSpeed_ = dir0.get_wire();
         p.directionChanged_ = 1;
+        state_changed(SPEED);
         /// @todo (Stuart.Baker) We should not just send a single E-Stop burst.
         /// It is possible that the loco was on dirt and missed this.  Should
         /// send continuous E-Stop packets until the estop condition is cleared.
@@ -183,6 +185,7 @@ public:
         {
             p.fn_ &= ~bit;
         }
+        state_changed(p.get_fn_update_code(address));
         packet_processor_notify_update(this, p.get_fn_update_code(address));
     }
     /// @return the last set value of a given function, or 0 if the function is
@@ -208,6 +211,12 @@ public:
     }
 
 protected:
+    /// Called by the setters after the train state changed.
+    /// @param code is the update code of the packet whose content changed.
+    virtual void state_changed(unsigned code)
+    {
+    }
+
     /// Payload -- actual data we know about the train.
     P p;
 };
@@ -299,6 +308,18 @@ public:
     /// requested by the previous cycle or the on-update notification). @param
     /// packet needs to be filled in for the output.
     void get_next_packet(unsigned code, Packet *packet) OVERRIDE;
+
+protected:
+    /// Advances the background refresh sequence. @return the update code of
+    /// the next refresh packet.
+    unsigned next_refresh_code();
+
+    /// Encodes a packet from the current state.
+    /// @param code is the update code (not REFRESH).
+    /// @param user_action true if this is a packet for a notified update,
+    /// which gets repeated.
+    /// @param packet needs to be filled in for the output.
+    void fill_packet(unsigned code, bool user_action, Packet *packet);
 };
 
 /// TrainImpl class for a 28-speed-step DCC locomotive.
@@ -371,6 +392,64 @@ struct Dcc128Payload
 /// TrainImpl class for a 128-speed-step DCC locomotive.
 typedef DccTrain<Dcc128Payload> Dcc128Train;
 
+/// DCC locomotive that keeps the encoded form of its background refresh
+/// packets. A refresh is then a copy of a few bytes instead of encoding the
+/// address, the instruction and the checksum again. The cached packets are
+/// invalidated by the speed and function setters.
+///
+/// This takes 6 bytes of RAM per refresh packet type more than @ref
+/// DccTrain; use it when the command station has the memory and many
+/// locomotives in the refresh loop.
+template <class Payload> class CachedDccTrain : public DccTrain<Payload>
+{
+public:
+    /// Constructor. @param a is the address.
+    template <class A>
+    CachedDccTrain(A a)
+        : DccTrain<Payload>(a)
+    {
+    }
+
+    /// Generates next outgoing packet. @param code is the packet code (as
+    /// requested by the previous cycle or the on-update notification). @param
+    /// packet needs to be filled in for the output.
+    void get_next_packet(unsigned code, Packet *packet) OVERRIDE;
+
+private:
+    /// Number of update codes in the background refresh sequence.
+    static constexpr unsigned NUM_CACHED = MAX_REFRESH - MIN_REFRESH + 1;
+
+    /// Drops the cached packet of a given update code.
+    /// @param code is the update code whose packet changed.
+    void state_changed(unsigned code) OVERRIDE
+    {
+        if (code >= MIN_REFRESH && code <= MAX_REFRESH)
+        {
+            cacheValid_ &= ~(1 << (code - MIN_REFRESH));
+        }
+    }
+
+    /// Encoded payload of a refresh packet (including the checksum).
+    struct CachedPacket
+    {
+        /// Number of payload bytes.
+        uint8_t dlc;
+        /// Payload bytes. An address of up to 2 bytes, an instruction of up
+        /// to 2 bytes and the checksum.
+        uint8_t payload[5];
+    };
+
+    /// Bit (code - MIN_REFRESH) is set if cache_ has the packet for code.
+    uint8_t cacheValid_ {0};
+    /// Cached packets, indexed by code - MIN_REFRESH.
+    CachedPacket cache_[NUM_CACHED];
+};
+
+/// 28-speed-step DCC locomotive with cached refresh packets.
+typedef CachedDccTrain<Dcc28Payload> Dcc28CachedTrain;
+/// 128-speed-step DCC locomotive with cached refresh packets.
+typedef CachedDccTrain<Dcc128Payload> Dcc128CachedTrain;
+
 /// Structure defining the volatile state for a Marklin-Motorola v1 protocol
 /// locomotive (with 14 speed steps, one function and relative direction only).
 struct MMOldPayload
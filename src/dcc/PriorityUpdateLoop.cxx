@@ -0,0 +1,291 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file PriorityUpdateLoop.cxx
+ *
+ * Control flow central to the command station: it schedules user updates
+ * ahead of the background refresh, and refreshes the stalest trains first.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#include "dcc/PriorityUpdateLoop.hxx"
+#include "dcc/Loco.hxx"
+#include "dcc/Packet.hxx"
+#include "dcc/PacketSource.hxx"
+
+namespace dcc
+{
+
+PriorityUpdateLoop::PriorityUpdateLoop(Service *service,
+    PacketFlowInterface *track_send, long long speed_period,
+    long long refresh_period)
+    : StateFlow(service)
+    , trackSend_(track_send)
+    , speedPeriod_(speed_period)
+    , refreshPeriod_(refresh_period)
+{
+}
+
+PriorityUpdateLoop::~PriorityUpdateLoop()
+{
+}
+
+bool PriorityUpdateLoop::add_refresh_source(
+    dcc::PacketSource *source, unsigned priority)
+{
+    AtomicHolder h(this);
+    bool ret = true;
+    for (const auto &e : sources_)
+    {
+        if (e.priority >= EXCLUSIVE_MIN_PRIORITY && e.priority >= priority)
+        {
+            ret = false;
+        }
+    }
+    // New sources are due for both refresh classes right away.
+    long long now = os_get_time_monotonic();
+    sources_.push_back(
+        {source, priority, now - speedPeriod_, now - refreshPeriod_, 0, false});
+    return ret;
+}
+
+void PriorityUpdateLoop::remove_refresh_source(dcc::PacketSource *source)
+{
+    AtomicHolder h(this);
+    for (unsigned i = 0; i < sources_.size(); ++i)
+    {
+        if (sources_[i].source == source)
+        {
+            sources_.erase(sources_.begin() + i);
+            break;
+        }
+    }
+    for (auto it = updates_.begin(); it != updates_.end();)
+    {
+        if (it->source == source)
+        {
+            it = updates_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    if (lastSource_ == source)
+    {
+        lastSource_ = nullptr;
+    }
+}
+
+void PriorityUpdateLoop::notify_update(PacketSource *source, unsigned code)
+{
+    AtomicHolder h(this);
+    for (const auto &u : updates_)
+    {
+        if (u.source == source && u.code == code)
+        {
+            // Will be generated from the freshest state anyway.
+            return;
+        }
+    }
+    updates_.push_back({source, code, os_get_time_monotonic()});
+}
+
+long long PriorityUpdateLoop::refresh_period_nsec(PacketSource *source)
+{
+    AtomicHolder h(this);
+    SourceEntry *e = find_source(source);
+    return e ? e->periodAvg : 0;
+}
+
+PriorityUpdateLoop::SourceEntry *PriorityUpdateLoop::find_source(
+    PacketSource *source)
+{
+    for (auto &e : sources_)
+    {
+        if (e.source == source)
+        {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+PriorityUpdateLoop::SourceEntry *PriorityUpdateLoop::pick_refresh(
+    long long now, unsigned *code)
+{
+    SourceEntry *best = nullptr;
+    float best_score = -1;
+    for (auto &e : sources_)
+    {
+        if (e.source == lastSource_)
+        {
+            continue;
+        }
+        // Staleness relative to the class period.
+        float weight = e.priority + 1;
+        float speed_score = (now - e.lastSpeed) * weight / speedPeriod_;
+        float refresh_score = (now - e.lastRefresh) * weight / refreshPeriod_;
+        if (speed_score > best_score)
+        {
+            best = &e;
+            best_score = speed_score;
+            *code = SPEED;
+        }
+        if (refresh_score > best_score)
+        {
+            best = &e;
+            best_score = refresh_score;
+            *code = REFRESH;
+        }
+    }
+    return best;
+}
+
+void PriorityUpdateLoop::speed_sent(SourceEntry *e, long long now)
+{
+    if (e->speedSent)
+    {
+        long long period = now - e->lastSpeed;
+        if (e->periodAvg)
+        {
+            e->periodAvg += (period - e->periodAvg) / 8;
+        }
+        else
+        {
+            e->periodAvg = period;
+        }
+    }
+    e->lastSpeed = now;
+    e->speedSent = true;
+}
+
+StateFlowBase::Action PriorityUpdateLoop::entry()
+{
+    long long now = os_get_time_monotonic();
+    PacketSource *source = nullptr;
+    unsigned code = REFRESH;
+    bool is_refresh = false;
+    {
+        AtomicHolder h(this);
+        SourceEntry *exclusive = nullptr;
+        for (auto &e : sources_)
+        {
+            if (e.priority >= EXCLUSIVE_MIN_PRIORITY &&
+                (!exclusive || e.priority > exclusive->priority))
+            {
+                exclusive = &e;
+            }
+        }
+        if (exclusive)
+        {
+            source = exclusive->source;
+            for (auto it = updates_.begin(); it != updates_.end(); ++it)
+            {
+                if (it->source == source)
+                {
+                    code = it->code;
+                    updates_.erase(it);
+                    break;
+                }
+            }
+        }
+        else
+        {
+            for (auto it = updates_.begin(); it != updates_.end(); ++it)
+            {
+                if (it->source == lastSource_)
+                {
+                    // Gives the decoder time to process the previous packet.
+                    continue;
+                }
+                source = it->source;
+                code = it->code;
+                long long latency = now - it->time;
+                updates_.erase(it);
+                ++numUpdates_;
+                if (latencyAvg_)
+                {
+                    latencyAvg_ += (latency - latencyAvg_) / 8;
+                }
+                else
+                {
+                    latencyAvg_ = latency;
+                }
+                if (latency > latencyMax_)
+                {
+                    latencyMax_ = latency;
+                }
+                SourceEntry *e = find_source(source);
+                if (e && (code == SPEED || code == ESTOP))
+                {
+                    speed_sent(e, now);
+                }
+                break;
+            }
+            if (!source)
+            {
+                SourceEntry *e = pick_refresh(now, &code);
+                if (e)
+                {
+                    source = e->source;
+                    is_refresh = true;
+                    if (code == SPEED)
+                    {
+                        speed_sent(e, now);
+                    }
+                    else
+                    {
+                        e->lastRefresh = now;
+                    }
+                }
+            }
+        }
+        lastSource_ = source;
+    }
+    if (source)
+    {
+        source->get_next_packet(code, message()->data());
+        if (is_refresh)
+        {
+            // Sources repeat update packets; refresh packets need no repeat.
+            message()->data()->packet_header.rept_count = 0;
+        }
+    }
+    else
+    {
+        // Nothing to send that would not go to the same decoder as the
+        // previous packet.
+        message()->data()->set_dcc_idle();
+    }
+    // We pass on the filled packet to the track processor.
+    trackSend_->send(transfer_message());
+    return exit();
+}
+
+} // namespace dcc
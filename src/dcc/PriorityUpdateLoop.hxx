@@ -0,0 +1,208 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file PriorityUpdateLoop.hxx
+ *
+ * Control flow central to the command station: it schedules user updates
+ * ahead of the background refresh, and refreshes the stalest trains first.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#ifndef _DCC_PRIORITYUPDATELOOP_HXX_
+#define _DCC_PRIORITYUPDATELOOP_HXX_
+
+#include <deque>
+#include <vector>
+
+#include "dcc/UpdateLoop.hxx"
+#include "executor/StateFlow.hxx"
+
+namespace dcc
+{
+
+/// Implementation of a command station update loop that prioritizes.
+///
+/// - Every packet slot goes to the exclusive source (priority at least
+///   EXCLUSIVE_MIN_PRIORITY) with the highest priority, if there is one. This
+///   is how emergency stop and service mode programming take over the track.
+///
+/// - Otherwise, sources that called notify_update() are served first, in the
+///   order the notifications arrived, with the code they supplied. This means
+///   a throttle command goes out in the next packet slot instead of waiting
+///   for a full refresh cycle.
+///
+/// - Otherwise, the stalest refresh is sent. Each source has two refresh
+///   classes: the speed class (speed packets, which are refreshed with
+///   period speed_period) and the background class (the source's own refresh
+///   sequence, typically the function packets, refreshed with period
+///   refresh_period). The class whose age relative to its period is largest
+///   wins. The non-exclusive priority value makes a source age faster:
+///   priority p gets refreshed as if its periods were divided by p + 1.
+///
+/// Two packets to the same non-exclusive source are never scheduled
+/// back-to-back; an idle packet goes out if there is nothing else to send.
+///
+/// Usage is the same as for @ref SimpleUpdateLoop.
+class PriorityUpdateLoop : public StateFlow<Buffer<dcc::Packet>, QList<1>>,
+                           private UpdateLoopBase
+{
+public:
+    /// Constructor.
+    /// @param service defines the executor to run on.
+    /// @param track_send is where the filled packets will be sent.
+    /// @param speed_period is the desired refresh period of speed packets
+    /// for each source, in nanoseconds.
+    /// @param refresh_period is the desired period of background refresh
+    /// packets for each source, in nanoseconds.
+    PriorityUpdateLoop(Service *service, PacketFlowInterface *track_send,
+        long long speed_period = MSEC_TO_NSEC(250),
+        long long refresh_period = MSEC_TO_NSEC(1000));
+    ~PriorityUpdateLoop();
+
+    /// Adds a new refresh source to the background refresh packets.
+    /// @param source the packet source to add
+    /// @param priority see @ref UpdateLoopBase::add_refresh_source
+    /// @return false if there is an exclusive source with the same or higher
+    /// priority already.
+    bool add_refresh_source(
+        dcc::PacketSource *source, unsigned priority) override;
+
+    /// Deletes a packet refresh source, and drops its pending updates.
+    /// @param source the packet source to remove.
+    void remove_refresh_source(dcc::PacketSource *source) override;
+
+    /// Schedules an update packet from a source ahead of the refresh.
+    /// @param source the packet source that changed
+    /// @param code will be passed to source->get_next_packet.
+    void notify_update(PacketSource *source, unsigned code) override;
+
+    /// Entry to the state flow -- when a new packet needs to be sent.
+    Action entry() override;
+
+    /// @return the number of update packets that were sent since the last
+    /// clear_metrics().
+    unsigned num_updates()
+    {
+        return numUpdates_;
+    }
+
+    /// @return the moving average of the time between notify_update() and the
+    /// update packet being generated, in nanoseconds.
+    long long update_latency_avg_nsec()
+    {
+        return latencyAvg_;
+    }
+
+    /// @return the largest time between notify_update() and the update packet
+    /// being generated since the last clear_metrics(), in nanoseconds.
+    long long update_latency_max_nsec()
+    {
+        return latencyMax_;
+    }
+
+    /// @param source a registered packet source.
+    /// @return the moving average of the time between two speed packets to
+    /// this source in nanoseconds, or 0 if not known.
+    long long refresh_period_nsec(PacketSource *source);
+
+    /// Resets the update counter and latency statistics.
+    void clear_metrics()
+    {
+        AtomicHolder h(this);
+        numUpdates_ = 0;
+        latencyAvg_ = 0;
+        latencyMax_ = 0;
+    }
+
+private:
+    /// Per-source scheduling data.
+    struct SourceEntry
+    {
+        /// Packet source.
+        PacketSource *source;
+        /// Priority from add_refresh_source.
+        unsigned priority;
+        /// When we last sent a speed packet (OS monotonic time).
+        long long lastSpeed;
+        /// When we last sent a background refresh packet.
+        long long lastRefresh;
+        /// Moving average of the speed packet period.
+        long long periodAvg;
+        /// True if lastSpeed is the time of an actual speed packet.
+        bool speedSent;
+    };
+
+    /// A notification that was not served yet.
+    struct PendingUpdate
+    {
+        /// Packet source that called notify_update.
+        PacketSource *source;
+        /// Code to pass to the source.
+        unsigned code;
+        /// When the notification came (OS monotonic time).
+        long long time;
+    };
+
+    /// @return the entry of a source, or nullptr if not registered. Caller
+    /// must hold the lock. @param source the packet source to look up.
+    SourceEntry *find_source(PacketSource *source);
+
+    /// Picks the stalest refresh. Caller must hold the lock.
+    /// @param now current time
+    /// @param code will be set to the update code to use.
+    /// @return the entry to refresh, or nullptr if there is none (except for
+    /// the previous packet's source).
+    SourceEntry *pick_refresh(long long now, unsigned *code);
+
+    /// Records that a speed class packet was sent. Caller must hold the lock.
+    /// @param e the source's entry @param now current time
+    void speed_sent(SourceEntry *e, long long now);
+
+    /// Place where we forward the packets filled in.
+    PacketFlowInterface *trackSend_;
+    /// All registered packet sources.
+    std::vector<SourceEntry> sources_;
+    /// Notifications waiting to be sent.
+    std::deque<PendingUpdate> updates_;
+    /// Source of the previous packet.
+    PacketSource *lastSource_ {nullptr};
+    /// Refresh period of the speed class.
+    long long speedPeriod_;
+    /// Refresh period of the background class.
+    long long refreshPeriod_;
+    /// Number of update packets sent.
+    unsigned numUpdates_ {0};
+    /// Moving average of the update latency.
+    long long latencyAvg_ {0};
+    /// Maximum update latency.
+    long long latencyMax_ {0};
+};
+
+} // namespace dcc
+
+#endif // _DCC_PRIORITYUPDATELOOP_HXX_
@@ -34,6 +34,8 @@
 
 #include <string.h>
 
+#include <algorithm>
+
 #include "dcc/RailCom.hxx"
 
 namespace dcc {
@@ -79,6 +81,30 @@ const uint8_t railcom_decode[256] =
        INV,    INV,    INV,    INV,    INV,    INV,    INV,    INV,
 };
 
+/// Decodes the bytes of both railcom channels of a feedback.
+///
+/// @param fb the feedback to decode.
+/// @param decoded will be filled with the decoded value of the channel 1
+/// bytes followed by the channel 2 bytes.
+/// @return a bitmask with bit i set if decoded[i] is not a 6-bit data value
+/// (i.e. it is INV, ACK, NACK, BUSY or reserved).
+static uint32_t decode_feedback(const dcc::Feedback &fb, uint8_t decoded[8])
+{
+    uint32_t invalid = 0;
+    unsigned n = 0;
+    for (unsigned i = 0; i < fb.ch1Size; ++i, ++n)
+    {
+        decoded[n] = railcom_decode[fb.ch1Data[i]];
+        invalid |= (uint32_t)(decoded[n] >= 64) << n;
+    }
+    for (unsigned i = 0; i < fb.ch2Size; ++i, ++n)
+    {
+        decoded[n] = railcom_decode[fb.ch2Data[i]];
+        invalid |= (uint32_t)(decoded[n] >= 64) << n;
+    }
+    return invalid;
+}
+
 /// Helper function to parse a part of a railcom packet.
 ///
 /// @param fb_channel Which hardware channel did the railcom message arrive
@@ -86,49 +112,46 @@ const uint8_t railcom_decode[256] =
 /// for a multi-channel railcom decoder it's as many as the number of ports.
 /// @param railcom_channel 1 or 2 depending on which part of the cutout window
 /// the data is from.
-/// @param ptr raw railcom data read from the UART.
+/// @param decoded railcom data read from the UART, already decoded through
+/// the railcom_decode table.
+/// @param invalid bit i is set if decoded[i] is not a 6-bit data value.
 /// @param size how many bytes were read from the UART
 /// @param output where to put the decoded packets (or GARBAGE packets if
 /// decoding fails).
 ///
-void parse_internal(uint8_t fb_channel, uint8_t railcom_channel,
-    const uint8_t *ptr, unsigned size,
+static void parse_internal(uint8_t fb_channel, uint8_t railcom_channel,
+    const uint8_t *decoded, uint32_t invalid, unsigned size,
     std::vector<struct RailcomPacket> *output)
 {
-    if (!size)
-        return;
     for (unsigned ofs = 0; ofs < size; ++ofs)
     {
-        uint8_t decoded = railcom_decode[ptr[ofs]];
         uint8_t type = 0xff;
         uint32_t arg = 0;
-        if (decoded == RailcomDefs::ACK)
-        {
-            type = RailcomPacket::ACK;
-        }
-        else if (decoded == RailcomDefs::NACK)
-        {
-            type = RailcomPacket::NACK;
-        }
-        else if (decoded == RailcomDefs::BUSY)
-        {
-            type = RailcomPacket::BUSY;
-        }
-        else if (decoded >= 64)
-        {
-            output->emplace_back(
-                fb_channel, railcom_channel, RailcomPacket::GARBAGE, 0);
-            break;
-        }
-        if (type != 0xff)
+        if (invalid & (1u << ofs))
         {
+            switch (decoded[ofs])
+            {
+                case RailcomDefs::ACK:
+                    type = RailcomPacket::ACK;
+                    break;
+                case RailcomDefs::NACK:
+                    type = RailcomPacket::NACK;
+                    break;
+                case RailcomDefs::BUSY:
+                    type = RailcomPacket::BUSY;
+                    break;
+                default:
+                    output->emplace_back(
+                        fb_channel, railcom_channel, RailcomPacket::GARBAGE, 0);
+                    return;
+            }
             output->emplace_back(fb_channel, railcom_channel, type, 0);
             continue;
         }
         // Now: we have a packet.
-        uint8_t packet_id = decoded >> 2;
+        uint8_t packet_id = decoded[ofs] >> 2;
         uint8_t len = 2;
-        arg = decoded & 3;
+        arg = decoded[ofs] & 3;
         switch (packet_id)
         {
             case RMOB_ADRHIGH:
@@ -150,7 +173,7 @@ void parse_internal(uint8_t fb_channel, uint8_t railcom_channel,
                     // packet) with four NACK bytes, presumably to report that
                     // it is not actually giving back a 32-bit response but
                     // only an 8-bit response.
-                    && railcom_decode[ptr[2]] < 64)
+                    && !(invalid & (1u << 2)))
                 {
                     len = 6;
                 }
@@ -175,54 +198,77 @@ void parse_internal(uint8_t fb_channel, uint8_t railcom_channel,
                 fb_channel, railcom_channel, RailcomPacket::GARBAGE, 0);
             break;
         }
+        if (invalid & (((1u << len) - 1) << ofs))
+        {
+            type = RailcomPacket::GARBAGE;
+        }
         for (int i = 1; i < len; ++i, ++ofs)
         {
             arg <<= 6;
-            uint8_t decoded = railcom_decode[ptr[ofs + 1]];
-            if (decoded >= 64)
-            {
-                type = RailcomPacket::GARBAGE;
-            }
-            arg |= decoded;
+            arg |= decoded[ofs + 1];
         }
         output->emplace_back(fb_channel, railcom_channel, type, arg);
     }
 }
 
-void parse_railcom_data(
-    const dcc::Feedback &fb, std::vector<struct RailcomPacket> *output)
+/// Interprets one railcom feedback from already decoded data. Appends to the
+/// output.
+///
+/// @param fb the feedback (for the channel and sizes).
+/// @param decoded the channel 1 and channel 2 bytes, from decode_feedback.
+/// @param invalid validity mask from decode_feedback.
+/// @param output where to append the packets.
+static void parse_decoded(const dcc::Feedback &fb, const uint8_t *decoded,
+    uint32_t invalid, std::vector<struct RailcomPacket> *output)
 {
-    output->clear();
     if (fb.channel == 0xff)
         return; // Occupancy feedback information
-    if (fb.ch1Size == 1 && (railcom_decode[fb.ch1Data[0]] != RailcomDefs::INV) && fb.ch2Size >= 1)
+    if (fb.ch1Size == 1 && (decoded[0] != RailcomDefs::INV) && fb.ch2Size >= 1)
     {
         // Railcom channel 1 should have 0 or 2 bytes according to the standard.
         //
         // There is probably a mistake in the placement of the second window
         // (i.e., a timing problem in the decoder). Let's concatenate the two
         // channels and parse them together.
-        uint8_t data[8];
-        memcpy(data, fb.ch1Data, fb.ch1Size);
-        memcpy(data + fb.ch1Size, fb.ch2Data, fb.ch2Size);
-        parse_internal(fb.channel, 2, data, fb.ch1Size + fb.ch2Size, output);
+        parse_internal(
+            fb.channel, 2, decoded, invalid, fb.ch1Size + fb.ch2Size, output);
         return;
     }
-    for (bool ch1 : {true, false})
+    parse_internal(fb.channel, 1, decoded, invalid, fb.ch1Size, output);
+    parse_internal(fb.channel, 2, decoded + fb.ch1Size,
+        invalid >> fb.ch1Size, fb.ch2Size, output);
+}
+
+void parse_railcom_data(
+    const dcc::Feedback &fb, std::vector<struct RailcomPacket> *output)
+{
+    output->clear();
+    uint8_t decoded[8];
+    uint32_t invalid = decode_feedback(fb, decoded);
+    parse_decoded(fb, decoded, invalid, output);
+}
+
+void parse_railcom_data(const dcc::Feedback *fb, unsigned count,
+    std::vector<struct RailcomPacket> *output)
+{
+    output->clear();
+    // Decodes a block of channels before parsing any of them. The table
+    // lookups of different channels do not depend on each other, and the
+    // parser sees only the decoded bytes and one validity mask per channel.
+    static constexpr unsigned BLOCK = 16;
+    uint8_t decoded[BLOCK][8];
+    uint32_t invalid[BLOCK];
+    for (unsigned base = 0; base < count; base += BLOCK)
     {
-        uint8_t size;
-        const uint8_t *ptr;
-        if (ch1)
+        unsigned n = std::min(BLOCK, count - base);
+        for (unsigned i = 0; i < n; ++i)
         {
-            size = fb.ch1Size;
-            ptr = fb.ch1Data;
+            invalid[i] = decode_feedback(fb[base + i], decoded[i]);
         }
-        else
+        for (unsigned i = 0; i < n; ++i)
         {
-            size = fb.ch2Size;
-            ptr = fb.ch2Data;
+            parse_decoded(fb[base + i], decoded[i], invalid[i], output);
         }
-        parse_internal(fb.channel, ch1 ? 1 : 2, ptr, size, output);
     }
 }
 
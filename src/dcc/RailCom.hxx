@@ -166,6 +166,17 @@ struct RailcomPacket
 void parse_railcom_data(
     const dcc::Feedback &fb, std::vector<struct RailcomPacket> *output);
 
+/** Interprets the railcom feedback of several hardware channels at once,
+ * typically all channels of a multi-channel detector for one cutout. The
+ * output is the same as calling the single-feedback parse_railcom_data for
+ * each entry and concatenating the results, but the table lookups of all
+ * channels are done up front. Clears the output list before filling.
+ * @param fb array of feedbacks
+ * @param count number of entries in fb
+ * @param output will receive the decoded packets. */
+void parse_railcom_data(const dcc::Feedback *fb, unsigned count,
+    std::vector<struct RailcomPacket> *output);
+
 }  // namespace dcc
 
 #endif // _DCC_RAILCOM_HXX_
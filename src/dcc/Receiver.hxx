@@ -36,9 +36,15 @@
 #define _DCC_RECEIVER_HXX_
 
 #include <fcntl.h>
+#include <limits.h>
+#include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
+
+#include "dcc/packet.h"
 #include "executor/StateFlow.hxx"
+#include "utils/RingBuffer.hxx"
 
 #include "freertos/can_ioctl.h"
 #include "freertos_drivers/common/SimpleLog.hxx"
@@ -63,6 +69,7 @@ public:
         timings_[MM_PREAMBLE].set(tick_per_usec, 1000, -1);
         timings_[MM_SHORT].set(tick_per_usec, 20, 32);
         timings_[MM_LONG].set(tick_per_usec, 200, 216);
+        build_classifier();
     }
 
     /// Internal states of the decoding state machine.
@@ -98,35 +105,37 @@ public:
         debugLog_.add(value);
         debugLog_.add(parseState_);
 #endif
+        uint32_t cls = classify(value);
         switch (parseState_)
         {
             case DCC_PACKET_FINISHED:
             case MM_PACKET_FINISHED:
             case UNKNOWN:
             {
-                if (timings_[DCC_ONE].match(value))
+                if (cls & IS_DCC_ONE)
                 {
                     parseCount_ = 0;
                     parseState_ = DCC_PREAMBLE;
                     return;
                 }
-                if (timings_[MM_PREAMBLE].match(value))
+                if (cls & IS_MM_PREAMBLE)
                 {
                     parseCount_ = 1 << 2;
                     ofs_ = 0;
                     data_[ofs_] = 0;
                     parseState_ = MM_DATA;
+                    return;
                 }
                 break;
             }
             case DCC_PREAMBLE:
             {
-                if (timings_[DCC_ONE].match(value))
+                if (cls & IS_DCC_ONE)
                 {
                     parseCount_++;
                     return;
                 }
-                if (timings_[DCC_ZERO].match(value) && (parseCount_ >= 16))
+                if ((cls & IS_DCC_ZERO) && (parseCount_ >= 16))
                 {
                     parseState_ = DCC_END_OF_PREAMBLE;
                     return;
@@ -135,7 +144,7 @@ public:
             }
             case DCC_END_OF_PREAMBLE:
             {
-                if (timings_[DCC_ZERO].match(value))
+                if (cls & IS_DCC_ZERO)
                 {
                     parseState_ = DCC_DATA;
                     parseCount_ = 1 << 7;
@@ -147,12 +156,12 @@ public:
             }
             case DCC_DATA:
             {
-                if (timings_[DCC_ONE].match(value))
+                if (cls & IS_DCC_ONE)
                 {
                     parseState_ = DCC_DATA_ONE;
                     return;
                 }
-                if (timings_[DCC_ZERO].match(value))
+                if (cls & IS_DCC_ZERO)
                 {
                     parseState_ = DCC_DATA_ZERO;
                     return;
@@ -161,7 +170,7 @@ public:
             }
             case DCC_DATA_ONE:
             {
-                if (timings_[DCC_ONE].match(value))
+                if (cls & IS_DCC_ONE)
                 {
                     if (parseCount_)
                     {
@@ -182,7 +191,7 @@ public:
             }
             case DCC_DATA_ZERO:
             {
-                if (timings_[DCC_ZERO].match(value))
+                if (cls & IS_DCC_ZERO)
                 {
                     if (parseCount_)
                     {
@@ -219,12 +228,12 @@ public:
             }
             case MM_DATA:
             {
-                if (timings_[MM_LONG].match(value))
+                if (cls & IS_MM_LONG)
                 {
                     parseState_ = MM_ZERO;
                     return;
                 }
-                if (timings_[MM_SHORT].match(value))
+                if (cls & IS_MM_SHORT)
                 {
                     parseState_ = MM_ONE;
                     return;
@@ -233,7 +242,7 @@ public:
             }
             case MM_ZERO:
             {
-                if (timings_[MM_SHORT].match(value))
+                if (cls & IS_MM_SHORT)
                 {
                     // data_[ofs_] |= 0;
                     parseCount_ >>= 1;
@@ -258,7 +267,7 @@ public:
             }
             case MM_ONE:
             {
-                if (timings_[MM_LONG].match(value))
+                if (cls & IS_MM_LONG)
                 {
                     data_[ofs_] |= parseCount_;
                     parseCount_ >>= 1;
@@ -286,6 +295,56 @@ public:
         return;
     }
 
+    /// Call this function with a batch of captured polarity changes. This is
+    /// equivalent to calling process_data(uint32_t) for each value, and
+    /// copying out each finished packet.
+    /// @param values is an array of the number of clock cycles between
+    /// polarity changes.
+    /// @param count is the number of entries in values.
+    /// @param out will receive the finished DCC and Marklin-Motorola packets.
+    /// Packets that do not fit into the ring are dropped.
+    /// @return the number of packets that finished (including dropped ones).
+    unsigned process_data(
+        const uint32_t *values, size_t count, RingBuffer<DCCPacket> *out)
+    {
+        unsigned num_packets = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            process_data(values[i]);
+            // The finished states are left at the next polarity change, so
+            // each packet is seen exactly once.
+            if (parseState_ == DCC_PACKET_FINISHED ||
+                parseState_ == MM_PACKET_FINISHED)
+            {
+                DCCPacket pkt;
+                packet(&pkt);
+                out->put(&pkt, 1);
+                ++num_packets;
+            }
+        }
+        return num_packets;
+    }
+
+    /// Copies the finished packet. Only valid when state() is
+    /// DCC_PACKET_FINISHED or MM_PACKET_FINISHED.
+    /// @param pkt is filled with the payload; the DCC payload includes the
+    /// error check byte, therefore skip_ec is set.
+    void packet(DCCPacket *pkt)
+    {
+        pkt->header_raw_data = 0;
+        if (parseState_ == MM_PACKET_FINISHED)
+        {
+            pkt->packet_header.is_marklin = 1;
+        }
+        else
+        {
+            pkt->packet_header.skip_ec = 1;
+        }
+        pkt->dlc = packet_length();
+        memcpy(pkt->payload, data_, pkt->dlc);
+        pkt->feedback_key = 0;
+    }
+
     /// Returns true if we are close to the DCC cutout. This situation is
     /// recognized by having seen the first half of the end-of-packet one bit.
     bool before_dcc_cutout() {
@@ -328,7 +387,7 @@ private:
             }
             if (max_usec < 0)
             {
-                max_usec = UINT_MAX;
+                max_value = UINT_MAX;
             }
             else
             {
@@ -355,8 +414,71 @@ private:
         MM_LONG,
         MAX_TIMINGS
     };
+
+    /// Bit masks of the timing array entries, for the classifier output.
+    enum TimingMask
+    {
+        IS_DCC_ONE = 1 << DCC_ONE,
+        IS_DCC_ZERO = 1 << DCC_ZERO,
+        IS_MM_PREAMBLE = 1 << MM_PREAMBLE,
+        IS_MM_SHORT = 1 << MM_SHORT,
+        IS_MM_LONG = 1 << MM_LONG,
+    };
+
+    /// Number of boundaries between the timing classes (a start and an end
+    /// for each timing).
+    static constexpr unsigned MAX_BOUNDS = 2 * MAX_TIMINGS;
+
+    /// Fills in bounds_ and classes_ from timings_.
+    void build_classifier()
+    {
+        unsigned n = 0;
+        for (const auto &t : timings_)
+        {
+            bounds_[n++] = t.min_value;
+            bounds_[n++] =
+                t.max_value == UINT_MAX ? UINT_MAX : t.max_value + 1;
+        }
+        std::sort(bounds_, bounds_ + MAX_BOUNDS);
+        // Every value between two consecutive boundaries matches the same
+        // set of timings, so we evaluate the interval's lowest value.
+        for (unsigned i = 0; i <= MAX_BOUNDS; ++i)
+        {
+            uint32_t v = i ? bounds_[i - 1] : 0;
+            classes_[i] = 0;
+            for (unsigned t = 0; t < MAX_TIMINGS; ++t)
+            {
+                if (timings_[t].match(v))
+                {
+                    classes_[i] |= 1 << t;
+                }
+            }
+        }
+    }
+
+    /// Matches a timing against all entries of timings_ at once. There are
+    /// no data-dependent branches, which matters on the per-edge path.
+    /// @param value is the number of clock cycles since the last polarity
+    /// change.
+    /// @return a bitmask of TimingMask values.
+    uint32_t classify(uint32_t value) const
+    {
+        unsigned idx = 0;
+        for (unsigned i = 0; i < MAX_BOUNDS; ++i)
+        {
+            idx += value >= bounds_[i];
+        }
+        return classes_[idx];
+    }
+
     /// The various timings by the standards.
     Timing timings_[MAX_TIMINGS];
+    /// Sorted boundaries of the timing ranges (the first value inside, or
+    /// the first value after a range).
+    uint32_t bounds_[MAX_BOUNDS];
+    /// Which timings match for the values between bounds_[i - 1] and
+    /// bounds_[i]. Bitmask of TimingMask.
+    uint8_t classes_[MAX_BOUNDS + 1];
 #ifdef DCC_DECODER_DEBUG
     LogRing<uint16_t, 256> debugLog_;
 #endif
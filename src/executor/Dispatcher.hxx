@@ -35,10 +35,12 @@
 #ifndef _EXECUTOR_DISPATCHER_HXX_
 #define _EXECUTOR_DISPATCHER_HXX_
 
+#include <algorithm>
 #include <vector>
 
 #include "executor/Notifiable.hxx"
 #include "executor/StateFlow.hxx"
+#include "utils/FanoutPool.hxx"
 
 /**
    This class takes registrations of StateFlows for incoming messages. When a
@@ -46,6 +48,13 @@
    invoked.
 
    Handlers are called in no particular order.
+
+   By default the dispatcher checks every registered handler for every
+   message. In indexed mode the handlers are bucketed by a hash of the bits
+   selected by the most commonly registered mask (typically the exact match
+   mask), and only the matching bucket and the handlers with other masks are
+   checked. The index is rebuilt lazily at the next message after a handler
+   is registered or unregistered.
  */
 template <int NUM_PRIO>
 class DispatchFlowBase : public UntypedStateFlow<QList<NUM_PRIO>>
@@ -138,6 +147,15 @@ protected:
     /// State when the entire iteration is done.  @return next action
     STATE_FLOW_STATE(iteration_done);
 
+    /// Turns on or off indexed dispatch. @param enabled true to use the
+    /// index.
+    void set_indexed(bool enabled)
+    {
+        OSMutexLock h(&lock_);
+        indexed_ = enabled;
+        indexDirty_ = true;
+    }
+
 private:
     /// true if this flow should negate the match condition.
     bool negateMatch_;
@@ -172,15 +190,68 @@ private:
         }
     };
 
+    /// Recomputes the index from handlers_. Must be called with lock_ held.
+    void rebuild_index();
+
+    /// @param id the message ID.
+    /// @return the bucket of the index where the handlers for id are.
+    unsigned index_bucket(ID id)
+    {
+        return ((id & indexMask_) * 0x9E3779B1U) >> indexShift_;
+    }
+
+    /// Fills candidates_ with the handler positions that may match the
+    /// current message. Must be called with lock_ held. @param id message ID.
+    void collect_candidates(ID id);
+
+    /// @return how many handlers to look at for the current message.
+    size_t num_candidates()
+    {
+        return useCandidates_ ? candidates_.size() : handlers_.size();
+    }
+
+    /// @param i between 0 and num_candidates() - 1.
+    /// @return the position in handlers_ of the i-th handler to look at,
+    /// which may be out of range if the handlers were changed meanwhile.
+    size_t candidate(size_t i)
+    {
+        return useCandidates_ ? candidates_[i] : i;
+    }
+
     /// Registered handlers.
     vector<HandlerInfo> handlers_;
 
-    /// Index of the next handler to look at.
+    /// Index of the next handler to look at. In indexed mode this is an
+    /// index into candidates_.
     size_t currentIndex_;
 
+    /// Handler positions for each bucket of the index, grouped by bucket.
+    vector<unsigned> indexEntries_;
+    /// Bucket b of the index is indexEntries_[indexStart_[b] ..
+    /// indexStart_[b+1] - 1].
+    vector<unsigned> indexStart_;
+    /// Positions of the handlers that are not in the index (because their
+    /// mask does not cover indexMask_).
+    vector<unsigned> residual_;
+    /// Positions of the handlers to look at for the current message.
+    vector<unsigned> candidates_;
+    /// Which bits of the ID the index is keyed by.
+    ID indexMask_;
+    /// Shift to get the bucket number from the hash product.
+    uint8_t indexShift_;
+    /// true if the indexed dispatch mode is on.
+    bool indexed_;
+    /// true if the index needs to be rebuilt before the next message.
+    bool indexDirty_;
+    /// true if the current message is iterating over candidates_.
+    bool useCandidates_;
+
 protected:
     /// If non-NULL we still need to call this handler.
     UntypedHandler *lastHandlerToCall_;
+    /// If true, copies of the message for handlers using the main buffer pool
+    /// are taken from fanout blocks, without yielding to the executor.
+    bool inlineFanout_;
 private:
     /// Protects handler add / remove against iteration.
     OSMutex lock_;
@@ -210,6 +281,12 @@ public:
     DispatchFlow(Service *service)
         :  Base(service) {}
 
+    ~DispatchFlow() {
+        if (fanout_) {
+            fanout_->release();
+        }
+    }
+
     /// Imports types and functions to allow less typing for the implementation.
     typedef StateFlowBase::Action Action;
     using StateFlowBase::call_immediately;
@@ -260,6 +337,44 @@ public:
         Base::unregister_handler_all(handler);
     }
 
+    /// Selects how copies of a message are made when multiple handlers match
+    /// it. By default each copy is allocated asynchronously from the target
+    /// handler's pool, which costs a pool allocation and an executor
+    /// round-trip per handler. With inline fan-out, copies for handlers that
+    /// use the main buffer pool are carved out of a FanoutPool block that has
+    /// room for one copy per registered handler, and are sent in a single
+    /// step. This makes one allocation per message instead of one per
+    /// handler. A copy that a handler holds on to keeps its block allocated.
+    /// Handlers with their own pool (for example for flow control) are still
+    /// served asynchronously.
+    ///
+    /// @param enabled true to turn on inline fan-out.
+    void set_inline_fanout(bool enabled) {
+        this->inlineFanout_ = enabled;
+    }
+
+    /// Selects how the matching handlers are found. By default every
+    /// registered handler is checked for every message. With indexed dispatch
+    /// the handlers are bucketed by their ID under the most common mask, so
+    /// that the per-message cost does not grow with the number of handlers
+    /// registered with that mask. Handlers are called in a different order.
+    ///
+    /// @param enabled true to turn on indexed dispatch.
+    void set_indexed_dispatch(bool enabled) {
+        Base::set_indexed(enabled);
+    }
+
+    /// @return how many copies of messages were made for handlers.
+    size_t num_copies() {
+        return numCopies_;
+    }
+
+    /// @return how many allocations were made for the copies of messages:
+    /// one per copy from a pool, one per fanout block.
+    size_t num_copy_allocations() {
+        return numCopyAllocations_;
+    }
+
 protected:
     /// @return the identifier bits of the current message.
     typename Base::ID get_message_id() OVERRIDE {
@@ -273,9 +388,37 @@ protected:
             return call_immediately(STATE(clone_done));
         }
         HandlerType* h = static_cast<HandlerType *>(this->lastHandlerToCall_);
+        if (this->inlineFanout_ && h->pool() == mainBufferPool) {
+            if (!fanout_ || fanout_->full()) {
+                // The new block is created before the old one is released,
+                // so that they never share an address.
+                FanoutPool *old = fanout_;
+                fanout_ =
+                    FanoutPool::create(sizeof(MessageType), this->size());
+                ++numCopyAllocations_;
+                if (old) {
+                    old->release();
+                }
+            }
+            MessageType *copy;
+            fanout_->alloc(&copy);
+            send_copy(h, copy);
+            return call_immediately(STATE(clone_done));
+        }
+        ++numCopyAllocations_;
         return allocate_and_call(h, STATE(clone));
     }
 
+    /// Fills in a copy of the current message and sends it to a handler.
+    /// @param h is the handler to send to.
+    /// @param copy is a freshly allocated buffer. Ownership is transferred.
+    void send_copy(HandlerType *h, MessageType *copy) {
+        ++numCopies_;
+        copy->set_done(this->message()->new_child());
+        *copy->data() = *this->message()->data();
+        h->send(copy);
+    }
+
     /// Takes the allocated new buffer, copies the message into it and sends
     /// off to the clone target. @return next action.
     Action clone() {
@@ -286,10 +429,7 @@ protected:
             if (b) this->get_allocation_result(h)->unref();
             return call_immediately(STATE(clone_done));
         }
-        MessageType *copy = this->get_allocation_result(h);
-        copy->set_done(this->message()->new_child());
-        *copy->data() = *this->message()->data();
-        h->send(copy);
+        send_copy(h, this->get_allocation_result(h));
         return call_immediately(STATE(clone_done));
     }
 
@@ -299,6 +439,15 @@ protected:
         HandlerType* h = static_cast<HandlerType *>(this->lastHandlerToCall_);
         h->send(this->transfer_message());
     }
+
+private:
+    /// Block that the inline fan-out copies are allocated from. Shared by
+    /// consecutive messages until it is full.
+    FanoutPool *fanout_ {nullptr};
+    /// Statistics: number of copies made.
+    size_t numCopies_ {0};
+    /// Statistics: number of allocations made for copies.
+    size_t numCopyAllocations_ {0};
 };
 
 
@@ -308,7 +457,13 @@ template <int NUM_PRIO>
 DispatchFlowBase<NUM_PRIO>::DispatchFlowBase(Service *service)
     : UntypedStateFlow<QList<NUM_PRIO>>(service)
     , negateMatch_(false)
+    , indexMask_(0)
+    , indexShift_(31)
+    , indexed_(false)
+    , indexDirty_(true)
+    , useCandidates_(false)
     , lastHandlerToCall_(nullptr)
+    , inlineFanout_(false)
 {
 }
 
@@ -350,6 +505,7 @@ void DispatchFlowBase<NUM_PRIO>::register_handler(UntypedHandler *handler,
     handlers_[idx].handler = handler;
     handlers_[idx].id = id;
     handlers_[idx].mask = mask;
+    indexDirty_ = true;
 }
 
 template<int NUM_PRIO>
@@ -375,6 +531,7 @@ DispatchFlowBase<NUM_PRIO>::unregister_handler(UntypedHandler *handler,
     {
         handlers_.resize(handlers_.size() - 1);
     }
+    indexDirty_ = true;
 }
 
 template<int NUM_PRIO>
@@ -393,6 +550,101 @@ void DispatchFlowBase<NUM_PRIO>::unregister_handler_all(
     {
         handlers_.pop_back();
     }
+    indexDirty_ = true;
+}
+
+template<int NUM_PRIO>
+void DispatchFlowBase<NUM_PRIO>::rebuild_index()
+{
+    indexDirty_ = false;
+    indexEntries_.clear();
+    indexStart_.clear();
+    residual_.clear();
+    // Finds the most common nonzero mask; ties go to the mask with more bits.
+    vector<ID> masks;
+    for (auto &h : handlers_)
+    {
+        if (h.handler && h.mask)
+        {
+            masks.push_back(h.mask);
+        }
+    }
+    std::sort(masks.begin(), masks.end());
+    indexMask_ = 0;
+    unsigned best_count = 0;
+    for (size_t i = 0; i < masks.size();)
+    {
+        size_t j = i;
+        while (j < masks.size() && masks[j] == masks[i])
+        {
+            ++j;
+        }
+        unsigned count = j - i;
+        if (count > best_count ||
+            (count == best_count &&
+                __builtin_popcount(masks[i]) > __builtin_popcount(indexMask_)))
+        {
+            best_count = count;
+            indexMask_ = masks[i];
+        }
+        i = j;
+    }
+    // A handler can be indexed if it is only called for messages that have
+    // the same bits under indexMask_ as the handler's id.
+    unsigned bits = 1;
+    while ((1u << bits) < best_count)
+    {
+        ++bits;
+    }
+    indexShift_ = 32 - bits;
+    indexStart_.resize((1u << bits) + 1);
+    for (unsigned i = 0; i < handlers_.size(); ++i)
+    {
+        auto &h = handlers_[i];
+        if (!h.handler)
+        {
+            continue;
+        }
+        if (!indexMask_ || (h.mask & indexMask_) != indexMask_)
+        {
+            residual_.push_back(i);
+            continue;
+        }
+        ++indexStart_[index_bucket(h.id) + 1];
+    }
+    // Counting sort of the handlers by bucket.
+    for (unsigned b = 1; b < indexStart_.size(); ++b)
+    {
+        indexStart_[b] += indexStart_[b - 1];
+    }
+    indexEntries_.resize(indexStart_.back());
+    vector<unsigned> fill(indexStart_.begin(), indexStart_.end() - 1);
+    for (unsigned i = 0; i < handlers_.size(); ++i)
+    {
+        auto &h = handlers_[i];
+        if (h.handler && indexMask_ && (h.mask & indexMask_) == indexMask_)
+        {
+            indexEntries_[fill[index_bucket(h.id)]++] = i;
+        }
+    }
+}
+
+template<int NUM_PRIO>
+void DispatchFlowBase<NUM_PRIO>::collect_candidates(ID id)
+{
+    candidates_.clear();
+    if (indexDirty_)
+    {
+        rebuild_index();
+    }
+    if (indexMask_)
+    {
+        unsigned b = index_bucket(id);
+        candidates_.insert(candidates_.end(),
+            indexEntries_.begin() + indexStart_[b],
+            indexEntries_.begin() + indexStart_[b + 1]);
+    }
+    candidates_.insert(candidates_.end(), residual_.begin(), residual_.end());
 }
 
 template<int NUM_PRIO>
@@ -400,6 +652,12 @@ StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::entry()
 {
     currentIndex_ = 0;
     lastHandlerToCall_ = nullptr;
+    useCandidates_ = indexed_ && !negateMatch_;
+    if (useCandidates_)
+    {
+        OSMutexLock l(&lock_);
+        collect_candidates(get_message_id());
+    }
     return call_immediately(STATE(iterate));
 }
 
@@ -411,9 +669,15 @@ StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::iterate()
         // @todo(balazs.racz) make the registered handlers structure for the
         // dispatcher lock-free. This mutex here is very expensive.
         OSMutexLock l(&lock_);
-        for (; currentIndex_ < handlers_.size(); ++currentIndex_)
+        for (; currentIndex_ < num_candidates(); ++currentIndex_)
         {
-            auto &h = handlers_[currentIndex_];
+            size_t idx = candidate(currentIndex_);
+            if (idx >= handlers_.size())
+            {
+                // Got unregistered after the candidates were collected.
+                continue;
+            }
+            auto &h = handlers_[idx];
             if (!h.handler)
             {
                 continue;
@@ -430,13 +694,13 @@ StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::iterate()
             if (!lastHandlerToCall_)
             {
                 // This was the first we found.
-                lastHandlerToCall_ = handlers_[currentIndex_].handler;
+                lastHandlerToCall_ = h.handler;
                 continue;
             }            
             break;
         }
     }
-    if (currentIndex_ >= handlers_.size())
+    if (currentIndex_ >= num_candidates())
     {
         return iteration_done();
     }
@@ -448,7 +712,9 @@ StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::iterate()
 template<int NUM_PRIO>
 StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::clone_done()
 {
-    lastHandlerToCall_ = handlers_[currentIndex_].handler;
+    size_t idx = candidate(currentIndex_);
+    lastHandlerToCall_ =
+        idx < handlers_.size() ? handlers_[idx].handler : nullptr;
     ++currentIndex_;
     return call_immediately(STATE(iterate));
 }
@@ -38,6 +38,7 @@
 #include "executor/Executor.hxx"
 
 #include <unistd.h>
+#include <string.h>
 
 #ifdef __WINNT__
 #include <winsock2.h>
@@ -49,6 +50,10 @@
 #include <emscripten.h>
 #endif
 
+#if OPENMRN_HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #ifdef ESP_NONOS
 extern "C" {
 #include <ets_sys.h>
@@ -76,10 +81,15 @@ ExecutorBase::ExecutorBase()
     , started_(0)
     , selectPrescaler_(0)
 {
+#if OPENMRN_HAVE_EPOLL
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    HASSERT(epollFd_ >= 0);
+#else
     FD_ZERO(&selectRead_);
     FD_ZERO(&selectWrite_);
     FD_ZERO(&selectExcept_);
     selectNFds_ = 0;
+#endif
 }
 
 /** Lookup an executor by its name.
@@ -328,6 +338,164 @@ void *ExecutorBase::entry()
     return NULL;
 }
 
+#if OPENMRN_HAVE_EPOLL
+
+Selectable *&ExecutorBase::epoll_slot(Selectable *job)
+{
+    unsigned fd = job->fd_;
+    HASSERT(job->type() >= Selectable::READ &&
+        job->type() <= Selectable::EXCEPT);
+    if (fd >= epollEntries_.size())
+    {
+        epollEntries_.resize(fd + 1);
+    }
+    return epollEntries_[fd].jobs[job->type() - 1];
+}
+
+void ExecutorBase::epoll_update(int fd)
+{
+    EpollEntry &e = epollEntries_[fd];
+    struct epoll_event ev;
+    // One-shot: the fd is disarmed after it triggered, until the next
+    // select() call re-arms it. This matches the select() semantics where the
+    // Selectable is removed when it is triggered.
+    ev.events = EPOLLONESHOT;
+    ev.data.fd = fd;
+    if (e.jobs[Selectable::READ - 1])
+    {
+        ev.events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (e.jobs[Selectable::WRITE - 1])
+    {
+        ev.events |= EPOLLOUT;
+    }
+    if (e.jobs[Selectable::EXCEPT - 1])
+    {
+        ev.events |= EPOLLPRI;
+    }
+    if (ev.events == EPOLLONESHOT)
+    {
+        if (e.registered)
+        {
+            // Fails if the fd was closed in the meantime; that's okay.
+            ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, &ev);
+            e.registered = false;
+        }
+        return;
+    }
+    if (e.registered)
+    {
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &ev) == 0)
+        {
+            return;
+        }
+        // The kernel drops closed fds from the epoll set. If the fd number
+        // was reused since, we need to add it again.
+        e.registered = false;
+    }
+    if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) == 0)
+    {
+        e.registered = true;
+        return;
+    }
+    // Typically EBADF. ::select would have returned the fd as ready; wakes
+    // up the waiting jobs so that they see the error in their next syscall.
+    LOG(WARNING, "Executor: cannot watch fd %d: %s", fd, strerror(errno));
+    for (unsigned i = 0; i < ARRAYSIZE(e.jobs); ++i)
+    {
+        if (e.jobs[i])
+        {
+            add(e.jobs[i]->wakeup_, e.jobs[i]->priority_);
+            e.jobs[i] = nullptr;
+        }
+    }
+}
+
+void ExecutorBase::select(Selectable *job)
+{
+    Selectable *&slot = epoll_slot(job);
+    if (slot)
+    {
+        LOG(FATAL,
+            "Multiple Selectables are waiting for the same fd %d type %u",
+            job->fd_, job->selectType_);
+    }
+    slot = job;
+    epoll_update(job->fd_);
+}
+
+bool ExecutorBase::is_selected(Selectable *job)
+{
+    if (job->fd_ >= epollEntries_.size())
+    {
+        return false;
+    }
+    return epoll_slot(job) == job;
+}
+
+void ExecutorBase::unselect(Selectable *job)
+{
+    Selectable *&slot = epoll_slot(job);
+    if (slot != job)
+    {
+        LOG(FATAL, "Tried to remove a non-active selectable: fd %d type %u",
+            job->fd_, job->selectType_);
+    }
+    slot = nullptr;
+    epoll_update(job->fd_);
+}
+
+void ExecutorBase::wait_with_select(long long wait_length)
+{
+    if (!empty())
+    {
+        wait_length = 0;
+    }
+    long long max_sleep = MSEC_TO_NSEC(config_executor_max_sleep_msec());
+    if (wait_length > max_sleep)
+    {
+        wait_length = max_sleep;
+    }
+    struct epoll_event events[32];
+    int ret = selectHelper_.epoll_wait(
+        epollFd_, events, ARRAYSIZE(events), wait_length);
+    for (int i = 0; i < ret; ++i)
+    {
+        int fd = events[i].data.fd;
+        uint32_t ev = events[i].events;
+        EpollEntry &e = epollEntries_[fd];
+        // Which conditions trigger each select type. Errors and hangups
+        // wake up everyone, like ::select does for read and write.
+        static const uint32_t trigger[3] = {EPOLLIN | EPOLLRDHUP, EPOLLOUT,
+            EPOLLPRI};
+        bool rearm = false;
+        for (unsigned t = 0; t < ARRAYSIZE(e.jobs); ++t)
+        {
+            Selectable *job = e.jobs[t];
+            if (!job)
+            {
+                continue;
+            }
+            if (ev & (trigger[t] | EPOLLERR | EPOLLHUP))
+            {
+                add(job->wakeup_, job->priority_);
+                e.jobs[t] = nullptr;
+            }
+            else
+            {
+                rearm = true;
+            }
+        }
+        if (rearm)
+        {
+            // Another job is still waiting for this fd.
+            epoll_update(fd);
+        }
+    }
+}
+
+#else
+
 void ExecutorBase::select(Selectable *job)
 {
     fd_set *s = get_select_set(job->type());
@@ -418,6 +586,8 @@ void ExecutorBase::wait_with_select(long long wait_length)
     selectNFds_ = max_fd;
 }
 
+#endif // OPENMRN_HAVE_EPOLL
+
 #endif
 
 #if defined(ARDUINO)
@@ -447,4 +617,7 @@ ExecutorBase::~ExecutorBase()
     {
         shutdown();
     }
+#if OPENMRN_HAVE_EPOLL
+    ::close(epollFd_);
+#endif
 }
@@ -38,6 +38,7 @@
 
 #include <functional>
 #include <atomic>
+#include <vector>
 
 #include "executor/Executable.hxx"
 #include "executor/Notifiable.hxx"
@@ -192,6 +193,29 @@ private:
      * @param next_timer_nsec is the maximum time to sleep in nanoseconds. */
     void wait_with_select(long long next_timer_nsec);
 
+#if OPENMRN_HAVE_EPOLL
+    /// The Selectables waiting for a given fd, one for each SelectType.
+    struct EpollEntry
+    {
+        /// Waiting jobs, indexed by SelectType - 1.
+        Selectable *jobs[3] = {nullptr, nullptr, nullptr};
+        /// true if the fd was added to the epoll set.
+        bool registered = false;
+    };
+
+    /// @param job is a Selectable with a valid type and fd.
+    /// @return the slot where job is stored while it is selected.
+    Selectable *&epoll_slot(Selectable *job);
+
+    /// Tells the kernel which events we are waiting for on a given fd.
+    /// @param fd is the file descriptor whose jobs changed.
+    void epoll_update(int fd);
+
+    /// File descriptor of the epoll instance.
+    int epollFd_;
+    /// Indexed by fd. Grows as needed.
+    std::vector<EpollEntry> epollEntries_;
+#else
     /// Helper function.
     ///
     /// @param type a select type: READ, WRITE or EXCEPT
@@ -209,6 +233,7 @@ private:
         LOG(FATAL, "Unexpected select type %d", type);
         return nullptr;
     }
+#endif
 
     /** name of this Executor */
     const char *name_;
@@ -219,6 +244,7 @@ private:
     /** List of active timers. */
     ActiveTimers activeTimers_;
 
+#if !OPENMRN_HAVE_EPOLL
     /** fd to select for read. */
     fd_set selectRead_;
     /** fd to select for write. */
@@ -229,6 +255,7 @@ private:
     int selectNFds_;
     /** Head of the linked list for the select calls. */
     TypedQueue<Selectable> selectables_;
+#endif
 
     /** Set to 1 when the executor thread has exited and it is safe to delete
      * *this. */
@@ -94,6 +94,17 @@ StateFlowBase::Action StateFlowWithQueue::wait_for_message()
     }
 }
 
+BufferBase *StateFlowWithQueue::take_queued_message(unsigned *priority)
+{
+    AtomicHolder h(this);
+    BufferBase *m = static_cast<BufferBase *>(queue_next(priority));
+    if (m && queueSize_)
+    {
+        queueSize_--;
+    }
+    return m;
+}
+
 void StateFlowBase::notify()
 {
     service()->executor()->add(this);
@@ -1063,6 +1063,15 @@ protected:
         currentPriority_ = std::min(priority, MAX_PRIORITY_);
     }
 
+    /** Takes the next message from the queue without finishing the current
+     * one. Allows flows to process multiple queued messages in one go. The
+     * caller takes ownership of the returned message.
+     *
+     * @param priority will be set to the priority of the message taken.
+     * @return the next message from the queue, or nullptr if the queue is
+     * empty. */
+    BufferBase *take_queued_message(unsigned *priority);
+
     /** Call this from the constructor of the child class to do some work
      * before the main queue processing loop begins. When the initialization
      * states are done, call 'return exit()' to start the main loop.
@@ -33,6 +33,9 @@
  */
 
 #include "executor/Timer.hxx"
+
+#include <algorithm>
+
 #include "executor/Executor.hxx"
 #include "os/os.h"
 
@@ -62,6 +65,8 @@ void Timer::run()
     }
 }
 
+constexpr unsigned ActiveTimers::NUM_LATE_BUCKETS;
+
 ActiveTimers::~ActiveTimers()
 {
 }
@@ -81,6 +86,196 @@ void ActiveTimers::run()
     // call.
 }
 
+void ActiveTimers::get_stats(Stats *stats)
+{
+    OSMutexLock l(&lock_);
+    *stats = stats_;
+}
+
+void ActiveTimers::count_fired_locked(Timer *timer, long long now)
+{
+    --stats_.numActive;
+    ++stats_.numFired;
+    if (timer->isCancelled_)
+    {
+        // Triggered timers have a fake expiration time.
+        return;
+    }
+    long long late = now - timer->when_;
+    long long limit = USEC_TO_NSEC(100);
+    unsigned bucket = 0;
+    while (bucket < NUM_LATE_BUCKETS - 1 && late >= limit)
+    {
+        ++bucket;
+        limit *= 10;
+    }
+    ++stats_.lateHistogram[bucket];
+}
+
+void ActiveTimers::update_timer(Timer *timer)
+{
+    HASSERT(timer);
+    OSMutexLock l(&lock_);
+    remove_locked(timer);
+    insert_locked(timer);
+}
+
+void ActiveTimers::remove_timer(Timer *timer)
+{
+    HASSERT(timer);
+    OSMutexLock l(&lock_);
+    remove_locked(timer);
+    timer->isActive_ = 0;
+}
+
+void ActiveTimers::schedule_timer(Timer *timer)
+{
+    OSMutexLock l(&lock_);
+    insert_locked(timer);
+}
+
+#if OPENMRN_FEATURE_TIMER_HEAP
+
+long long ActiveTimers::get_next_timeout()
+{
+    OSMutexLock l(&lock_);
+
+    long long now = OSTime::get_monotonic();
+    bool found_timer = false;
+    while (!heap_.empty() && heap_[0].when <= now)
+    {
+        found_timer = true;
+        Timer *current_timer = heap_[0].timer;
+        heap_erase(0);
+        count_fired_locked(current_timer, now);
+
+        current_timer->isActive_ = 0;
+        current_timer->isExpired_ = 1;
+        // Puts it on the executor.
+        executor_->add(current_timer, current_timer->priority_);
+    }
+
+    if (found_timer)
+    {
+        return 0;
+    }
+    else if (!heap_.empty())
+    {
+        return heap_[0].when - now;
+    }
+    else
+    {
+        // Wakes up the timer service every now and then. It won't make any
+        // difference.
+        return SEC_TO_NSEC(3600);
+    }
+}
+
+bool ActiveTimers::empty()
+{
+    OSMutexLock l(&lock_);
+    return heap_.empty();
+}
+
+void ActiveTimers::insert_locked(Timer *timer)
+{
+    HASSERT(timer);
+    HASSERT(timer->next == nullptr);
+
+    HeapEntry e{timer->when_, nextSeq_++, timer};
+    heap_.emplace_back();
+    heap_sift_up(heap_.size() - 1, e);
+    ++stats_.numScheduled;
+    if (++stats_.numActive > stats_.maxActive)
+    {
+        stats_.maxActive = stats_.numActive;
+    }
+
+    // This will wake up the executor, which will schedule all expired timers
+    // and recompute sleep length.
+    notify();
+}
+
+void ActiveTimers::remove_locked(Timer *timer)
+{
+    HASSERT(timer);
+    unsigned pos = timer->heapIndex_;
+    HASSERT(pos < heap_.size() && heap_[pos].timer == timer);
+    heap_erase(pos);
+    --stats_.numActive;
+}
+
+void ActiveTimers::heap_set(unsigned pos, const HeapEntry &e)
+{
+    heap_[pos] = e;
+    e.timer->heapIndex_ = pos;
+}
+
+void ActiveTimers::heap_sift_up(unsigned pos, const HeapEntry &e)
+{
+    while (pos > 0)
+    {
+        unsigned parent = (pos - 1) / 4;
+        if (!(e < heap_[parent]))
+        {
+            break;
+        }
+        heap_set(pos, heap_[parent]);
+        pos = parent;
+    }
+    heap_set(pos, e);
+}
+
+void ActiveTimers::heap_sift_down(unsigned pos, const HeapEntry &e)
+{
+    unsigned size = heap_.size();
+    while (true)
+    {
+        unsigned first = pos * 4 + 1;
+        if (first >= size)
+        {
+            break;
+        }
+        unsigned last = std::min(first + 4, size);
+        unsigned best = first;
+        for (unsigned c = first + 1; c < last; ++c)
+        {
+            if (heap_[c] < heap_[best])
+            {
+                best = c;
+            }
+        }
+        if (!(heap_[best] < e))
+        {
+            break;
+        }
+        heap_set(pos, heap_[best]);
+        pos = best;
+    }
+    heap_set(pos, e);
+}
+
+void ActiveTimers::heap_erase(unsigned pos)
+{
+    HeapEntry last = heap_.back();
+    heap_.pop_back();
+    if (pos == heap_.size())
+    {
+        // Was the last one.
+        return;
+    }
+    if (pos > 0 && last < heap_[(pos - 1) / 4])
+    {
+        heap_sift_up(pos, last);
+    }
+    else
+    {
+        heap_sift_down(pos, last);
+    }
+}
+
+#else
+
 long long ActiveTimers::get_next_timeout()
 {
     OSMutexLock l(&lock_);
@@ -95,6 +290,7 @@ long long ActiveTimers::get_next_timeout()
         found_timer = true;
         *last = current_timer->next;
         current_timer->next = nullptr;
+        count_fired_locked(current_timer, now);
 
         current_timer->isActive_ = 0;
         current_timer->isExpired_ = 1;
@@ -129,12 +325,6 @@ bool ActiveTimers::empty() {
     return (current_timer == nullptr);
 }
 
-void ActiveTimers::schedule_timer(Timer *timer)
-{
-    OSMutexLock l(&lock_);
-    insert_locked(timer);
-}
-
 void ActiveTimers::insert_locked(Timer *timer)
 {
     HASSERT(timer);
@@ -150,6 +340,11 @@ void ActiveTimers::insert_locked(Timer *timer)
     // Inserts into the queue.
     timer->next = current_timer;
     *last = timer;
+    ++stats_.numScheduled;
+    if (++stats_.numActive > stats_.maxActive)
+    {
+        stats_.maxActive = stats_.numActive;
+    }
 
     // This will wake up the executor, which will schedule all expired timers
     // and recompute sleep length.
@@ -168,20 +363,7 @@ void ActiveTimers::remove_locked(Timer *timer)
     HASSERT(*last == timer);
     *last = timer->next;
     timer->next = nullptr;
+    --stats_.numActive;
 }
 
-void ActiveTimers::update_timer(Timer *timer)
-{
-    HASSERT(timer);
-    OSMutexLock l(&lock_);
-    remove_locked(timer);
-    insert_locked(timer);
-}
-
-void ActiveTimers::remove_timer(Timer *timer)
-{
-    HASSERT(timer);
-    OSMutexLock l(&lock_);
-    remove_locked(timer);
-    timer->isActive_ = 0;
-}
+#endif // OPENMRN_FEATURE_TIMER_HEAP
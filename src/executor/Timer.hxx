@@ -35,6 +35,12 @@
 #ifndef _EXECUTOR_TIMER_HXX_
 #define _EXECUTOR_TIMER_HXX_
 
+#include "openmrn_features.h"
+
+#if OPENMRN_FEATURE_TIMER_HEAP
+#include <vector>
+#endif
+
 #include "executor/Notifiable.hxx"
 #include "utils/Buffer.hxx"
 #include "utils/QMember.hxx"
@@ -44,7 +50,12 @@ class Timer;
 class ExecutorBase;
 
 /** Class that manages the list of active timers. The Executor uses this class
- * tightly in its sleep-execute loop. */
+ * tightly in its sleep-execute loop.
+ *
+ * With OPENMRN_FEATURE_TIMER_HEAP the timers are kept in a 4-ary min-heap
+ * ordered by expiration time (and by scheduling order among equal times), so
+ * that scheduling, updating and removing a timer is O(log n). Otherwise they
+ * are in a sorted linked list, which does not need any dynamic memory. */
 class ActiveTimers : public Executable
 {
 public:
@@ -57,6 +68,29 @@ public:
     {
     }
 
+    /// Number of buckets in the late-fire histogram.
+    static constexpr unsigned NUM_LATE_BUCKETS = 5;
+
+    /// Diagnostic counters of the timers.
+    struct Stats
+    {
+        /// Number of timers currently scheduled.
+        unsigned numActive;
+        /// Largest number of timers that were scheduled at the same time.
+        unsigned maxActive;
+        /// How many times a timer was scheduled or rescheduled.
+        uint32_t numScheduled;
+        /// How many timers expired and were handed to the executor.
+        uint32_t numFired;
+        /// How late the expired timers were handed to the executor. Bucket i
+        /// counts the timers that were less than 100 usec * 10^i late; the
+        /// last bucket counts all the rest. Triggered timers are not counted.
+        uint32_t lateHistogram[NUM_LATE_BUCKETS];
+    };
+
+    /// Copies out the diagnostic counters. @param stats will be filled in.
+    void get_stats(Stats *stats);
+
     ~ActiveTimers();
 
     /** Tell when the first timer will expire. If there are no active timers,
@@ -75,17 +109,18 @@ public:
      * scheduled. */
     void schedule_timer(::Timer *timer);
 
-    /** Updates the expiration time of an already scheduled timer. This call is
-     * somewhat expensive, because it needs to walk the entire queue of active
-     * timers. May wake up the executor.
+    /** Updates the expiration time of an already scheduled timer. Without the
+     * timer heap this call is somewhat expensive, because it needs to walk the
+     * entire queue of active timers. May wake up the executor.
      *
      * @param timer is the timer whose next execution time has been updated. It
      * must already be scheduled. */
     void update_timer(::Timer *timer);
 
-    /** Deletes an already scheduled but not yet expired timer. This call is
-     * somewhat expensive, because it needs to walk the entire queue of active
-     * timers. Asserts that the timer is in fact not yet expired.
+    /** Deletes an already scheduled but not yet expired timer. Without the
+     * timer heap this call is somewhat expensive, because it needs to walk the
+     * entire queue of active timers. Asserts that the timer is in fact not yet
+     * expired.
      *
      * @param timer is the timer to delete. */
     void remove_timer(::Timer *timer);
@@ -113,12 +148,58 @@ private:
      * @param timer what to insert into the active list. */
     void insert_locked(::Timer *timer);
 
+    /** Updates the counters for a timer that is expired. Caller must hold the
+     * lock.
+     * @param timer the timer that is handed to the executor.
+     * @param now current time. */
+    void count_fired_locked(::Timer *timer, long long now);
+
     /// Parent.
     ExecutorBase *executor_;
     /// Protects the timer list.
     OSMutex lock_;
+#if OPENMRN_FEATURE_TIMER_HEAP
+    /// One element of the heap. Keeps a copy of the sorting key, so that
+    /// sifting does not need to touch the timers.
+    struct HeapEntry
+    {
+        /// Expiration time of the timer.
+        long long when;
+        /// Scheduling order, for ties of when.
+        uint32_t seq;
+        /// The scheduled timer.
+        ::Timer *timer;
+
+        /// @return true if this should expire before o. @param o other entry.
+        bool operator<(const HeapEntry &o) const
+        {
+            return when < o.when ||
+                (when == o.when && (int32_t)(seq - o.seq) < 0);
+        }
+    };
+
+    /// Puts an entry into a heap position and tells the timer where it is.
+    /// @param pos heap position. @param e entry to put there.
+    void heap_set(unsigned pos, const HeapEntry &e);
+    /// Moves an entry towards the root until the heap is ordered.
+    /// @param pos heap position of the entry. @param e entry to move.
+    void heap_sift_up(unsigned pos, const HeapEntry &e);
+    /// Moves an entry towards the leaves until the heap is ordered.
+    /// @param pos heap position of the entry. @param e entry to move.
+    void heap_sift_down(unsigned pos, const HeapEntry &e);
+    /// Removes the entry at a given heap position. @param pos heap position.
+    void heap_erase(unsigned pos);
+
+    /// Scheduled timers, 4-ary min-heap. The children of i are 4i+1..4i+4.
+    std::vector<HeapEntry> heap_;
+    /// Scheduling order of the next timer inserted.
+    uint32_t nextSeq_{0};
+#else
     /// List of timers that are scheduled.
     QMember activeTimers_;
+#endif
+    /// Diagnostic counters.
+    Stats stats_{};
     /// 1 if we in the executor's queue.
     std::atomic_uint_least8_t isPending_;
 
@@ -145,6 +226,9 @@ public:
         , isExpired_(0)
         , isCancelled_(0)
         , tcRequestStop_(0)
+#if OPENMRN_FEATURE_TIMER_HEAP
+        , heapIndex_(0)
+#endif
     {
     }
 
@@ -303,6 +387,10 @@ private:
     unsigned isCancelled_ : 1;
     /** For children: 1 if a repeated timer should stop sending wakeups. */
     unsigned tcRequestStop_ : 1;
+#if OPENMRN_FEATURE_TIMER_HEAP
+    /** Position of this timer in the active timers' heap. */
+    unsigned heapIndex_;
+#endif
 
     DISALLOW_COPY_AND_ASSIGN(Timer);
 };
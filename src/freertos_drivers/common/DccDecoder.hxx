@@ -336,11 +336,7 @@ __attribute__((optimize("-O3"))) void DccDecoder<Module>::interrupt_handler()
             // Record packet to send back to userspace
             if (nextPacketData_)
             {
-                nextPacketData_->header_raw_data = 0;
-                nextPacketData_->packet_header.skip_ec = 1;
-                nextPacketData_->dlc = decoder_.packet_length();
-                memcpy(nextPacketData_->payload, decoder_.packet_data(),
-                    decoder_.packet_length());
+                decoder_.packet(nextPacketData_);
                 nextPacketData_ = nullptr;
                 nextPacketFilled_ = true;
 
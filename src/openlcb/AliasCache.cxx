@@ -44,6 +44,11 @@ const NodeID AliasCache::RESERVED_ALIAS_NODE_ID = 1;
 
 void AliasCache::clear()
 {
+    if (flat)
+    {
+        flat->clear();
+        return;
+    }
     idMap.clear();
     aliasMap.clear();
     oldest = nullptr;
@@ -64,6 +69,11 @@ void AliasCache::clear()
  */
 void AliasCache::add(NodeID id, NodeAlias alias)
 {
+    if (flat)
+    {
+        flat->add(id, alias);
+        return;
+    }
     HASSERT(id != 0);
     HASSERT(alias != 0);
     
@@ -150,6 +160,11 @@ void AliasCache::add(NodeID id, NodeAlias alias)
  */
 void AliasCache::remove(NodeAlias alias)
 {
+    if (flat)
+    {
+        flat->remove(alias);
+        return;
+    }
     AliasMap::Iterator it = aliasMap.find(alias);
 
     if (it != aliasMap.end())
@@ -183,6 +198,10 @@ void AliasCache::remove(NodeAlias alias)
 
 bool AliasCache::retrieve(unsigned entry, NodeID* node, NodeAlias* alias)
 {
+    if (flat)
+    {
+        return flat->retrieve(entry, node, alias);
+    }
     HASSERT(entry < size());
     Metadata* md = pool + entry;
     if (!md->alias) return false;
@@ -197,6 +216,10 @@ bool AliasCache::retrieve(unsigned entry, NodeID* node, NodeAlias* alias)
  */
 NodeAlias AliasCache::lookup(NodeID id)
 {
+    if (flat)
+    {
+        return flat->lookup(id);
+    }
     HASSERT(id != 0);
 
     IdMap::Iterator it = idMap.find(id);
@@ -220,6 +243,10 @@ NodeAlias AliasCache::lookup(NodeID id)
  */
 NodeID AliasCache::lookup(NodeAlias alias)
 {
+    if (flat)
+    {
+        return flat->lookup(alias);
+    }
     HASSERT(alias != 0);
 
     AliasMap::Iterator it = aliasMap.find(alias);
@@ -244,6 +271,11 @@ NodeID AliasCache::lookup(NodeAlias alias)
  */
 void AliasCache::for_each(void (*callback)(void*, NodeID, NodeAlias), void *context)
 {
+    if (flat)
+    {
+        flat->for_each(callback, context);
+        return;
+    }
     HASSERT(callback != NULL);
 
     for (Metadata *metadata = newest; metadata != NULL; metadata = metadata->older)
@@ -35,6 +35,7 @@
 #define _OPENLCB_ALIASCACHE_HXX_
 
 #include "openlcb/Defs.hxx"
+#include "openlcb/FlatAliasCache.hxx"
 #include "utils/macros.h"
 #include "utils/Map.hxx"
 #include "utils/RBTree.hxx"
@@ -48,6 +49,12 @@ namespace openlcb
  * is no mutual exclusion locking mechanism built into this class.  Mutual
  * exclusion must be handled by the user as needed.
  *
+ * There are two storage implementations. The default one keeps the mappings
+ * in two Maps (RBTree or std::map) with a doubly linked LRU list. The flat one
+ * (see @ref FlatAliasCache) uses open-addressed hash tables over a packed
+ * entry array, which is faster for large caches, such as the remote alias
+ * cache of a gateway.
+ *
  * @todo the class uses RBTree, consider a version that is a linear search for
  * a small number of entries.
  */
@@ -60,16 +67,21 @@ public:
      * @param remove_callback callback to call when we remove a mapping from
      *        the cache however it will not be called in the remove() method
      * @param context context pointer to pass to remove_callback
+     * @param use_flat true to store the mappings in a @ref FlatAliasCache
+     *        instead of the Maps. Must be less than 65535 entries.
      */
     AliasCache(NodeID seed, size_t _entries,
                void (*remove_callback)(NodeID id, NodeAlias alias, void *) = NULL,
-               void *context = NULL)
-        : pool(new Metadata[_entries]),
+               void *context = NULL, bool use_flat = false)
+        : pool(use_flat ? nullptr : new Metadata[_entries]),
           freeList(NULL),
-          aliasMap(_entries),
-          idMap(_entries),
+          aliasMap(use_flat ? 0 : _entries),
+          idMap(use_flat ? 0 : _entries),
           oldest(NULL),
           newest(NULL),
+          flat(use_flat
+                  ? new FlatAliasCache(_entries, remove_callback, context)
+                  : nullptr),
           seed(seed),
           entries(_entries),
           removeCallback(remove_callback),
@@ -194,6 +206,9 @@ private:
     /** newest, most recently touched entry */
     Metadata *newest;
 
+    /** If not null, all mappings are stored here instead of the Maps. */
+    std::unique_ptr<FlatAliasCache> flat;
+
     /** Seed for the generation of the next alias */
     NodeID seed;
 
@@ -38,6 +38,7 @@
 #include "openlcb/DatagramDefs.hxx"
 #include "openlcb/FirmwareUpgradeDefs.hxx"
 #include "openlcb/StreamDefs.hxx"
+#include "openlcb/StreamSender.hxx"
 #include "openlcb/PIPClient.hxx"
 #include "openlcb/CanDefs.hxx"
 #include "openlcb/MemoryConfig.hxx"
@@ -93,8 +94,8 @@ int g_bootloader_timeout_sec = 3;
 /// 1) allocates a datagram handler
 /// 2) sends a stream write request datagram to the target node
 /// 3) waits for the write stream response
-/// 4) sends the data using a manual implementaiton of the stream protocol
-/// (stream initiate; data send; wait for proceeds; stream close)
+/// 4) sends the data using a StreamSender (stream initiate; data send; wait
+/// for proceeds; stream close)
 /// 5) reboots the target node.
 ///
 /// This stateflow needs to get one message of type BootloaderRequest to
@@ -102,12 +103,24 @@ int g_bootloader_timeout_sec = 3;
 class BootloaderClient : public StateFlow<Buffer<BootloaderRequest>, QList<1>>
 {
 public:
-    BootloaderClient(
-        Node *node, DatagramService *if_datagram_service, IfCan *if_can)
+    /// Constructor.
+    /// @param node local node to send from
+    /// @param if_datagram_service datagram service of the node's interface
+    /// @param if_can the CAN interface of the node
+    /// @param stream_service stream service of the node's interface. If
+    /// nullptr, the client creates its own; this must not be done if the
+    /// interface already has a stream service.
+    BootloaderClient(Node *node, DatagramService *if_datagram_service,
+        IfCan *if_can, StreamService *stream_service = nullptr)
         : StateFlow<Buffer<BootloaderRequest>, QList<1>>(node->iface())
         , node_(node)
         , datagramService_(if_datagram_service)
         , ifCan_(if_can)
+        , ownedStreamService_(
+              stream_service ? nullptr : new StreamService(node->iface()))
+        , streamService_(
+              stream_service ? stream_service : ownedStreamService_.get())
+        , streamSender_(streamService_)
     {
     }
 
@@ -223,7 +236,7 @@ private:
         payload.push_back(message()->data()->offset >> 8);
         payload.push_back(message()->data()->offset);
         payload.push_back(message()->data()->memory_space);
-        localStreamId_ = allocate_local_stream_id();
+        localStreamId_ = streamService_->allocate_stream_id(node_);
         payload.push_back(localStreamId_);
         b->data()->reset(Defs::MTI_DATAGRAM, node_->node_id(),
             message()->data()->dst, payload);
@@ -351,6 +364,10 @@ private:
             MemoryConfigDefs::COMMAND_WRITE_STREAM_REPLY)
         {
             // Write OK. proceed to stream acquisition.
+            unsigned ofs = (payload[1] & 3) ? 6 : 7;
+            remoteStreamId_ = payload.size() >= ofs + 2
+                ? payload[ofs + 1]
+                : StreamDefs::INVALID_STREAM_ID;
             responseDatagram_->unref();
             responseDatagram_ = nullptr;
             return call_immediately(STATE(initiate_stream));
@@ -363,11 +380,6 @@ private:
         }
     }
 
-    uint8_t allocate_local_stream_id()
-    {
-        return 0x55;
-    }
-
     Action return_error(uint16_t error_code, const string &error_details)
     {
         unregister_write_response_handler();
@@ -400,171 +412,75 @@ private:
 
     Action initiate_stream()
     {
-        return allocate_and_call(
-            node_->iface()->addressed_message_write_flow(),
-            STATE(send_init_stream));
-    }
-
-    Action send_init_stream()
-    {
-        auto *b = get_allocation_result(
-            node_->iface()->addressed_message_write_flow());
-        b->data()->reset(Defs::MTI_STREAM_INITIATE_REQUEST, node_->node_id(),
-            message()->data()->dst,
-            StreamDefs::create_initiate_request(
-                             StreamDefs::MAX_PAYLOAD, false, localStreamId_));
-        node_->iface()->addressed_message_write_flow()->send(b);
-        sleeping_ = true;
-        node_->iface()->dispatcher()->register_handler(
-            &streamInitiateReplyHandler_, Defs::MTI_STREAM_INITIATE_REPLY,
-            Defs::MTI_EXACT);
-        return sleep_and_call(&timer_, SEC_TO_NSEC(g_bootloader_timeout_sec),
-            STATE(received_init_stream));
+        streamSender_.set_timeout(SEC_TO_NSEC(g_bootloader_timeout_sec));
+        streamSender_.start_stream(node_, dst(), localStreamId_,
+            remoteStreamId_, StreamDefs::MAX_PAYLOAD, this);
+        return wait_and_call(STATE(stream_initiated));
     }
 
-    void stream_initiate_replied(Buffer<GenMessage> *message)
+    Action stream_initiated()
     {
-        if (message->data()->dstNode != node_ ||
-            !node_->iface()->matching_node(dst(), message->data()->src))
+        int error = streamSender_.error();
+        if (error == StreamSender::TIMEOUT)
         {
-            // Not for me.
-            return message->unref();
+            return return_error(Defs::ERROR_TEMPORARY,
+                "Timed out waiting for stream initiate reply.");
         }
-        const auto &payload = message->data()->payload;
-        if (payload.size() < 6 || payload[4] != localStreamId_)
+        if (error == Defs::ERROR_INVALID_ARGS)
         {
-            // Talking about another stream or incorrect data.
-            return message->unref();
-        }
-        remoteStreamId_ = payload[5];
-        streamFlags_ = payload[2];
-        streamAdditionalFlags_ = payload[3];
-        maxBufferSize_ = (payload[0] << 8) | payload[1];
-        // We save the remote alias here if we haven't got any yet.
-        if (message->data()->src.alias)
-        {
-            this->message()->data()->dst.alias = message->data()->src.alias;
+            return return_error(DatagramDefs::PERMANENT_ERROR,
+                "Inconsistency: zero buffer length but "
+                "accepted stream request.");
         }
-        message->unref();
-        timer_.trigger();
-    }
-
-    Action received_init_stream()
-    {
-        sleeping_ = false;
-        node_->iface()->dispatcher()->unregister_handler(
-            &streamInitiateReplyHandler_, Defs::MTI_STREAM_INITIATE_REPLY,
-            Defs::MTI_EXACT);
-        if (!(streamFlags_ & StreamDefs::FLAG_ACCEPT))
+        if (error & Defs::ERROR_PERMANENT)
         {
-            if (streamFlags_ & StreamDefs::FLAG_PERMANENT_ERROR)
-            {
-                return return_error(
-                    DatagramDefs::PERMANENT_ERROR | streamAdditionalFlags_,
-                    "Stream initiate request was denied (permanent error).");
-            }
-            else
-            {
-                return return_error(
-                    Defs::ERROR_TEMPORARY | streamAdditionalFlags_,
-                    "Stream initiate request was denied (temporary error).");
-            }
+            return return_error(error & 0xffff,
+                "Stream initiate request was denied (permanent error).");
         }
-        if (!maxBufferSize_)
+        if (error)
         {
-            return return_error(DatagramDefs::PERMANENT_ERROR,
-                "Inconsistency: zero buffer length but "
-                "accepted stream request.");
+            return return_error(error & 0xffff,
+                "Stream initiate request was denied (temporary error).");
         }
-        availableBufferSize_ = maxBufferSize_;
         bufferOffset_ = 0;
-        speed_ = 0;
-        lastMeasurementOffset_ = 0;
-        lastMeasurementTimeNsec_ = os_get_time_monotonic();
-        node_->iface()->dispatcher()->register_handler(
-            &streamProceedHandler_, Defs::MTI_STREAM_PROCEED, Defs::MTI_EXACT);
+        speedAvg_ = Ewma();
         return call_immediately(STATE(send_stream_data));
     }
 
+    /// Sends the next buffer's worth of data. The stream sender waits for
+    /// the proceed messages as needed.
     Action send_stream_data()
     {
-        if (bufferOffset_ >= message()->data()->data.size())
+        size_t len = message()->data()->data.size() - bufferOffset_;
+        if (!len)
         {
             return call_immediately(STATE(close_stream));
         }
-        return allocate_and_call(
-            ifCan_->frame_write_flow(), STATE(fill_outgoing_stream_frame));
-    }
-
-    Action fill_outgoing_stream_frame()
-    {
-        auto *b = get_allocation_result(ifCan_->frame_write_flow());
-        uint32_t can_id;
-        NodeAlias local_alias =
-            ifCan_->local_aliases()->lookup(node()->node_id());
-        NodeAlias remote_alias = dst().alias;
-        CanDefs::set_datagram_fields(
-            &can_id, local_alias, remote_alias, CanDefs::STREAM_DATA);
-        auto *frame = b->data()->mutable_frame();
-        SET_CAN_FRAME_ID_EFF(*frame, can_id);
-        size_t len =
-            std::min(size_t(7), message()->data()->data.size() - bufferOffset_);
-        if (availableBufferSize_ < len)
-        {
-            len = availableBufferSize_;
-        }
-        frame->can_dlc = len + 1;
-        frame->data[0] = remoteStreamId_;
-        memcpy(&frame->data[1], &message()->data()->data[bufferOffset_], len);
-        bufferOffset_ += len;
-        availableBufferSize_ -= len;
-        // LOG(INFO, "available buffer: %d", availableBufferSize_);
-        b->set_done(n_.reset(this));
-        ifCan_->frame_write_flow()->send(b);
-
-        if (availableBufferSize_)
-        {
-            return wait_and_call(STATE(send_stream_data));
-        }
-        else
-        {
-            return wait_and_call(STATE(wait_for_stream_proceed));
-        }
-    }
-
-    Action wait_for_stream_proceed()
-    {
-        if (availableBufferSize_)
+        if (len > streamSender_.buffer_size())
         {
-            // received early stream_proceed response
-            return call_immediately(STATE(stream_proceed_timeout));
+            len = streamSender_.buffer_size();
         }
-        sleeping_ = true;
-        sleepStartTimeNsec_ = os_get_time_monotonic();
-        return sleep_and_call(&timer_, SEC_TO_NSEC(g_bootloader_timeout_sec),
-            STATE(stream_proceed_timeout));
+        sliceLength_ = len;
+        streamSender_.send_data(
+            &message()->data()->data[bufferOffset_], len, this);
+        return wait_and_call(STATE(stream_data_sent));
     }
 
-    void stream_proceed_received(Buffer<GenMessage> *message)
+    Action stream_data_sent()
     {
-        if (message->data()->dstNode != node_ ||
-            !node_->iface()->matching_node(dst(), message->data()->src))
-        {
-            // Not for me.
-            return message->unref();
-        }
-        size_t bytes_sent = bufferOffset_ - lastMeasurementOffset_;
-        long long next_time = os_get_time_monotonic();
-        float new_speed = next_time - lastMeasurementTimeNsec_;
-        new_speed = float(bytes_sent) * 1e9 / new_speed;
-        if (!lastMeasurementOffset_)
+        int error = streamSender_.error();
+        if (error == StreamSender::TIMEOUT)
         {
-            speed_ = new_speed;
+            return return_error(Defs::ERROR_TEMPORARY,
+                "Times out waiting for stream proceed message.");
         }
-        else
+        if (error)
         {
-            speed_ = speed_ * 0.8 + new_speed * 0.2;
+            return return_error(
+                error & 0xffff, "Stream was terminated by the target.");
         }
+        bufferOffset_ += sliceLength_;
+        speedAvg_.add_absolute(bufferOffset_);
         struct timespec ts;
         clock_gettime(CLOCK_REALTIME, &ts);
         if (request()->progress_callback)
@@ -574,59 +490,20 @@ private:
             request()->progress_callback(ofs);
         }
         LOG(INFO,
-            "%02ld.%06ld stream offset: %" PRIdPTR "; wrote %.0lld usec slept "
-            "%.0lld usec, speed=%.0f bytes/sec",
+            "%02ld.%06ld stream offset: %" PRIdPTR "; speed=%.0f bytes/sec",
             ts.tv_sec % 60, ts.tv_nsec / 1000, bufferOffset_,
-            (sleepStartTimeNsec_ - lastMeasurementTimeNsec_) / 1000,
-            (next_time - sleepStartTimeNsec_) / 1000, speed_);
-        lastMeasurementOffset_ = bufferOffset_;
-        lastMeasurementTimeNsec_ = next_time;
-
-        const auto &payload = message->data()->payload;
-        if (payload.size() < 2 || payload[0] != localStreamId_)
-        {
-            // Talking about another stream or incorrect data.
-            return message->unref();
-        }
-        availableBufferSize_ += maxBufferSize_;
-        message->unref();
-        if (sleeping_)
-        {
-            timer_.trigger();
-        }
-    }
-
-    Action stream_proceed_timeout()
-    {
-        sleeping_ = false;
-        if (!availableBufferSize_) // no proceed arrived
-        {
-            ///@TODO(balazs.racz) somehow merge these two actions: remember
-            /// that we timed out and close the stream.
-            return return_error(Defs::ERROR_TEMPORARY,
-                "Times out waiting for stream proceed message.");
-            return call_immediately(STATE(close_stream));
-        }
+            speedAvg_.avg());
         return call_immediately(STATE(send_stream_data));
     }
 
     Action close_stream()
     {
-        node_->iface()->dispatcher()->unregister_handler(
-            &streamProceedHandler_, Defs::MTI_STREAM_PROCEED, Defs::MTI_EXACT);
-        return allocate_and_call(
-            node_->iface()->addressed_message_write_flow(),
-            STATE(send_close_stream));
+        streamSender_.close_stream(this);
+        return wait_and_call(STATE(stream_closed));
     }
 
-    Action send_close_stream()
+    Action stream_closed()
     {
-        auto *b = get_allocation_result(
-            node_->iface()->addressed_message_write_flow());
-        b->data()->reset(Defs::MTI_STREAM_COMPLETE, node_->node_id(),
-            message()->data()->dst,
-            StreamDefs::create_close_request(localStreamId_, remoteStreamId_));
-        node_->iface()->addressed_message_write_flow()->send(b);
         // wait some time before sending the reset command.
         return sleep_and_call(
             &timer_, MSEC_TO_NSEC(200), STATE(send_reboot_request));
@@ -771,38 +648,24 @@ private:
     IfCan *ifCan_;
     DatagramClient *dgClient_ = nullptr;
     Buffer<IncomingDatagram> *responseDatagram_ = nullptr;
+    /// Stream service we own if the caller did not give us one.
+    std::unique_ptr<StreamService> ownedStreamService_;
+    /// Stream service of the interface.
+    StreamService *streamService_;
+    /// Sends the data in stream mode.
+    StreamSender streamSender_;
     uint8_t localStreamId_;
+    // Stream ID at the target, if it told us in the write stream reply.
     uint8_t remoteStreamId_;
-    // maximum size of pending stream data.
-    uint16_t maxBufferSize_;
-    // Flags from the stream initiate response.
-    uint8_t streamFlags_;
-    // Additional flags from the initiate response.
-    uint8_t streamAdditionalFlags_;
-
-    // How many bytes can we send before needing to wait for stream data
-    // proceed message.
-    uint32_t availableBufferSize_;
+    // Number of bytes handed to the stream sender in the last call.
+    size_t sliceLength_;
     // The next byte we need to send from the input data.
     size_t bufferOffset_;
 
     Ewma speedAvg_;
-    // The Average speed (ewma) in bytes/second.
-    float speed_;
-    // The offset at which the last speed measurement took place.
-    size_t lastMeasurementOffset_;
-    // The time in nsec at which the last speed measurement took place.
-    long long lastMeasurementTimeNsec_;
-    // Snapshots the time at which we start to sleep to wait for a stream
-    // proceed flag.
-    long long sleepStartTimeNsec_;
 
     WriteResponseHandler writeResponseHandler_{this};
     bool writeResponseRegistered_ = false;
-    MessageHandler::GenericHandler streamInitiateReplyHandler_{
-        this, &BootloaderClient::stream_initiate_replied};
-    MessageHandler::GenericHandler streamProceedHandler_{
-        this, &BootloaderClient::stream_proceed_received};
     StateFlowTimer timer_{this};
     // true if we are waiting for a timeout, false if we haven't started
     // sleeping yet.
@@ -81,17 +81,20 @@ public:
             return;
         }
         const string &p = *b->data();
-        for (unsigned i = 0; i < p.size(); ++i)
+        const char *data = p.data();
+        size_t len = p.size();
+        struct can_frame frames[8];
+        while (len)
         {
-            if (it->second.segmenter_.consume_byte(p[i]))
+            size_t consumed;
+            unsigned count = it->second.segmenter_.parse_frames(
+                data, len, frames, ARRAYSIZE(frames), &consumed);
+            data += consumed;
+            len -= consumed;
+            for (unsigned i = 0; i < count; ++i)
             {
-                // We have a frame.
-                string ret;
-                it->second.segmenter_.frame_buffer(&ret);
-                LOG(VERBOSE, "sending frame: %s", ret.c_str());
                 auto *cb = deliveryFlow_.alloc();
-                HASSERT(it->second.segmenter_.parse_frame_to_output(
-                    cb->data()->mutable_frame()));
+                *cb->data()->mutable_frame() = frames[i];
                 cb->data()->skipMember_ = reinterpret_cast<
                     FlowInterface<Buffer<HubContainer<CanFrameContainer>>> *>(
                     b->data()->skipMember_);
@@ -62,17 +62,17 @@ public:
 
 
 private:
-    Action fill_can_frame_buffer() OVERRIDE
+    bool has_frames() override
     {
-        LOG(VERBOSE, "fill can frame buffer");
-        auto *b = get_allocation_result(if_can()->frame_write_flow());
-        struct can_frame *f = b->data()->mutable_frame();
         HASSERT(nmsg()->mti == Defs::MTI_DATAGRAM);
+        return true;
+    }
 
+    bool fill_frame(struct can_frame *f) override
+    {
         // Sets the CAN id.
         uint32_t can_id = 0x1A000000;
         CanDefs::set_src(&can_id, srcAlias_);
-        LOG(VERBOSE, "dst alias %x", dstAlias_);
         CanDefs::set_dst(&can_id, dstAlias_);
 
         bool need_more_frames = false;
@@ -113,16 +113,7 @@ private:
         f->can_dlc = len;
 
         SET_CAN_FRAME_ID_EFF(*f, can_id);
-        if_can()->frame_write_flow()->send(b);
-
-        if (need_more_frames)
-        {
-            return call_immediately(STATE(get_can_frame_buffer));
-        }
-        else
-        {
-            return call_immediately(STATE(send_finished));
-        }
+        return need_more_frames;
     }
 }; // CanDatagramWriteFlow
 
@@ -207,7 +198,7 @@ public:
                 buf->clear();
 
                 // Datagram first frame. Get a full buffer.
-                buf->reserve(72);
+                payload_reserve(buf, DatagramDefs::MAX_SIZE);
                 last_frame = false;
                 break;
             }
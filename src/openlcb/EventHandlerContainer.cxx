@@ -39,35 +39,53 @@
 namespace openlcb
 {
 
+constexpr uint32_t TreeEventHandlers::EMPTY_SLOT;
+constexpr unsigned TreeEventHandlers::MIN_EXACT_INDEX_SIZE;
+
 void TreeEventHandlers::register_handler(const EventRegistryEntry &entry,
                                          unsigned mask)
 {
     AtomicHolder h(this);
     LOG(VERBOSE, "%p: register %p", this, entry.handler);
+    Snapshot *s = pending();
+    if (mask == 0)
+    {
+        s->exactHandlers.push_back(entry);
+    }
+    else
+    {
+        EventId last =
+            mask >= 64 ? ~EventId(0) : entry.event | ((1ULL << mask) - 1);
+        s->rangeHandlers.emplace_back(entry, last);
+    }
     set_dirty();
-    handlers_[mask].insert(EventRegistryEntry(entry));
 }
 
 void TreeEventHandlers::unregister_handler(EventHandler *handler)
 {
     AtomicHolder h(this);
-    set_dirty();
     LOG(VERBOSE, "%p: unregister %p", this, handler);
+    Snapshot *s = pending();
     bool found = false;
-    for (auto r = handlers_.begin(); r != handlers_.end(); ++r)
+    auto erase_it = std::remove_if(s->exactHandlers.begin(),
+        s->exactHandlers.end(), [handler](const EventRegistryEntry &reg) {
+            return reg.handler == handler;
+        });
+    if (erase_it != s->exactHandlers.end())
     {
-        auto begin_it = r->second.begin();
-        auto end_it = r->second.end();
-        auto erase_it = std::remove_if(
-            begin_it, end_it, [handler](const EventRegistryEntry &reg) {
-                return reg.handler == handler;
-            });
-        if (erase_it != end_it)
-        {
-            r->second.erase(erase_it, end_it);
-            found = true;
-        }
+        s->exactHandlers.erase(erase_it, s->exactHandlers.end());
+        found = true;
     }
+    auto range_erase_it = std::remove_if(s->rangeHandlers.begin(),
+        s->rangeHandlers.end(), [handler](const RangeEntry &reg) {
+            return reg.entry.handler == handler;
+        });
+    if (range_erase_it != s->rangeHandlers.end())
+    {
+        s->rangeHandlers.erase(range_erase_it, s->rangeHandlers.end());
+        found = true;
+    }
+    set_dirty();
     if (found)
     {
         return;
@@ -75,87 +93,357 @@ void TreeEventHandlers::unregister_handler(EventHandler *handler)
     DIE("tried to unregister a handler that was not registered");
 }
 
-/// Class representing the iteration state on the binary tree-based event
-/// handler registry.
+TreeEventHandlers::Snapshot *TreeEventHandlers::pending()
+{
+    if (!pending_)
+    {
+        reclaim();
+        Snapshot *c = current_.load();
+        pending_ = new Snapshot;
+        pending_->exactHandlers = c->exactHandlers;
+        pending_->rangeHandlers = c->rangeHandlers;
+        hasPending_.store(true);
+    }
+    return pending_;
+}
+
+void TreeEventHandlers::publish()
+{
+    if (!pending_)
+    {
+        return;
+    }
+    pending_->compile();
+    retired_.push_back(current_.load());
+    current_.store(pending_);
+    pending_ = nullptr;
+    hasPending_.store(false);
+    reclaim();
+}
+
+void TreeEventHandlers::Snapshot::compile()
+{
+    exactHandlers.shrink_to_fit();
+    std::sort(exactHandlers.begin(), exactHandlers.end(), cmpop());
+    exactIndex.clear();
+    exactIndexBits = 0;
+    if (!exactHandlers.empty())
+    {
+        unsigned size = MIN_EXACT_INDEX_SIZE;
+        while (size < exactHandlers.size() * 2)
+        {
+            size <<= 1;
+        }
+        while ((1u << exactIndexBits) < size)
+        {
+            ++exactIndexBits;
+        }
+        exactIndex.resize(size, EMPTY_SLOT);
+        unsigned slot_mask = size - 1;
+        for (uint32_t i = 0; i < exactHandlers.size(); ++i)
+        {
+            unsigned slot = exact_hash(exactHandlers[i].event);
+            while (exactIndex[slot] != EMPTY_SLOT)
+            {
+                slot = (slot + 1) & slot_mask;
+            }
+            exactIndex[slot] = i;
+        }
+    }
+
+    rangeHandlers.shrink_to_fit();
+    std::sort(rangeHandlers.begin(), rangeHandlers.end());
+    rangeMaxLast.resize(rangeHandlers.size());
+    compile_subtree(0, rangeHandlers.size());
+}
+
+EventId TreeEventHandlers::Snapshot::compile_subtree(unsigned lo, unsigned hi)
+{
+    if (lo >= hi)
+    {
+        return 0;
+    }
+    unsigned mid = lo + (hi - lo) / 2;
+    EventId m = rangeHandlers[mid].last;
+    m = std::max(m, compile_subtree(lo, mid));
+    m = std::max(m, compile_subtree(mid + 1, hi));
+    rangeMaxLast[mid] = m;
+    return m;
+}
+
+/// Class representing the iteration state on the tree-based event handler
+/// registry. Does not take the registry's lock unless there are unpublished
+/// registration changes.
 class TreeEventHandlers::Iterator : public EventIterator
 {
 public:
     Iterator(TreeEventHandlers *parent)
         : parent_(parent)
+        , snapshot_(nullptr)
+        , pinned_(nullptr)
     {
         AtomicHolder h(parent_);
-        parent->handlers_[0];
+        parent_->iterators_.push_back(this);
         clear_iteration();
     }
 
-    EventRegistryEntry *next_entry() OVERRIDE
+    ~Iterator()
     {
         AtomicHolder h(parent_);
-        while (maskIterator_ != parent_->handlers_.end())
+        auto &its = parent_->iterators_;
+        its.erase(std::remove(its.begin(), its.end(), this), its.end());
+    }
+
+    EventRegistryEntry *next_entry() OVERRIDE
+    {
+        if (!snapshot_)
+        {
+            return nullptr;
+        }
+        // The snapshot stays pinned after the last entry, because the caller
+        // might still be using the entries we returned. It is released by
+        // clear_iteration or the next init_iteration.
+        EventRegistryEntry *e = next_exact_entry();
+        if (!e)
+        {
+            e = next_range_entry();
+        }
+        return e;
+    }
+
+    void clear_iteration() OVERRIDE
+    {
+        exactState_ = EXACT_DONE;
+        stackSize_ = 0;
+        unpin();
+    }
+
+    void init_iteration(EventReport *r) OVERRIDE
+    {
+        unpin();
+        if (parent_->hasPending_.load())
+        {
+            AtomicHolder h(parent_);
+            parent_->publish();
+        }
+        // Announces which snapshot we are reading before using it. If a
+        // writer replaced the snapshot in the meantime, we might have been
+        // missed by its reclaim() scan, so we retry with the new one.
+        Snapshot *s;
+        do
+        {
+            s = parent_->current_.load();
+            pinned_.store(s);
+        } while (s != parent_->current_.load());
+        snapshot_ = s;
+
+        first_ = r->event;
+        last_ = r->event + r->mask;
+        if (r->mask != 0)
         {
-            if (it_ == end_)
+            exactState_ = EXACT_SCAN;
+            auto &entries = snapshot_->exactHandlers;
+            exactPos_ =
+                std::lower_bound(entries.begin(), entries.end(), first_, cmpop()) -
+                entries.begin();
+        }
+        else if (snapshot_->exactIndex.empty())
+        {
+            exactState_ = EXACT_DONE;
+        }
+        else
+        {
+            exactState_ = EXACT_PROBE;
+            exactPos_ = snapshot_->exact_hash(first_);
+        }
+        stackSize_ = 0;
+        push(0, snapshot_->rangeHandlers.size());
+    }
+
+    /// @return the snapshot this iterator is reading, or nullptr. Used by
+    /// the registry to decide which snapshots can be freed.
+    Snapshot *pinned()
+    {
+        return pinned_.load();
+    }
+
+private:
+    /// How we are walking the exact-match registrations.
+    enum ExactState
+    {
+        /// Following the probe sequence of the hash index for a single event.
+        EXACT_PROBE,
+        /// Walking the sorted exact-match entries inside a range.
+        EXACT_SCAN,
+        /// No more exact-match entries to return.
+        EXACT_DONE
+    };
+
+    /// Stops using the current snapshot.
+    void unpin()
+    {
+        snapshot_ = nullptr;
+        pinned_.store(nullptr);
+    }
+
+    /// Steps the iteration through the exact-match (mask == 0)
+    /// registrations.
+    /// @return the next matching entry, or nullptr when there are no more.
+    EventRegistryEntry *next_exact_entry()
+    {
+        auto &entries = snapshot_->exactHandlers;
+        if (exactState_ == EXACT_PROBE)
+        {
+            auto &index = snapshot_->exactIndex;
+            unsigned slot_mask = index.size() - 1;
+            // The load factor is at most 1/2, so there is always an empty
+            // slot terminating the probe sequence.
+            while (index[exactPos_] != EMPTY_SLOT)
             {
-                maskIterator_++;
-                if (maskIterator_ != parent_->handlers_.end())
+                EventRegistryEntry *e = &entries[index[exactPos_]];
+                exactPos_ = (exactPos_ + 1) & slot_mask;
+                if (e->event == first_)
                 {
-                    setup_current_mask();
+                    return e;
                 }
-                continue;
             }
-            else
+        }
+        else if (exactState_ == EXACT_SCAN)
+        {
+            if (exactPos_ < entries.size() && entries[exactPos_].event <= last_)
             {
-                EventRegistryEntry *e = &*it_;
-                it_++;
-                return e;
+                return &entries[exactPos_++];
             }
         }
+        exactState_ = EXACT_DONE;
         return nullptr;
     }
 
-    void clear_iteration() OVERRIDE
+    /// Steps the iteration through the interval tree of range registrations
+    /// (pre-order, pruning subtrees that cannot intersect [first_,
+    /// last_]).
+    /// @return the next matching entry, or nullptr when there are no more.
+    EventRegistryEntry *next_range_entry()
     {
-        AtomicHolder h(parent_);
-        maskIterator_ = parent_->handlers_.end();
-    }
-    void init_iteration(EventReport *r) OVERRIDE
-    {
-        AtomicHolder h(parent_);
-        currentReport_ = r;
-        maskIterator_ = parent_->handlers_.begin();
-        setup_current_mask();
+        auto &ranges = snapshot_->rangeHandlers;
+        while (stackSize_)
+        {
+            --stackSize_;
+            unsigned lo = stack_[stackSize_].lo;
+            unsigned hi = stack_[stackSize_].hi;
+            unsigned mid = lo + (hi - lo) / 2;
+            if (snapshot_->rangeMaxLast[mid] < first_)
+            {
+                // Every range in this subtree ends before the query.
+                continue;
+            }
+            RangeEntry *r = &ranges[mid];
+            if (r->entry.event <= last_)
+            {
+                // The right subtree starts at or after r.
+                push(mid + 1, hi);
+            }
+            push(lo, mid);
+            if (r->entry.event <= last_ && r->last >= first_)
+            {
+                return &r->entry;
+            }
+        }
+        return nullptr;
     }
 
-private:
-    void setup_current_mask()
+    /// Adds a subtree to the traversal stack, if it is not empty.
+    /// @param lo first index of the subtree.
+    /// @param hi one past the last index of the subtree.
+    void push(unsigned lo, unsigned hi)
     {
-        if (maskIterator_->first == 64)
+        if (lo >= hi)
         {
-            // 64 bits -> all events go to everyone.
-            it_ = maskIterator_->second.begin();
-            end_ = maskIterator_->second.end();
             return;
         }
-        unsigned mask_log = maskIterator_->first;
-        uint64_t current_mask = (1ULL << mask_log) - 1;
-        uint64_t eventid_key = currentReport_->event & (~current_mask);
-        it_ = maskIterator_->second.lower_bound(eventid_key);
-        eventid_key = currentReport_->event + currentReport_->mask;
-        end_ = maskIterator_->second.upper_bound(eventid_key);
+        HASSERT(stackSize_ < MAX_DEPTH);
+        stack_[stackSize_].lo = lo;
+        stack_[stackSize_].hi = hi;
+        ++stackSize_;
     }
+
+    /// Upper bound on the traversal stack size. Pre-order traversal keeps at
+    /// most one pending subtree per tree level, plus the root.
+    static constexpr unsigned MAX_DEPTH = 34;
+
+    /// A subtree of the implicit interval tree that we still need to visit.
+    struct Subtree
+    {
+        uint32_t lo;
+        uint32_t hi;
+    };
+
     TreeEventHandlers *parent_;
-    EventReport *currentReport_;
-    MaskLookupMap::iterator maskIterator_;
-    OneMaskMap::iterator it_;
-    OneMaskMap::iterator end_;
+    /// The snapshot the current iteration reads, or nullptr.
+    Snapshot *snapshot_;
+    /// Same as snapshot_, but visible to the registry's reclaim().
+    std::atomic<Snapshot *> pinned_;
+    /// First event ID of the current query (inclusive).
+    EventId first_;
+    /// Last event ID of the current query (inclusive).
+    EventId last_;
+    /// Where we are in iterating the exact-match registrations.
+    ExactState exactState_;
+    /// Slot in exactIndex (EXACT_PROBE) or offset in exactHandlers
+    /// (EXACT_SCAN) to look at next.
+    unsigned exactPos_;
+    /// Subtrees of the range registrations still to visit.
+    Subtree stack_[MAX_DEPTH];
+    /// Number of valid entries in stack_.
+    unsigned stackSize_;
 };
 
+constexpr unsigned TreeEventHandlers::Iterator::MAX_DEPTH;
+
+void TreeEventHandlers::reclaim()
+{
+    for (auto it = retired_.begin(); it != retired_.end();)
+    {
+        bool in_use = false;
+        for (Iterator *i : iterators_)
+        {
+            if (i->pinned() == *it)
+            {
+                in_use = true;
+                break;
+            }
+        }
+        if (in_use)
+        {
+            ++it;
+        }
+        else
+        {
+            delete *it;
+            it = retired_.erase(it);
+        }
+    }
+}
+
 EventIterator *TreeEventHandlers::create_iterator()
 {
     return new Iterator(this);
 }
 
 TreeEventHandlers::TreeEventHandlers()
+    : current_(new Snapshot)
 {
 }
 
+TreeEventHandlers::~TreeEventHandlers()
+{
+    HASSERT(iterators_.empty());
+    delete current_.load();
+    delete pending_;
+    for (Snapshot *s : retired_)
+    {
+        delete s;
+    }
+}
+
 } // namespace openlcb
@@ -38,6 +38,7 @@
 #define _OPENLCB_EVENTHANDLERCONTAINER_HXX_
 
 #include <algorithm>
+#include <atomic>
 #include <vector>
 #include <forward_list>
 #include <endian.h>
@@ -48,7 +49,6 @@
 
 #include "utils/Atomic.hxx"
 #include "utils/logging.h"
-#include "utils/SortedListMap.hxx"
 #include "openlcb/EventHandler.hxx"
 #include "openlcb/EventHandlerTemplates.hxx"
 
@@ -148,12 +148,28 @@ class VectorEventHandlers : public EventRegistry {
   HandlersList handlers_;
 };
 
-/// EventRegistry implementation that keeps event handlers in a SortedListMap
+/// EventRegistry implementation that keeps event handlers in indexed tables
 /// and filters the event handler calls based on the registered event handler
 /// arguments (id/mask).
+///
+/// Registrations for a single event (mask == 0) are stored in an
+/// open-addressing hash index, so that looking up the handlers of an incoming
+/// event report costs O(1) regardless of how many events are registered.
+///
+/// Range registrations are stored in an interval tree, laid out implicitly
+/// over an array sorted by the start of the range. Both "which ranges cover
+/// event X" and "which ranges intersect [X, X+mask]" only visit subtrees that
+/// can contain overlapping ranges, so they cost O(log n + k).
+///
+/// The iterators do not take any lock. They read an immutable snapshot of the
+/// registrations. register_handler and unregister_handler edit a pending copy
+/// and bump the epoch. The first iteration that starts after a change compiles
+/// the pending copy and publishes it as the new snapshot. Replaced snapshots
+/// are freed once no iterator is using them anymore.
 class TreeEventHandlers : public EventRegistry, private Atomic {
 public:
     TreeEventHandlers();
+    ~TreeEventHandlers();
 
     EventIterator* create_iterator() OVERRIDE;
     void register_handler(const EventRegistryEntry &entry,
@@ -164,6 +180,12 @@ private:
     class Iterator;
     friend class Iterator;
 
+    /// Marks an unused slot in the exact-match hash index.
+    static constexpr uint32_t EMPTY_SLOT = 0xFFFFFFFFu;
+    /// Smallest size of the exact-match hash index (when non-empty). Must be
+    /// a power of two.
+    static constexpr unsigned MIN_EXACT_INDEX_SIZE = 16;
+
     /// Comparison operator for event registry entries.
     struct cmpop
     {
@@ -181,12 +203,94 @@ private:
         }
     };
 
-    typedef SortedListSet<EventRegistryEntry, cmpop> OneMaskMap;
-    typedef std::map<uint8_t, OneMaskMap> MaskLookupMap;
-    /** The registered handlers. The offset in the first map tell us how many
-     * bits wide the registration is (it is the mask value in the register
-     * call).*/
-    MaskLookupMap handlers_;
+    /// A range registration.
+    struct RangeEntry
+    {
+        RangeEntry(const EventRegistryEntry &e, EventId l)
+            : entry(e)
+            , last(l)
+        {
+        }
+
+        /// The registration as it was handed to us. entry.event is the first
+        /// event ID in the range.
+        EventRegistryEntry entry;
+        /// Last event ID in the range (inclusive).
+        EventId last;
+
+        /// Sorts by the start of the range.
+        bool operator<(const RangeEntry &o) const
+        {
+            return entry.event < o.entry.event;
+        }
+    };
+
+    /// A copy of all registrations together with the lookup indexes. Once
+    /// published, a snapshot is never modified.
+    struct Snapshot
+    {
+        /// Computes the home slot of an event ID in exactIndex.
+        /// @param event is the event ID to hash.
+        /// @return index into exactIndex.
+        unsigned exact_hash(EventId event) const
+        {
+            // Fibonacci hashing. Spreads the low bits (which differ most
+            // between the events of a single node) onto the top bits we use
+            // as index.
+            return (event * 0x9E3779B97F4A7C15ULL) >> (64 - exactIndexBits);
+        }
+
+        /// Sorts the registrations and builds the lookup indexes.
+        void compile();
+
+        /// Computes the rangeMaxLast values of a subtree of the implicit
+        /// interval tree.
+        /// @param lo first index of the subtree in rangeHandlers.
+        /// @param hi one past the last index of the subtree in rangeHandlers.
+        /// @return the largest last event ID in the subtree.
+        EventId compile_subtree(unsigned lo, unsigned hi);
+
+        /// Registrations with mask == 0, sorted by event ID.
+        std::vector<EventRegistryEntry> exactHandlers;
+        /// Open-addressing (linear probing) hash table with offsets into
+        /// exactHandlers, or EMPTY_SLOT. Size is zero or 2^exactIndexBits.
+        std::vector<uint32_t> exactIndex;
+        /// log2 of the size of exactIndex.
+        unsigned exactIndexBits{0};
+
+        /// Registrations with mask > 0, sorted by the start of the range. The
+        /// implicit tree's root is the middle element; the left and right
+        /// subtrees are the two halves on either side of it, recursively.
+        std::vector<RangeEntry> rangeHandlers;
+        /// For each tree node in rangeHandlers, the largest RangeEntry::last
+        /// in the subtree rooted at that node.
+        std::vector<EventId> rangeMaxLast;
+    };
+
+    /// @return the snapshot that register and unregister should edit. Must
+    /// be called with the lock held.
+    Snapshot *pending();
+
+    /// Compiles and publishes the pending snapshot, if there is one. Must be
+    /// called with the lock held.
+    void publish();
+
+    /// Frees the retired snapshots that no iterator is using anymore. Must be
+    /// called with the lock held.
+    void reclaim();
+
+    /// The snapshot new iterations use. Never nullptr.
+    std::atomic<Snapshot *> current_;
+    /// Copy of current_ with the registration changes that are not yet
+    /// published, or nullptr if there are none. Protected by the lock.
+    Snapshot *pending_{nullptr};
+    /// True when pending_ is not nullptr. Read without the lock.
+    std::atomic<bool> hasPending_{false};
+    /// Snapshots that have been replaced, but an iterator might still be
+    /// using. Protected by the lock.
+    std::vector<Snapshot *> retired_;
+    /// All live iterators created by this registry. Protected by the lock.
+    std::vector<Iterator *> iterators_;
 };
 
 }; /* namespace openlcb */
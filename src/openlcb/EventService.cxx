@@ -13,6 +13,7 @@
 #include "openlcb/EventHandlerContainer.hxx"
 #include "openlcb/Defs.hxx"
 #include "openlcb/EndianHelper.hxx"
+#include "nmranet_config.h"
 
 namespace openlcb
 {
@@ -54,7 +55,14 @@ void EventService::register_interface(If *iface)
         EventService::Impl::MTI_MASK_ADDRESSED_ALL));
 }
 
-EventService::Impl::Impl(EventService *service) : callerFlow_(service)
+void EventService::set_batched_dispatch(bool batched)
+{
+    impl()->batchedDispatch_ = batched;
+}
+
+EventService::Impl::Impl(EventService *service)
+    : callerFlow_(service)
+    , batchedDispatch_(config_event_batched_dispatch() == CONSTANT_TRUE)
 {
 #ifdef TARGET_LPC11Cxx
     registry.reset(new VectorEventHandlers());
@@ -75,11 +83,41 @@ StateFlowBase::Action EventCallerFlow::entry()
         // Event registry was invalidated since this call was scheduled. Ignore.
         return call_immediately(STATE(call_done));
     }
+    if (c->batch)
+    {
+        batchNext_ = 0;
+        return call_immediately(STATE(call_batch));
+    }
     n_.reset(this);
     (c->registry_entry->handler->*(c->fn))(*c->registry_entry, c->rep, &n_);
     return wait_and_call(STATE(call_done));
 }
 
+StateFlowBase::Action EventCallerFlow::call_batch()
+{
+    EventHandlerCall *c = message()->data();
+    while (batchNext_ < c->batch_size)
+    {
+        if (c->epoch != EventRegistry::instance()->get_epoch())
+        {
+            // Registry was invalidated. The iterator flow will start over.
+            break;
+        }
+        const EventRegistryEntry *e = c->batch[batchNext_++];
+        n_.reset(this);
+        // It is required to hold on to a child to call abort_if_almost_done.
+        auto *ch = n_.new_child();
+        (e->handler->*(c->fn))(*e, c->rep, &n_);
+        if (!n_.abort_if_almost_done())
+        {
+            // The handler is doing something asynchronously.
+            ch->notify();
+            return wait_and_call(STATE(call_batch));
+        }
+    }
+    return call_immediately(STATE(call_done));
+}
+
 StateFlowBase::Action EventCallerFlow::call_done()
 {
     return release_and_exit();
@@ -246,35 +284,61 @@ StateFlowBase::Action EventIteratorFlow::iterate_next()
         iterator_->init_iteration(&eventReport_);
     }
 
-    EventRegistryEntry *entry = iterator_->next_entry();
-    if (!entry)
+    if (eventService_->impl()->batchedDispatch_)
     {
-        if (incomingDone_)
+        batchSize_ = 0;
+        while (batchSize_ < MAX_BATCH)
         {
-            incomingDone_->notify();
-            incomingDone_ = nullptr;
+            EventRegistryEntry *entry = iterator_->next_entry();
+            if (!entry)
+            {
+                break;
+            }
+            batch_[batchSize_++] = entry;
         }
-
-#ifdef DEBUG_EVENT_PERFORMANCE
-        long long len = os_get_time_monotonic() - currentProcessStart_;
-        numProcessNsec_ += len;
-        countEvents_++;
-        if (countEvents_ >= REPORT_COUNT)
+        if (!batchSize_)
         {
-            //long msec = numProcessNsec_ / 1000000;
-            //printf("event perf for mti %04x: %ld msec for %d events\n",
-            //       mtiValue_, msec, REPORT_COUNT);
-            countEvents_ = 0;
-            numProcessNsec_ = 0;
+            return iteration_done();
         }
+        return dispatch_batch();
+    }
 
-#endif
-
-        return exit();
+    EventRegistryEntry *entry = iterator_->next_entry();
+    if (!entry)
+    {
+        return iteration_done();
     }
     return dispatch_event(entry);
 }
 
+StateFlowBase::Action EventIteratorFlow::iteration_done()
+{
+    // Lets the registry release what the iteration was holding on to.
+    iterator_->clear_iteration();
+    if (incomingDone_)
+    {
+        incomingDone_->notify();
+        incomingDone_ = nullptr;
+    }
+
+#ifdef DEBUG_EVENT_PERFORMANCE
+    long long len = os_get_time_monotonic() - currentProcessStart_;
+    numProcessNsec_ += len;
+    countEvents_++;
+    if (countEvents_ >= REPORT_COUNT)
+    {
+        //long msec = numProcessNsec_ / 1000000;
+        //printf("event perf for mti %04x: %ld msec for %d events\n",
+        //       mtiValue_, msec, REPORT_COUNT);
+        countEvents_ = 0;
+        numProcessNsec_ = 0;
+    }
+
+#endif
+
+    return exit();
+}
+
 StateFlowBase::Action EventIteratorFlow::dispatch_event(const EventRegistryEntry *entry)
 {
     Buffer<EventHandlerCall> *b;
@@ -289,6 +353,21 @@ StateFlowBase::Action EventIteratorFlow::dispatch_event(const EventRegistryEntry
     return wait();
 }
 
+StateFlowBase::Action EventIteratorFlow::dispatch_batch()
+{
+    Buffer<EventHandlerCall> *b;
+    eventService_->impl()->callerFlow_.pool()->alloc(&b, nullptr);
+    HASSERT(b);
+    // batch_ is not touched until the caller flow is done with the buffer,
+    // because we are waiting for n_.
+    b->data()->reset_batch(
+        batch_, batchSize_, eventRegistryEpoch_, &eventReport_, fn_);
+    n_.reset(this);
+    b->set_done(&n_);
+    eventService_->impl()->callerFlow_.send(b, priority());
+    return wait();
+}
+
 StateFlowBase::Action
 InlineEventIteratorFlow::dispatch_event(const EventRegistryEntry *entry)
 {
@@ -314,4 +393,34 @@ InlineEventIteratorFlow::dispatch_event(const EventRegistryEntry *entry)
     }
 }
 
+StateFlowBase::Action InlineEventIteratorFlow::dispatch_batch()
+{
+    batchNext_ = 0;
+    return call_immediately(STATE(call_batch));
+}
+
+StateFlowBase::Action InlineEventIteratorFlow::call_batch()
+{
+    while (batchNext_ < batchSize_)
+    {
+        if (eventRegistryEpoch_ !=
+            eventService_->impl()->registry->get_epoch())
+        {
+            // Will restart iteration.
+            break;
+        }
+        currentEntry_ = batch_[batchNext_++];
+        n_.reset(this);
+        // It is required to hold on to a child to call abort_if_almost_done.
+        auto *c = n_.new_child();
+        (currentEntry_->handler->*(fn_))(*currentEntry_, &eventReport_, &n_);
+        if (!n_.abort_if_almost_done())
+        {
+            c->notify();
+            return wait_and_call(STATE(call_batch));
+        }
+    }
+    return call_immediately(STATE(iterate_next));
+}
+
 } /* namespace openlcb */
@@ -88,6 +88,15 @@ public:
      * handled. */
     bool event_processing_pending();
 
+    /** Selects how matching event handlers are called for an incoming
+     * message. The default comes from the event_batched_dispatch constant.
+     *
+     * @param batched if true, up to a handful of handlers are collected and
+     * called back-to-back in one step, which is faster when many handlers
+     * match. If false, every handler call is a separate step, so other flows
+     * on the executor get a chance to run in between. */
+    void set_batched_dispatch(bool batched);
+
     static EventService *instance;
 
 private:
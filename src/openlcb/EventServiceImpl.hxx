@@ -56,6 +56,11 @@ class EventHandler;
 struct EventHandlerCall
 {
     const EventRegistryEntry *registry_entry;
+    /// If not null, the call is for a batch of batch_size handlers (and
+    /// registry_entry is unused). The array is owned by the sender, which
+    /// must keep it alive until the buffer is released.
+    const EventRegistryEntry *const *batch;
+    unsigned batch_size;
     EventReport *rep;
     EventHandlerFunction fn;
     unsigned epoch;
@@ -63,6 +68,18 @@ struct EventHandlerCall
         EventReport *rep, EventHandlerFunction fn)
     {
         this->registry_entry = entry;
+        this->batch = nullptr;
+        this->batch_size = 0;
+        this->rep = rep;
+        this->fn = fn;
+        this->epoch = epoch;
+    }
+    void reset_batch(const EventRegistryEntry *const *entries, unsigned count,
+        unsigned epoch, EventReport *rep, EventHandlerFunction fn)
+    {
+        this->registry_entry = nullptr;
+        this->batch = entries;
+        this->batch_size = count;
         this->rep = rep;
         this->fn = fn;
         this->epoch = epoch;
@@ -74,6 +91,9 @@ struct EventHandlerCall
 /// handler. In essence this control flow behaves as a global lock for the
 /// event handlers being called. This global lock is necessary, because the
 /// event handlers are using global buffers for holding the outgoing packets.
+///
+/// A batch call runs the handlers one after the other. The flow only goes
+/// back to the executor when a handler did not finish synchronously.
 class EventCallerFlow : public StateFlow<Buffer<EventHandlerCall>, QList<5>>
 {
 public:
@@ -83,8 +103,12 @@ public:
 private:
     virtual Action entry() OVERRIDE;
     Action call_done();
+    /// Calls the remaining handlers of a batch.
+    Action call_batch();
 
     BarrierNotifiable n_;
+    /// Index of the next handler to call in the current batch.
+    unsigned batchNext_;
 };
 
 /// PImpl class for the EventService. This class creates and owns all
@@ -107,6 +131,12 @@ public:
     /// calls need to be sent to this flow.
     EventCallerFlow callerFlow_;
 
+    /// If true, the iterator flows collect up to
+    /// EventIteratorFlow::MAX_BATCH matching handlers and call them in one
+    /// go. If false, each handler call is a separate step of the flow, which
+    /// lets other flows run in between.
+    bool batchedDispatch_;
+
     enum
     {
         // These address/mask should match all the messages carrying an event
@@ -135,8 +165,17 @@ protected:
     Action entry() OVERRIDE;
     Action iterate_next();
 
+    /// Largest number of handlers that are called in one batch.
+    static constexpr unsigned MAX_BATCH = 8;
+
 private:
     virtual Action dispatch_event(const EventRegistryEntry *entry);
+    /// Calls the handlers in batch_[0..batchSize_). Used in batched dispatch
+    /// mode instead of dispatch_event. Must continue with iterate_next.
+    virtual Action dispatch_batch();
+
+    /// Finishes processing the current incoming message.
+    Action iteration_done();
 
 protected:
     EventService *eventService_;
@@ -158,6 +197,11 @@ protected:
     BarrierNotifiable n_;
     EventHandlerFunction fn_;
 
+    /// Matching handlers collected for batched dispatch.
+    const EventRegistryEntry *batch_[MAX_BATCH];
+    /// Number of valid entries in batch_.
+    unsigned batchSize_{0};
+
 #ifdef DEBUG_EVENT_PERFORMANCE
     static const int REPORT_COUNT = 100;
     /// How many events' cost are accumulated so far.
@@ -185,9 +229,14 @@ public:
 
 private:
     Action dispatch_event(const EventRegistryEntry *entry) OVERRIDE;
+    Action dispatch_batch() OVERRIDE;
+    /// Calls the remaining handlers in batch_.
+    Action call_batch();
 
     /// The handler we need to call.
     const EventRegistryEntry *currentEntry_{nullptr};
+    /// Index of the next handler to call in batch_.
+    unsigned batchNext_{0};
 };
 
 } // namespace openlcb
@@ -0,0 +1,438 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file FlatAliasCache.cxx
+ * Alias to Node ID mapping storage using flat open-addressed hash tables.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#include "openlcb/FlatAliasCache.hxx"
+
+#include <string.h>
+
+#include <vector>
+
+namespace openlcb
+{
+
+/// Mask of the valid bits of a Node ID.
+static const uint64_t NODE_ID_MASK = 0xFFFFFFFFFFFFULL;
+
+constexpr FlatAliasCache::Index FlatAliasCache::NONE;
+
+template <typename Slot> void FlatAliasCache::Table<Slot>::init(size_t entries)
+{
+    // Keeps the load factor at or below 1/2.
+    unsigned bits = 2;
+    while ((1u << bits) < entries * 2)
+    {
+        ++bits;
+    }
+    mask_ = (1u << bits) - 1;
+    shift_ = sizeof(Slot) * 8 - bits;
+    slots_.reset(new Slot[mask_ + 1]);
+    clear();
+}
+
+template <typename Slot> void FlatAliasCache::Table<Slot>::clear()
+{
+    memset(slots_.get(), 0, sizeof(Slot) * (mask_ + 1));
+}
+
+template <typename Slot> unsigned FlatAliasCache::Table<Slot>::home(Slot key)
+{
+    // Fibonacci hashing: the top bits of the product are well mixed.
+    const Slot mult = sizeof(Slot) == 8 ? (Slot)0x9E3779B97F4A7C15ULL
+                                        : (Slot)0x9E3779B1U;
+    return (Slot)(key * mult) >> shift_;
+}
+
+template <typename Slot> int FlatAliasCache::Table<Slot>::find(Slot key)
+{
+    for (unsigned pos = home(key);; pos = (pos + 1) & mask_)
+    {
+        Slot s = slots_[pos];
+        if (!s)
+        {
+            return -1;
+        }
+        if ((s >> 16) == key)
+        {
+            return pos;
+        }
+    }
+}
+
+template <typename Slot>
+void FlatAliasCache::Table<Slot>::insert(Slot key, Index index)
+{
+    unsigned pos = home(key);
+    while (slots_[pos])
+    {
+        pos = (pos + 1) & mask_;
+    }
+    slots_[pos] = (key << 16) | (Slot)(index + 1);
+}
+
+template <typename Slot> void FlatAliasCache::Table<Slot>::erase_at(int pos)
+{
+    unsigned hole = pos;
+    unsigned next = hole;
+    while (true)
+    {
+        next = (next + 1) & mask_;
+        Slot s = slots_[next];
+        if (!s)
+        {
+            break;
+        }
+        unsigned h = home(s >> 16);
+        // The key in slot next may be moved into the hole if its home slot is
+        // not cyclically in (hole, next].
+        bool stays = hole < next ? (hole < h && h <= next)
+                                 : (hole < h || h <= next);
+        if (!stays)
+        {
+            slots_[hole] = s;
+            hole = next;
+        }
+    }
+    slots_[hole] = 0;
+}
+
+template <typename Slot> unsigned FlatAliasCache::Table<Slot>::count()
+{
+    unsigned ret = 0;
+    for (unsigned i = 0; i <= mask_; ++i)
+    {
+        if (slots_[i])
+        {
+            ++ret;
+        }
+    }
+    return ret;
+}
+
+FlatAliasCache::FlatAliasCache(size_t entries,
+    void (*remove_callback)(NodeID id, NodeAlias alias, void *), void *context)
+    : pool_(new Entry[entries])
+    , numEntries_(entries)
+    , removeCallback_(remove_callback)
+    , context_(context)
+{
+    static_assert(sizeof(Entry) == 16, "Entry is not packed");
+    HASSERT(entries > 0 && entries < NONE);
+    aliasTable_.init(entries);
+    idTable_.init(entries);
+    clear();
+}
+
+FlatAliasCache::~FlatAliasCache()
+{
+}
+
+void FlatAliasCache::clear()
+{
+    aliasTable_.clear();
+    idTable_.clear();
+    oldest_ = NONE;
+    newest_ = NONE;
+    freeList_ = NONE;
+    for (size_t i = numEntries_; i-- > 0;)
+    {
+        pool_[i].id = 0;
+        pool_[i].alias = 0;
+        pool_[i].newer = NONE;
+        pool_[i].older = freeList_;
+        freeList_ = i;
+    }
+}
+
+void FlatAliasCache::add(NodeID id, NodeAlias alias)
+{
+    HASSERT(id != 0);
+    HASSERT(alias != 0);
+
+    int pos = aliasTable_.find(alias);
+    if (pos >= 0)
+    {
+        /* we already have a mapping for this alias, so lets remove it */
+        Index index = aliasTable_.index_at(pos);
+        NodeID old_id = pool_[index].id;
+        unlink(index, pos);
+        if (removeCallback_)
+        {
+            (*removeCallback_)(old_id, alias, context_);
+        }
+    }
+
+    Index insert;
+    if (freeList_ != NONE)
+    {
+        insert = freeList_;
+        freeList_ = pool_[insert].older;
+    }
+    else
+    {
+        /* kick out the oldest mapping */
+        insert = oldest_;
+        HASSERT(insert != NONE);
+        NodeID old_id = pool_[insert].id;
+        NodeAlias old_alias = pool_[insert].alias;
+        unlink(insert, aliasTable_.find(old_alias));
+        // unlink put it onto the free list.
+        freeList_ = pool_[insert].older;
+        if (removeCallback_)
+        {
+            (*removeCallback_)(old_id, old_alias, context_);
+        }
+    }
+
+    Entry *e = &pool_[insert];
+    e->id = id;
+    e->alias = alias;
+    aliasTable_.insert(alias, insert);
+    uint64_t key = id & NODE_ID_MASK;
+    int id_pos = idTable_.find(key);
+    if (id_pos >= 0)
+    {
+        // Same as the tree implementation: the Node ID is now pointing to the
+        // newest alias, while the old alias still maps to the Node ID.
+        idTable_.set_index_at(id_pos, insert);
+    }
+    else
+    {
+        idTable_.insert(key, insert);
+    }
+    link_newest(insert);
+}
+
+void FlatAliasCache::remove(NodeAlias alias)
+{
+    int pos = aliasTable_.find(alias);
+    if (pos >= 0)
+    {
+        unlink(aliasTable_.index_at(pos), pos);
+    }
+}
+
+NodeAlias FlatAliasCache::lookup(NodeID id)
+{
+    HASSERT(id != 0);
+    int pos = idTable_.find(id & NODE_ID_MASK);
+    if (pos < 0)
+    {
+        return 0;
+    }
+    Index index = idTable_.index_at(pos);
+    touch(index);
+    return pool_[index].alias;
+}
+
+NodeID FlatAliasCache::lookup(NodeAlias alias)
+{
+    HASSERT(alias != 0);
+    int pos = aliasTable_.find(alias);
+    if (pos < 0)
+    {
+        return 0;
+    }
+    Index index = aliasTable_.index_at(pos);
+    touch(index);
+    return pool_[index].id;
+}
+
+void FlatAliasCache::for_each(
+    void (*callback)(void *, NodeID, NodeAlias), void *context)
+{
+    HASSERT(callback != nullptr);
+    for (Index i = newest_; i != NONE; i = pool_[i].older)
+    {
+        (*callback)(context, pool_[i].id, pool_[i].alias);
+    }
+}
+
+bool FlatAliasCache::retrieve(unsigned entry, NodeID *node, NodeAlias *alias)
+{
+    HASSERT(entry < size());
+    Entry *e = &pool_[entry];
+    if (!e->alias)
+    {
+        return false;
+    }
+    if (node)
+    {
+        *node = e->id;
+    }
+    if (alias)
+    {
+        *alias = e->alias;
+    }
+    return true;
+}
+
+void FlatAliasCache::unlink(Index index, int alias_pos)
+{
+    Entry *e = &pool_[index];
+    aliasTable_.erase_at(alias_pos);
+    int id_pos = idTable_.find(e->id & NODE_ID_MASK);
+    // The Node ID may be pointing to a newer alias of the same node.
+    if (id_pos >= 0 && idTable_.index_at(id_pos) == index)
+    {
+        idTable_.erase_at(id_pos);
+    }
+
+    if (e->newer != NONE)
+    {
+        pool_[e->newer].older = e->older;
+    }
+    else
+    {
+        newest_ = e->older;
+    }
+    if (e->older != NONE)
+    {
+        pool_[e->older].newer = e->newer;
+    }
+    else
+    {
+        oldest_ = e->newer;
+    }
+
+    e->id = 0;
+    e->alias = 0;
+    e->newer = NONE;
+    e->older = freeList_;
+    freeList_ = index;
+}
+
+void FlatAliasCache::link_newest(Index index)
+{
+    Entry *e = &pool_[index];
+    e->newer = NONE;
+    e->older = newest_;
+    if (newest_ != NONE)
+    {
+        pool_[newest_].newer = index;
+    }
+    else
+    {
+        oldest_ = index;
+    }
+    newest_ = index;
+}
+
+int FlatAliasCache::check_consistency()
+{
+    std::vector<bool> is_free(numEntries_);
+    unsigned num_free = 0;
+    for (Index i = freeList_; i != NONE; i = pool_[i].older)
+    {
+        if (i >= numEntries_)
+        {
+            return 1;
+        }
+        if (is_free[i])
+        {
+            return 2; // duplicate entry on the free list
+        }
+        is_free[i] = true;
+        ++num_free;
+        if (pool_[i].alias)
+        {
+            return 3;
+        }
+    }
+    unsigned num_used = 0;
+    Index prev = NONE;
+    for (Index i = oldest_; i != NONE; i = pool_[i].newer)
+    {
+        if (i >= numEntries_)
+        {
+            return 4;
+        }
+        if (is_free[i])
+        {
+            return 5; // entry is both free and in use
+        }
+        if (pool_[i].older != prev)
+        {
+            return 6;
+        }
+        if (!pool_[i].alias)
+        {
+            return 7;
+        }
+        prev = i;
+        if (++num_used > numEntries_)
+        {
+            return 8; // loop in the list
+        }
+    }
+    if (prev != newest_)
+    {
+        return 9;
+    }
+    if (num_used + num_free != numEntries_)
+    {
+        return 10; // lost some entries
+    }
+    if (aliasTable_.count() != num_used)
+    {
+        return 11;
+    }
+    for (unsigned i = 0; i < numEntries_; ++i)
+    {
+        if (is_free[i])
+        {
+            continue;
+        }
+        int pos = aliasTable_.find(pool_[i].alias);
+        if (pos < 0 || aliasTable_.index_at(pos) != i)
+        {
+            return 12;
+        }
+        pos = idTable_.find(pool_[i].id & NODE_ID_MASK);
+        if (pos < 0)
+        {
+            return 13;
+        }
+        Index idx = idTable_.index_at(pos);
+        if (is_free[idx] || pool_[idx].id != pool_[i].id)
+        {
+            return 14;
+        }
+    }
+    if (idTable_.count() > num_used)
+    {
+        return 15;
+    }
+    return 0;
+}
+
+} // namespace openlcb
@@ -0,0 +1,253 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file FlatAliasCache.hxx
+ * Alias to Node ID mapping storage using flat open-addressed hash tables.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#ifndef _OPENLCB_FLATALIASCACHE_HXX_
+#define _OPENLCB_FLATALIASCACHE_HXX_
+
+#include <memory>
+
+#include "openlcb/Defs.hxx"
+#include "utils/macros.h"
+
+namespace openlcb
+{
+
+/** Storage backend of @ref AliasCache that does not use any tree nodes or
+ * pointers. All memory is allocated at construction.
+ *
+ * The mappings live in an array of 16-byte entries, which are linked into a
+ * least-recently-used list by 16-bit indexes. Two open-addressed hash tables
+ * with linear probing index the entries by alias and by Node ID. Each hash
+ * slot packs the key together with the entry index, so that a lookup touches
+ * only consecutive slots of one table, plus the entry itself when it is found.
+ * Removals use backward shift deletion, so there are no tombstones.
+ *
+ * The semantics are the same as of AliasCache, except that no timestamps are
+ * kept. Note, there is no mutual exclusion locking mechanism built into this
+ * class. */
+class FlatAliasCache
+{
+public:
+    /** Constructor.
+     * @param entries maximum number of entries in this cache, at most 65534
+     * @param remove_callback callback to call when we remove a mapping from
+     *        the cache however it will not be called in the remove() method
+     * @param context context pointer to pass to remove_callback
+     */
+    FlatAliasCache(size_t entries,
+        void (*remove_callback)(NodeID id, NodeAlias alias, void *) = nullptr,
+        void *context = nullptr);
+
+    ~FlatAliasCache();
+
+    /** Reinitializes the entire map. */
+    void clear();
+
+    /** Add an alias to an alias cache.
+     * @param id 48-bit NMRAnet Node ID to associate alias with
+     * @param alias 12-bit alias associated with Node ID
+     */
+    void add(NodeID id, NodeAlias alias);
+
+    /** Remove an alias from an alias cache.  This method does not call the
+     * remove_callback method passed in at construction.
+     * @param alias 12-bit alias associated with Node ID
+     */
+    void remove(NodeAlias alias);
+
+    /** Lookup a node's alias based on its Node ID.
+     * @param id Node ID to look for
+     * @return alias that matches the Node ID, else 0 if not found
+     */
+    NodeAlias lookup(NodeID id);
+
+    /** Lookup a node's ID based on its alias.
+     * @param alias alias to look for
+     * @return Node ID that matches the alias, else 0 if not found
+     */
+    NodeID lookup(NodeAlias alias);
+
+    /** Call the given callback function once for each alias tracked, in last
+     * "touched" order.
+     * @param callback method to call
+     * @param context context pointer to pass to callback
+     */
+    void for_each(void (*callback)(void *, NodeID, NodeAlias), void *context);
+
+    /** @return the total number of aliases that can be cached. */
+    size_t size()
+    {
+        return numEntries_;
+    }
+
+    /** Retrieves an entry by index.
+     * @param entry is between 0 and size() - 1.
+     * @param node will be filled with the node ID. May be null.
+     * @param alias will be filled with the alias. May be null.
+     * @return true if the entry is valid, false if it is not allocated. */
+    bool retrieve(unsigned entry, NodeID *node, NodeAlias *alias);
+
+    /** Visible for testing. Check internal consistency.
+     * @return 0 if everything is fine, otherwise an error code. */
+    int check_consistency();
+
+private:
+    /// Type of an entry index.
+    typedef uint16_t Index;
+    /// Marks the end of a list.
+    static constexpr Index NONE = 0xFFFF;
+
+    /// One alias mapping. Exactly 16 bytes.
+    struct Entry
+    {
+        /// 48-bit Node ID.
+        NodeID id;
+        /// Alias, zero if this entry is free.
+        NodeAlias alias;
+        /// Index of the next newer entry or NONE.
+        Index newer;
+        /// Index of the next older entry or NONE. Links the free list too.
+        Index older;
+        /// Padding.
+        uint16_t unused;
+    };
+
+    /** Open-addressed hash table with linear probing. A slot contains the key
+     * shifted up by 16 bits, and in the low 16 bits the index of the entry
+     * plus one. Zero marks an empty slot.
+     * @param Slot is uint32_t for the alias table and uint64_t for the Node ID
+     * table. */
+    template <typename Slot> class Table
+    {
+    public:
+        /// Allocates the table. @param entries is the maximum number of keys
+        /// that will be stored.
+        void init(size_t entries);
+
+        /// Empties the table.
+        void clear();
+
+        /// @param key to look for. @return the slot number where the key is,
+        /// or -1 if the key is not in the table.
+        int find(Slot key);
+
+        /// @param pos slot number (must be valid). @return the entry index
+        /// stored in the slot.
+        Index index_at(int pos)
+        {
+            return (slots_[pos] & 0xFFFF) - 1;
+        }
+
+        /// Overwrites the entry index of a slot. @param pos the slot number
+        /// (must be valid). @param index new entry index.
+        void set_index_at(int pos, Index index)
+        {
+            slots_[pos] = (slots_[pos] & ~(Slot)0xFFFF) | (Slot)(index + 1);
+        }
+
+        /// Adds a key. @param key must not be in the table yet. @param index
+        /// is the entry index to store with it.
+        void insert(Slot key, Index index);
+
+        /// Removes a key from the table. @param pos slot number of the key.
+        void erase_at(int pos);
+
+        /// @return the number of keys in the table.
+        unsigned count();
+
+    private:
+        /// @param key a key. @return the first slot to look for the key.
+        unsigned home(Slot key);
+
+        /// The slots.
+        std::unique_ptr<Slot[]> slots_;
+        /// Number of slots minus one. The number of slots is a power of two.
+        unsigned mask_;
+        /// How many bits to shift the hash product down by.
+        unsigned shift_;
+    };
+
+    /// Unlinks an entry from the LRU list and removes it from the hash tables.
+    /// @param index which entry. @param alias_pos slot of the entry in the
+    /// alias table.
+    void unlink(Index index, int alias_pos);
+
+    /// Puts an entry at the newest end of the LRU list. @param index which
+    /// entry.
+    void link_newest(Index index);
+
+    /// Moves an entry to the newest end of the LRU list. @param index which
+    /// entry.
+    void touch(Index index)
+    {
+        if (index != newest_)
+        {
+            Entry *e = &pool_[index];
+            if (e->older != NONE)
+            {
+                pool_[e->older].newer = e->newer;
+            }
+            else
+            {
+                oldest_ = e->newer;
+            }
+            pool_[e->newer].older = e->older;
+            link_newest(index);
+        }
+    }
+
+    /// All entries.
+    std::unique_ptr<Entry[]> pool_;
+    /// Index of the alias -> entry.
+    Table<uint32_t> aliasTable_;
+    /// Index of the Node ID -> entry.
+    Table<uint64_t> idTable_;
+    /// Head of the free list of entries.
+    Index freeList_;
+    /// Least recently touched entry.
+    Index oldest_;
+    /// Most recently touched entry.
+    Index newest_;
+    /// Total number of entries.
+    size_t numEntries_;
+    /// callback function to be used when we remove an entry from the cache.
+    void (*removeCallback_)(NodeID id, NodeAlias alias, void *);
+    /// context pointer to pass in with remove_callback.
+    void *context_;
+
+    DISALLOW_COPY_AND_ASSIGN(FlatAliasCache);
+};
+
+} // namespace openlcb
+
+#endif // _OPENLCB_FLATALIASCACHE_HXX_
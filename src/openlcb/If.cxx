@@ -34,6 +34,9 @@
 
 #include "openlcb/If.hxx"
 
+#include "nmranet_config.h"
+#include "utils/Atomic.hxx"
+
 /// Ensures that the largest bucket in the main buffer pool is exactly the size
 /// of a GenMessage.
 const unsigned LARGEST_BUFFERPOOL_BUCKET = sizeof(Buffer<openlcb::GenMessage>);
@@ -119,11 +122,12 @@ void buffer_to_error(const Payload &payload, uint16_t *error_code,
         error_message->clear();
     if (payload.size() >= 2 && error_code)
     {
-        *error_code = (((uint16_t)payload[0]) << 8) | payload[1];
+        *error_code = (((uint16_t)(uint8_t)payload[0]) << 8) |
+            (uint8_t)payload[1];
     }
     if (payload.size() >= 4 && mti)
     {
-        *mti = (((uint16_t)payload[2]) << 8) | payload[3];
+        *mti = (((uint16_t)(uint8_t)payload[2]) << 8) | (uint8_t)payload[3];
     }
     if (payload.size() > 4 && error_message)
     {
@@ -142,6 +146,128 @@ void send_event(Node* src_node, uint64_t event_id)
 
 string EMPTY_PAYLOAD;
 
+namespace
+{
+
+/// Keeps the heap storage of released payloads for reuse, so that the
+/// messages flowing through the stack do not need a malloc and free each.
+class PayloadCache : public Atomic
+{
+public:
+    /// Payloads with larger storage than this are not kept.
+    static constexpr size_t MAX_CAPACITY = 512;
+
+    PayloadCache()
+        : size_(config_payload_cache_size())
+        , entries_(new Payload[size_])
+        , inlineCapacity_(Payload().capacity())
+    {
+    }
+
+    /// @param p payload
+    /// @return true if the payload's storage is on the heap and not too big
+    /// to keep.
+    bool is_cacheable(const Payload &p)
+    {
+        return p.capacity() > inlineCapacity_ && p.capacity() <= MAX_CAPACITY;
+    }
+
+    /// Replaces the storage of p with a cached chunk of at least size bytes.
+    /// @return false if there is no such chunk.
+    bool take(Payload *p, size_t size)
+    {
+        Payload chunk;
+        {
+            AtomicHolder h(this);
+            unsigned i;
+            for (i = 0; i < count_ && entries_[i].capacity() < size; ++i)
+            {
+            }
+            if (i >= count_)
+            {
+                return false;
+            }
+            chunk.swap(entries_[i]);
+            entries_[i].swap(entries_[--count_]);
+        }
+        chunk.assign(*p);
+        p->swap(chunk);
+        put(&chunk);
+        return true;
+    }
+
+    /// Moves the storage of p into the cache if there is room. p is empty
+    /// afterwards.
+    void put(Payload *p)
+    {
+        p->clear();
+        if (!is_cacheable(*p))
+        {
+            return;
+        }
+        AtomicHolder h(this);
+        if (count_ < size_)
+        {
+            entries_[count_++].swap(*p);
+        }
+    }
+
+private:
+    /// Maximum number of cached chunks.
+    unsigned size_;
+    /// Number of cached chunks; these are at the beginning of entries_.
+    unsigned count_{0};
+    /// Cached chunks.
+    Payload *entries_;
+    /// Capacity of an empty string, i.e., its inline storage.
+    size_t inlineCapacity_;
+};
+
+/// @return the process-wide payload cache.
+PayloadCache *payload_cache()
+{
+    // Never destroyed, because messages may be freed during static
+    // destruction.
+    static PayloadCache *cache = new PayloadCache();
+    return cache;
+}
+
+} // namespace
+
+void payload_reserve(Payload *p, size_t size)
+{
+    if (p->capacity() >= size)
+    {
+        return;
+    }
+    if (!payload_reserve_cached(p, size))
+    {
+        p->reserve(size);
+    }
+}
+
+bool payload_reserve_cached(Payload *p, size_t size)
+{
+    if (p->capacity() >= size)
+    {
+        return true;
+    }
+    if (!config_payload_cache_size())
+    {
+        return false;
+    }
+    return payload_cache()->take(p, size);
+}
+
+void payload_recycle(Payload *p)
+{
+    if (!config_payload_cache_size())
+    {
+        return;
+    }
+    payload_cache()->put(p);
+}
+
 /*Buffer *node_id_to_buffer(NodeID id)
 {
     Buffer *ret = buffer_alloc(6);
@@ -169,6 +295,8 @@ If::If(ExecutorBase *executor, int local_nodes_count)
     , dispatcher_(this)
     , localNodes_(local_nodes_count)
 {
+    // Most protocol handlers register for an exact MTI.
+    dispatcher_.set_indexed_dispatch(true);
 }
 
 } // namespace openlcb
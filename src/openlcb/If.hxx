@@ -127,6 +127,27 @@ extern void buffer_to_error(const Payload& payload, uint16_t* error_code, uint16
 /** A global class / variable for empty or not-yet-initialized payloads. */
 extern string EMPTY_PAYLOAD;
 
+/** Makes sure that a payload has room for at least size bytes without
+ * reallocating. The storage is taken from the payload cache if it has a large
+ * enough chunk, otherwise it is allocated. The contents of the payload are
+ * kept. Payloads that fit the inline storage of the string need no call.
+ * @param p the payload to grow.
+ * @param size number of bytes needed. */
+extern void payload_reserve(Payload *p, size_t size);
+
+/** Like payload_reserve(), but only takes storage from the payload cache;
+ * never allocates.
+ * @param p the payload to grow.
+ * @param size number of bytes needed.
+ * @return true if the payload now has room for size bytes, false if the
+ * cache had no large enough chunk (p is unchanged then). */
+extern bool payload_reserve_cached(Payload *p, size_t size);
+
+/** Clears a payload and hands its heap storage (if any) to the payload cache,
+ * where the next payload_reserve() call can pick it up.
+ * @param p the payload to release. */
+extern void payload_recycle(Payload *p);
+
 /// @return the high 4 bytes of a node ID. @param id is the node ID.
 inline unsigned node_high(NodeID id) {
     return id >> 32;
@@ -155,6 +176,57 @@ struct GenMessage
     GenMessage()
         : src({0, 0}), dst({0, 0}), flagsSrc(0), flagsDst(0) {}
 
+    /// Copy constructor. The payload storage comes from the payload cache.
+    GenMessage(const GenMessage &o)
+        : src(o.src), dst(o.dst), mti(o.mti), dstNode(o.dstNode),
+          flagsSrc(o.flagsSrc), flagsDst(o.flagsDst)
+    {
+        payload_reserve(&payload, o.payload.size());
+        payload.assign(o.payload);
+    }
+
+    /// Assignment operator (used by the dispatcher to give each handler its
+    /// own copy). The payload storage comes from the payload cache.
+    GenMessage &operator=(const GenMessage &o)
+    {
+        src = o.src;
+        dst = o.dst;
+        mti = o.mti;
+        dstNode = o.dstNode;
+        payload_reserve(&payload, o.payload.size());
+        payload.assign(o.payload);
+        flagsSrc = o.flagsSrc;
+        flagsDst = o.flagsDst;
+        return *this;
+    }
+
+    /// Move constructor. Takes over the payload storage of o.
+    GenMessage(GenMessage &&o)
+        : src(o.src), dst(o.dst), mti(o.mti), dstNode(o.dstNode),
+          flagsSrc(o.flagsSrc), flagsDst(o.flagsDst)
+    {
+        payload.swap(o.payload);
+    }
+
+    /// Move assignment. Swaps the payloads, so that the old storage of this
+    /// message gets recycled when o is destroyed.
+    GenMessage &operator=(GenMessage &&o)
+    {
+        src = o.src;
+        dst = o.dst;
+        mti = o.mti;
+        dstNode = o.dstNode;
+        payload.swap(o.payload);
+        flagsSrc = o.flagsSrc;
+        flagsDst = o.flagsDst;
+        return *this;
+    }
+
+    ~GenMessage()
+    {
+        payload_recycle(&payload);
+    }
+
     void clear()
     {
         reset((Defs::MTI)0, 0, EMPTY_PAYLOAD);
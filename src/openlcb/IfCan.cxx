@@ -526,7 +526,10 @@ public:
         CAN_MASK = CanMessageData::CAN_EXT_FRAME_MASK |
             CanDefs::CAN_FRAME_TYPE_MASK | CanDefs::FRAME_TYPE_MASK |
             CanDefs::PRIORITY_MASK |
-            (Defs::MTI_ADDRESS_MASK << CanDefs::MTI_SHIFT)
+            (Defs::MTI_ADDRESS_MASK << CanDefs::MTI_SHIFT),
+        /// How many bytes to take from the payload cache (if it has a chunk)
+        /// when the first frame of a multi-frame message arrives.
+        MULTI_FRAME_RESERVE = 64,
     };
 
     FrameToAddressedMessageParser(IfCan *service)
@@ -589,6 +592,9 @@ public:
                         (unsigned)id_, f->data[0], f->data[1]);
                 }
                 mapped_buffer->clear();
+                // Enough for most multi-frame messages, e.g. SNIP replies.
+                // Without a cached chunk the payload grows as frames arrive.
+                payload_reserve_cached(mapped_buffer, MULTI_FRAME_RESERVE);
             }
             if (f->can_dlc > 2)
             {
@@ -655,13 +661,94 @@ private:
     StlMap<uint32_t, Payload> pendingBuffers_;
 };
 
+/** This class listens for incoming stream data frames destined for local
+ * nodes, and translates each of them into a stream data message. The payload
+ * of the message is the destination stream ID followed by the data bytes. */
+class FrameToStreamDataParser : public CanFrameStateFlow
+{
+public:
+    enum
+    {
+        CAN_FILTER = CanMessageData::CAN_EXT_FRAME_FILTER |
+            (CanDefs::STREAM_DATA << CanDefs::CAN_FRAME_TYPE_SHIFT) |
+            (CanDefs::NMRANET_MSG << CanDefs::FRAME_TYPE_SHIFT) |
+            (CanDefs::NORMAL_PRIORITY << CanDefs::PRIORITY_SHIFT),
+        CAN_MASK = CanMessageData::CAN_EXT_FRAME_MASK |
+            CanDefs::CAN_FRAME_TYPE_MASK | CanDefs::FRAME_TYPE_MASK |
+            CanDefs::PRIORITY_MASK
+    };
+
+    FrameToStreamDataParser(IfCan *service)
+        : CanFrameStateFlow(service)
+    {
+        if_can()->frame_dispatcher()->register_handler(
+            this, CAN_FILTER, CAN_MASK);
+    }
+
+    ~FrameToStreamDataParser()
+    {
+        if_can()->frame_dispatcher()->unregister_handler(
+            this, CAN_FILTER, CAN_MASK);
+    }
+
+    /// Handler entry for incoming messages.
+    Action entry() override
+    {
+        struct can_frame *f = message()->data();
+        id_ = GET_CAN_FRAME_ID_EFF(*f);
+        if (f->can_dlc < 1)
+        {
+            // No destination stream ID.
+            return release_and_exit();
+        }
+        dstHandle_.alias = CanDefs::get_dst(id_);
+        dstHandle_.id = if_can()->local_aliases()->lookup(dstHandle_.alias);
+        if (!dstHandle_.id)
+        {
+            // Not destined for us.
+            return release_and_exit();
+        }
+        buf_.assign((const char *)f->data, f->can_dlc);
+        release();
+        return allocate_and_call(if_can()->dispatcher(), STATE(send_to_if));
+    }
+
+    Action send_to_if()
+    {
+        auto *b = get_allocation_result(if_can()->dispatcher());
+        GenMessage *m = b->data();
+        m->mti = Defs::MTI_STREAM_DATA;
+        m->payload.swap(buf_);
+        m->dst = dstHandle_;
+        m->dstNode = if_can()->lookup_local_node(dstHandle_.id);
+        m->src.alias = CanDefs::get_src(id_);
+        m->src.id = if_can()->remote_aliases()->lookup(m->src.alias);
+        if (!m->src.id)
+        {
+            m->src.id = if_can()->local_aliases()->lookup(m->src.alias);
+        }
+        if_can()->dispatcher()->send(b, b->data()->priority());
+        return exit();
+    }
+
+private:
+    /// CAN frame ID, saved from the incoming frame.
+    uint32_t id_;
+    /// Payload for the stream data message.
+    string buf_;
+    /// Destination node of the frame.
+    NodeHandle dstHandle_;
+};
+
 IfCan::IfCan(ExecutorBase *executor, CanHubFlow *device,
     int local_alias_cache_size, int remote_alias_cache_size,
-    int local_nodes_count)
+    int local_nodes_count, bool flat_alias_cache)
     : If(executor, local_nodes_count)
     , CanIf(this, device)
-    , localAliases_(0, local_alias_cache_size)
-    , remoteAliases_(0, remote_alias_cache_size)
+    , localAliases_(
+          0, local_alias_cache_size, nullptr, nullptr, flat_alias_cache)
+    , remoteAliases_(
+          0, remote_alias_cache_size, nullptr, nullptr, flat_alias_cache)
 {
     auto *gflow = new GlobalCanMessageWriteFlow(this);
     globalWriteFlow_ = gflow;
@@ -707,6 +794,7 @@ void IfCan::add_addressed_message_support()
     if (addressedWriteFlow_)
         return;
     add_owned_flow(new FrameToAddressedMessageParser(this));
+    add_owned_flow(new FrameToStreamDataParser(this));
     auto *f = new AddressedCanMessageWriteFlow(this);
     addressedWriteFlow_ = f;
     add_owned_flow(f);
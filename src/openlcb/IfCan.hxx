@@ -81,10 +81,14 @@ public:
      * of for remote nodes on the bus.
      *
      * @param local_nodes_count is the maximum number of virtual nodes that
-     * this interface will support. */
+     * this interface will support.
+     *
+     * @param flat_alias_cache true to use the flat hash table implementation
+     * for the alias caches (see @ref FlatAliasCache). Recommended for large
+     * remote alias caches (e.g. on gateways). */
     IfCan(ExecutorBase *executor, CanHubFlow *device,
         int local_alias_cache_size, int remote_alias_cache_size,
-        int local_nodes_count);
+        int local_nodes_count, bool flat_alias_cache = false);
 
     ~IfCan();
 
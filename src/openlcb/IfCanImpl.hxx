@@ -39,6 +39,7 @@
 #include "executor/StateFlow.hxx"
 #include "openlcb/IfImpl.hxx"
 #include "openlcb/AliasAllocator.hxx"
+#include "nmranet_config.h"
 
 namespace openlcb
 {
@@ -183,14 +184,71 @@ private:
     virtual Action fill_can_frame_buffer()
     {
         auto *b = get_allocation_result(if_can()->frame_write_flow());
-        b->set_done(message()->new_child());
-        struct can_frame *f = b->data()->mutable_frame();
+        if (!has_frames())
+        {
+            b->unref();
+            return call_immediately(STATE(send_finished));
+        }
+        return send_frame_burst(b);
+    }
+
+    /// Renders and sends the frames of the current message back-to-back,
+    /// starting at dataOffset_. The first frame buffer comes from the
+    /// asynchronous allocation of the target flow's pool, so that we respect
+    /// the back-pressure of the hub; the remaining frames of the burst are
+    /// allocated inline from the same pool. No other flow on this
+    /// executor can get between the frames of a burst, so they end up
+    /// contiguous and in order in the hub's queue.
+    /// @param b the allocated buffer for the first frame of the burst.
+    Action send_frame_burst(Buffer<CanHubData> *b)
+    {
+        unsigned budget = config_can_write_burst_frames();
+        while (true)
+        {
+            b->set_done(message()->new_child());
+            bool need_more_frames = fill_frame(b->data()->mutable_frame());
+            if_can()->frame_write_flow()->send(b);
+            if (!need_more_frames)
+            {
+                return call_immediately(STATE(send_finished));
+            }
+            if (budget <= 1)
+            {
+                // Yields to the executor before continuing with the rest.
+                return call_immediately(STATE(get_can_frame_buffer));
+            }
+            --budget;
+            b = if_can()->frame_write_flow()->alloc();
+        }
+    }
+
+protected:
+    /// @return true if the current message can be rendered to at least one
+    /// CAN frame, false if it should be dropped.
+    virtual bool has_frames()
+    {
+        if (nmsg()->mti == Defs::MTI_STREAM_DATA)
+        {
+            return !nmsg()->payload.empty();
+        }
         if (nmsg()->mti & (Defs::MTI_DATAGRAM_MASK | Defs::MTI_SPECIAL_MASK |
                            Defs::MTI_RESERVED_MASK))
         {
             // We don't know how to handle such an MTI in a generic way.
-            b->unref();
-            return call_immediately(STATE(send_finished));
+            return false;
+        }
+        return true;
+    }
+
+    /// Renders the next frame of the current message and advances
+    /// dataOffset_.
+    /// @param f the frame to fill in.
+    /// @return true if there are more frames to send after this one.
+    virtual bool fill_frame(struct can_frame *f)
+    {
+        if (nmsg()->mti == Defs::MTI_STREAM_DATA)
+        {
+            return fill_stream_data_frame(f);
         }
         // CAN has only 12 bits of MTI field, so we better fit.
         HASSERT(!(nmsg()->mti & ~0xfff));
@@ -243,15 +301,36 @@ private:
                 f->can_dlc = data.size();
             }
         }
-        if_can()->frame_write_flow()->send(b);
-        if (need_more_frames)
+        return need_more_frames;
+    }
+
+private:
+    /// Renders the next frame of a stream data message. The first byte of the
+    /// payload is the destination stream ID, which is repeated in every
+    /// frame, followed by up to 7 bytes of the data.
+    /// @param f the frame to fill in.
+    /// @return true if there are more frames to send after this one.
+    bool fill_stream_data_frame(struct can_frame *f)
+    {
+        const string &data = nmsg()->payload;
+        uint32_t can_id;
+        CanDefs::set_datagram_fields(
+            &can_id, srcAlias_, dstAlias_, CanDefs::STREAM_DATA);
+        SET_CAN_FRAME_ID_EFF(*f, can_id);
+        if (!dataOffset_)
         {
-            return call_immediately(STATE(get_can_frame_buffer));
+            dataOffset_ = 1;
         }
-        else
+        unsigned len = data.size() - dataOffset_;
+        if (len > 7)
         {
-            return call_immediately(STATE(send_finished));
+            len = 7;
         }
+        f->data[0] = data[0];
+        memcpy(f->data + 1, data.data() + dataOffset_, len);
+        f->can_dlc = 1 + len;
+        dataOffset_ += len;
+        return dataOffset_ < data.size();
     }
 };
 
@@ -164,6 +164,7 @@ public:
             LOG(WARNING, "TCP message to short.");
             return false;
         }
+        payload_reserve(&tgt->payload, payload_bytes);
         tgt->payload.assign(msg + payload_ofs, payload_bytes);
         return true;
     }
@@ -78,6 +78,8 @@ struct MemoryConfigDefs {
         COMMAND_READ_REPLY        = 0x50, /**< reply to read data from address space */
         COMMAND_READ_FAILED       = 0x58, /**< failed to read data from address space */
         COMMAND_READ_STREAM       = 0x60, /**< command to read data using a stream */
+        COMMAND_READ_STREAM_REPLY = 0x70, /**< reply to read data using a stream */
+        COMMAND_READ_STREAM_FAILED= 0x78, /**< failed to read data using a stream */
         COMMAND_MAX_FOR_RW        = 0x80, /**< command <= this value have fixed bit arrangement. */
         COMMAND_OPTIONS           = 0x80,
         COMMAND_OPTIONS_REPLY     = 0x82,
@@ -202,6 +204,66 @@ struct MemoryConfigDefs {
         return p;
     }
 
+    /// Creates a stream read request datagram.
+    /// @param space memory space to read
+    /// @param offset address of the first byte to read
+    /// @param dst_stream_id stream ID at the requester, which will receive
+    /// the data stream
+    /// @param count number of bytes to read, 0 to read until the end of the
+    /// memory space
+    /// @return datagram payload
+    static DatagramPayload read_stream_datagram(
+        uint8_t space, uint32_t offset, uint8_t dst_stream_id, uint32_t count)
+    {
+        DatagramPayload p;
+        p.reserve(13);
+        p.push_back(DatagramDefs::CONFIGURATION);
+        p.push_back(COMMAND_READ_STREAM);
+        p.push_back(0xff & (offset >> 24));
+        p.push_back(0xff & (offset >> 16));
+        p.push_back(0xff & (offset >> 8));
+        p.push_back(0xff & (offset));
+        if (is_special_space(space)) {
+            p[1] |= space & ~SPACE_SPECIAL;
+        } else {
+            p.push_back(space);
+        }
+        // The source stream ID is assigned by the remote node.
+        p.push_back(0xff);
+        p.push_back(dst_stream_id);
+        p.push_back(0xff & (count >> 24));
+        p.push_back(0xff & (count >> 16));
+        p.push_back(0xff & (count >> 8));
+        p.push_back(0xff & (count));
+        return p;
+    }
+
+    /// Creates a stream write request datagram.
+    /// @param space memory space to write
+    /// @param offset address of the first byte to write
+    /// @param src_stream_id stream ID at the requester, which will send the
+    /// data stream
+    /// @return datagram payload
+    static DatagramPayload write_stream_datagram(
+        uint8_t space, uint32_t offset, uint8_t src_stream_id)
+    {
+        DatagramPayload p;
+        p.reserve(8);
+        p.push_back(DatagramDefs::CONFIGURATION);
+        p.push_back(COMMAND_WRITE_STREAM);
+        p.push_back(0xff & (offset >> 24));
+        p.push_back(0xff & (offset >> 16));
+        p.push_back(0xff & (offset >> 8));
+        p.push_back(0xff & (offset));
+        if (is_special_space(space)) {
+            p[1] |= space & ~SPACE_SPECIAL;
+        } else {
+            p.push_back(space);
+        }
+        p.push_back(src_stream_id);
+        return p;
+    }
+
     /// @return true if the payload has minimum number of bytes you need in a
     /// read or write datagram message to cover for the necessary fields
     /// (command, offset, space).
@@ -548,6 +610,49 @@ public:
 };
 
 
+/// Carries out the stream read and stream write commands on behalf of the
+/// MemoryConfigHandler. The implementation is MemoryConfigStreamServer.
+class MemoryConfigStreamHandler
+{
+public:
+    /// Parameters of an incoming stream read or write command.
+    struct Request
+    {
+        /// Local node the command was sent to.
+        Node *node;
+        /// Node that sent the command.
+        NodeHandle remote;
+        /// Memory space to read or write.
+        MemorySpace *space;
+        /// Address of the first byte to read or write.
+        uint32_t address;
+        /// Number of bytes to read, 0 for until the end of the space. Unused
+        /// for writes.
+        uint32_t count;
+        /// Memory space number.
+        uint8_t spaceNumber;
+        /// Stream ID at the remote node: the destination stream ID for
+        /// reads, the source stream ID for writes.
+        uint8_t remoteStreamId;
+        /// true for the stream read command, false for stream write.
+        bool isRead;
+    };
+
+    virtual ~MemoryConfigStreamHandler()
+    {
+    }
+
+    /// @param is_read true for the stream read command, false for stream
+    /// write.
+    /// @return true if such a command can not be accepted now.
+    virtual bool is_busy(bool is_read) = 0;
+
+    /// Starts executing a command. Called after the command datagram was
+    /// acknowledged.
+    /// @param request the parameters of the command.
+    virtual void start(const Request &request) = 0;
+};
+
 /// Implementation of the Memory Access Configuration Protocol for OpenLCB.
 ///
 /// Usage: Create an instance of this object either for the specific virtual
@@ -633,6 +738,14 @@ public:
         HASSERT(client_ == client);
         client_ = nullptr;
     }
+
+    /// Registers the handler of the stream read and stream write commands.
+    /// Without one these commands are rejected.
+    /// @param handler the stream handler, or nullptr to unregister.
+    void set_stream_handler(MemoryConfigStreamHandler *handler)
+    {
+        streamHandler_ = handler;
+    }
     
 private:
     typedef MemorySpace::address_t address_t;
@@ -662,6 +775,13 @@ private:
         {
             return call_immediately(STATE(handle_write));
         }
+        else if ((cmd & MemoryConfigDefs::COMMAND_MASK) ==
+                MemoryConfigDefs::COMMAND_READ_STREAM ||
+            (cmd & MemoryConfigDefs::COMMAND_MASK) ==
+                MemoryConfigDefs::COMMAND_WRITE_STREAM)
+        {
+            return call_immediately(STATE(handle_stream));
+        }
         switch (cmd)
         {
             case MemoryConfigDefs::COMMAND_LOCK:
@@ -718,6 +838,8 @@ private:
             case MemoryConfigDefs::COMMAND_WRITE_STREAM_FAILED:
             case MemoryConfigDefs::COMMAND_READ_REPLY:
             case MemoryConfigDefs::COMMAND_READ_FAILED:
+            case MemoryConfigDefs::COMMAND_READ_STREAM_REPLY:
+            case MemoryConfigDefs::COMMAND_READ_STREAM_FAILED:
             case MemoryConfigDefs::COMMAND_OPTIONS_REPLY:
             case MemoryConfigDefs::COMMAND_INFORMATION_REPLY:
             case MemoryConfigDefs::COMMAND_LOCK_REPLY:
@@ -737,6 +859,11 @@ private:
 
     Action ok_response_sent() OVERRIDE
     {
+        if (isStreamPending_)
+        {
+            isStreamPending_ = 0;
+            streamHandler_->start(streamRequest_);
+        }
         if (!response_.empty())
         {
             return allocate_and_call(STATE(client_allocated),
@@ -810,9 +937,14 @@ private:
         response_.push_back(available_commands >> 8);
         response_.push_back(available_commands & 0xff);
         // Write lengths
-        response_.push_back(static_cast<char> (
-            MemoryConfigDefs::LENGTH_1 | MemoryConfigDefs::LENGTH_2 |
-            MemoryConfigDefs::LENGTH_4 | MemoryConfigDefs::LENGTH_ARBITRARY));
+        uint8_t write_lengths = MemoryConfigDefs::LENGTH_1 |
+            MemoryConfigDefs::LENGTH_2 | MemoryConfigDefs::LENGTH_4 |
+            MemoryConfigDefs::LENGTH_ARBITRARY;
+        if (streamHandler_)
+        {
+            write_lengths |= MemoryConfigDefs::LENGTH_STREAM;
+        }
+        response_.push_back(static_cast<char>(write_lengths));
 
         uint8_t min_space = 0xFF;
         uint8_t max_space = 0;
@@ -1042,6 +1174,58 @@ private:
         return respond_ok(DatagramClient::REPLY_PENDING);
     }
 
+    /// Validates a stream read or stream write command, and queues it for the
+    /// stream handler. The stream handler sends the reply datagram.
+    Action handle_stream()
+    {
+        bool is_read = (in_bytes()[1] & MemoryConfigDefs::COMMAND_MASK) ==
+            MemoryConfigDefs::COMMAND_READ_STREAM;
+        if (!streamHandler_)
+        {
+            return respond_reject(Defs::ERROR_UNIMPLEMENTED_SUBCMD);
+        }
+        size_t ofs = has_custom_space() ? 7 : 6;
+        // Reads have source and destination stream IDs and a count; writes
+        // have the source stream ID.
+        if (message()->data()->payload.size() < ofs + (is_read ? 6 : 1))
+        {
+            return respond_reject(Defs::ERROR_INVALID_ARGS_MESSAGE_TOO_SHORT);
+        }
+        MemorySpace *space = get_space();
+        if (!space)
+        {
+            return respond_reject(MemoryConfigDefs::ERROR_SPACE_NOT_KNOWN);
+        }
+        if (!is_read && space->read_only())
+        {
+            return respond_reject(MemoryConfigDefs::ERROR_WRITE_TO_RO);
+        }
+        if (streamHandler_->is_busy(is_read))
+        {
+            return respond_reject(DatagramClient::RESEND_OK);
+        }
+        const uint8_t *bytes = in_bytes();
+        streamRequest_.node = message()->data()->dst;
+        streamRequest_.remote = message()->data()->src;
+        streamRequest_.space = space;
+        streamRequest_.address = get_address();
+        streamRequest_.spaceNumber = get_space_number();
+        streamRequest_.isRead = is_read;
+        if (is_read)
+        {
+            streamRequest_.remoteStreamId = bytes[ofs + 1];
+            streamRequest_.count = (bytes[ofs + 2] << 24) |
+                (bytes[ofs + 3] << 16) | (bytes[ofs + 4] << 8) | bytes[ofs + 5];
+        }
+        else
+        {
+            streamRequest_.remoteStreamId = bytes[ofs];
+            streamRequest_.count = 0;
+        }
+        isStreamPending_ = 1;
+        return respond_ok(DatagramClient::REPLY_PENDING);
+    }
+
     /// @return true iff we have a custom space
     bool has_custom_space()
     {
@@ -1206,6 +1390,12 @@ private:
     /// If there is a memory config client, we will forward response traffic to
     /// it.
     DatagramHandlerFlow* client_{nullptr};
+    /// Executes the stream read and write commands.
+    MemoryConfigStreamHandler *streamHandler_{nullptr};
+    /// The stream command waiting for the datagram OK response to go out.
+    MemoryConfigStreamHandler::Request streamRequest_;
+    /// 1 if streamRequest_ needs to be started.
+    uint8_t isStreamPending_{0};
 
     /** Offset withing the current write/read datagram. This does not include
      * the offset from the incoming datagram. */
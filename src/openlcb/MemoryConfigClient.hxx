@@ -38,6 +38,8 @@
 #include "executor/CallableFlow.hxx"
 #include "openlcb/MemoryConfig.hxx"
 #include "openlcb/DatagramHandlerDefault.hxx"
+#include "openlcb/StreamReceiver.hxx"
+#include "openlcb/StreamSender.hxx"
 
 namespace openlcb
 {
@@ -217,6 +219,9 @@ public:
         : CallableFlow<MemoryConfigClientRequest>(memcfg->dg_service())
         , node_(node)
         , memoryConfigHandler_(memcfg)
+        , isWaitingForTimer_(0)
+        , windowed_(0)
+        , streaming_(0)
     {
     }
 
@@ -244,7 +249,64 @@ public:
         return memoryConfigHandler_;
     }
 
+    /// Maximum number of read or write datagrams in flight.
+    static constexpr unsigned MAX_WINDOW = 8;
+
+    /// Sets how many read or write datagrams the client may send before the
+    /// reply of the first one arrives. With a window of 1 (the default) every
+    /// datagram waits for the previous reply. With a larger window the replies
+    /// are matched to the requests by address and reassembled in order. If
+    /// the target rejects a request with a temporary error (e.g. it has no
+    /// buffer for it), the rest of that operation falls back to one datagram
+    /// at a time. Must not be called while a request is being processed.
+    /// @param window number of datagrams in flight, 1 to MAX_WINDOW.
+    void set_window(unsigned window)
+    {
+        HASSERT(window >= 1 && window <= MAX_WINDOW);
+        window_ = window;
+        if (window > 1 && !slots_)
+        {
+            slots_.reset(new WindowSlot[MAX_WINDOW]);
+        }
+    }
+
+    /// Enables using the stream read and stream write commands for reads and
+    /// writes. The data then moves in a single stream instead of one
+    /// datagram per 64 bytes. If the target does not support streams (it
+    /// rejects the command as unimplemented), or it is busy, the request is
+    /// executed with datagrams instead. Must not be called while a request
+    /// is being processed.
+    /// @param stream_service the stream service of the node's interface, or
+    /// nullptr to stop using streams.
+    void set_use_streams(StreamService *stream_service)
+    {
+        if (stream_service != streamService_)
+        {
+            streamSender_.reset();
+            streamReceiver_.reset();
+        }
+        streamService_ = stream_service;
+        if (streamService_ && !streamSender_)
+        {
+            streamSender_.reset(new StreamSender(streamService_));
+            streamReceiver_.reset(new StreamReceiver(streamService_));
+        }
+    }
+
 private:
+    /// One request in flight in windowed mode.
+    struct WindowSlot
+    {
+        /// Address of the first byte requested.
+        uint32_t address;
+        /// Number of bytes requested to read or sent to write.
+        uint8_t length;
+        /// True when the reply arrived.
+        bool done;
+        /// The reply datagram.
+        string payload;
+    };
+
     Action entry() override
     {
         request()->resultCode = OPERATION_PENDING;
@@ -252,11 +314,13 @@ private:
         {
             case MemoryConfigClientRequest::CMD_READ:
             case MemoryConfigClientRequest::CMD_READ_PART:
-                return allocate_and_call(
-                    STATE(do_read), dg_service()->client_allocator());
             case MemoryConfigClientRequest::CMD_WRITE:
-                return allocate_and_call(
-                    STATE(do_write), dg_service()->client_allocator());
+                if (streamService_ && stream_applicable())
+                {
+                    return allocate_and_call(
+                        STATE(do_stream), dg_service()->client_allocator());
+                }
+                return start_read_write();
             case MemoryConfigClientRequest::CMD_META_REQUEST:
                 return allocate_and_call(
                     STATE(do_meta_request), dg_service()->client_allocator());
@@ -266,6 +330,23 @@ private:
         return return_with_error(Defs::ERROR_UNIMPLEMENTED_SUBCMD);
     }
 
+    /// Starts executing a read or write request using datagrams.
+    Action start_read_write()
+    {
+        if (window_ > 1)
+        {
+            return allocate_and_call(
+                STATE(do_windowed), dg_service()->client_allocator());
+        }
+        if (request()->cmd == MemoryConfigClientRequest::CMD_WRITE)
+        {
+            return allocate_and_call(
+                STATE(do_write), dg_service()->client_allocator());
+        }
+        return allocate_and_call(
+            STATE(do_read), dg_service()->client_allocator());
+    }
+
     Action do_read()
     {
         dgClient_ = full_allocation_result(dg_service()->client_allocator());
@@ -522,6 +603,515 @@ private:
         return return_ok();
     }
 
+    /// @return true if the current request can be executed with a stream.
+    bool stream_applicable()
+    {
+        switch (request()->cmd)
+        {
+            case MemoryConfigClientRequest::CMD_READ:
+                return true;
+            case MemoryConfigClientRequest::CMD_READ_PART:
+                // A count of zero would mean reading to the end of the space.
+                return request()->size > 0;
+            case MemoryConfigClientRequest::CMD_WRITE:
+                return !request()->payload.empty();
+            default:
+                return false;
+        }
+    }
+
+    /// @return true if the current request is a read.
+    bool is_read_request()
+    {
+        return request()->cmd != MemoryConfigClientRequest::CMD_WRITE;
+    }
+
+    /// Starts a read or write using the stream commands.
+    Action do_stream()
+    {
+        dgClient_ = full_allocation_result(dg_service()->client_allocator());
+        streamId_ = streamService_->allocate_stream_id(node_);
+        if (streamId_ == StreamDefs::INVALID_STREAM_ID)
+        {
+            dg_service()->client_allocator()->typed_insert(dgClient_);
+            dgClient_ = nullptr;
+            return start_read_write();
+        }
+        offset_ = request()->address;
+        streaming_ = 1;
+        streamCount_ = 0;
+        memoryConfigHandler_->set_client(&responseFlow_);
+        if (is_read_request())
+        {
+            // The stream may start as soon as the reply datagram is out.
+            streamReceiver_->start(node_, request()->dst, streamId_);
+        }
+        return allocate_and_call(
+            dg_service()->iface()->dispatcher(), STATE(send_stream_datagram));
+    }
+
+    Action send_stream_datagram()
+    {
+        auto *b = get_allocation_result(dg_service()->iface()->dispatcher());
+        b->set_done(bn_.reset(this));
+        if (is_read_request())
+        {
+            uint32_t count =
+                request()->cmd == MemoryConfigClientRequest::CMD_READ_PART
+                ? request()->size
+                : 0;
+            b->data()->reset(Defs::MTI_DATAGRAM, node_->node_id(),
+                request()->dst,
+                MemoryConfigDefs::read_stream_datagram(request()->memory_space,
+                    offset_, streamId_, count));
+        }
+        else
+        {
+            b->data()->reset(Defs::MTI_DATAGRAM, node_->node_id(),
+                request()->dst,
+                MemoryConfigDefs::write_stream_datagram(
+                    request()->memory_space, offset_, streamId_));
+        }
+        isWaitingForTimer_ = 0;
+        responseCode_ = DatagramClient::OPERATION_PENDING;
+        dgClient_->write_datagram(b);
+        return wait_and_call(STATE(stream_datagram_complete));
+    }
+
+    Action stream_datagram_complete()
+    {
+        int result = dgClient_->result();
+        if (!(result & DatagramClient::OPERATION_SUCCESS))
+        {
+            if ((result & 0xfff0) == Defs::ERROR_UNIMPLEMENTED ||
+                (result & DatagramClient::RESEND_OK))
+            {
+                // The target does not do streams or is busy with one.
+                cleanup_stream();
+                return start_read_write();
+            }
+            return handle_stream_error(result);
+        }
+        if (responseCode_ & DatagramClient::OPERATION_PENDING)
+        {
+            isWaitingForTimer_ = 1;
+            return sleep_and_call(
+                &timer_, SEC_TO_NSEC(3), STATE(stream_response));
+        }
+        return call_immediately(STATE(stream_response));
+    }
+
+    Action stream_response()
+    {
+        isWaitingForTimer_ = 0;
+        if (responseCode_ & DatagramClient::OPERATION_PENDING)
+        {
+            return handle_stream_error(Defs::OPENMRN_TIMEOUT);
+        }
+        size_t len = responsePayload_.size();
+        const uint8_t *bytes =
+            MemoryConfigDefs::payload_bytes(responsePayload_);
+        if (!MemoryConfigDefs::payload_min_length_check(responsePayload_, 0))
+        {
+            LOG(INFO, "Memory Config client: response datagram payload not "
+                      "long enough");
+            return handle_stream_error(
+                Defs::ERROR_INVALID_ARGS_MESSAGE_TOO_SHORT);
+        }
+        unsigned ofs = MemoryConfigDefs::get_payload_offset(responsePayload_);
+        unsigned address = MemoryConfigDefs::get_address(responsePayload_);
+        uint8_t space = MemoryConfigDefs::get_space(responsePayload_);
+        uint8_t cmd = bytes[1] & MemoryConfigDefs::COMMAND_MASK;
+        if (address != offset_ || space != request()->memory_space)
+        {
+            return handle_stream_error(Defs::ERROR_OUT_OF_ORDER);
+        }
+        if (cmd == MemoryConfigDefs::COMMAND_READ_STREAM_FAILED ||
+            cmd == MemoryConfigDefs::COMMAND_WRITE_STREAM_FAILED)
+        {
+            if (len < ofs + 2)
+            {
+                return handle_stream_error(
+                    Defs::ERROR_INVALID_ARGS_MESSAGE_TOO_SHORT);
+            }
+            uint16_t error = bytes[ofs++];
+            error <<= 8;
+            error |= bytes[ofs];
+            return handle_stream_error(error);
+        }
+        if (is_read_request())
+        {
+            if (cmd != MemoryConfigDefs::COMMAND_READ_STREAM_REPLY)
+            {
+                return handle_stream_error(Defs::ERROR_UNIMPLEMENTED);
+            }
+            if (len >= ofs + 6)
+            {
+                streamCount_ = (bytes[ofs + 2] << 24) |
+                    (bytes[ofs + 3] << 16) | (bytes[ofs + 4] << 8) |
+                    bytes[ofs + 5];
+            }
+            return call_immediately(STATE(stream_read_wait));
+        }
+        if (cmd != MemoryConfigDefs::COMMAND_WRITE_STREAM_REPLY)
+        {
+            return handle_stream_error(Defs::ERROR_UNIMPLEMENTED);
+        }
+        uint8_t dst_stream_id = StreamDefs::INVALID_STREAM_ID;
+        if (len >= ofs + 2)
+        {
+            dst_stream_id = bytes[ofs + 1];
+        }
+        streamSender_->start_stream(
+            node_, request()->dst, streamId_, dst_stream_id, 0, this);
+        return wait_and_call(STATE(stream_write_open));
+    }
+
+    Action stream_read_wait()
+    {
+        streamReceiver_->wait_for_data(this);
+        return wait_and_call(STATE(stream_read_data));
+    }
+
+    Action stream_read_data()
+    {
+        if (streamReceiver_->error())
+        {
+            return handle_stream_error(streamReceiver_->error());
+        }
+        while (size_t len = streamReceiver_->front_size())
+        {
+            request()->payload.append(
+                (const char *)streamReceiver_->front(), len);
+            streamReceiver_->consume(len);
+        }
+        if (!streamReceiver_->is_closed())
+        {
+            return call_immediately(STATE(stream_read_wait));
+        }
+        if (streamCount_ && request()->payload.size() < streamCount_)
+        {
+            // The stream ended before all announced data arrived.
+            return handle_stream_error(Defs::ERROR_OUT_OF_ORDER);
+        }
+        cleanup_stream();
+        return return_ok();
+    }
+
+    Action stream_write_open()
+    {
+        if (streamSender_->error())
+        {
+            return handle_stream_error(streamSender_->error());
+        }
+        streamSender_->send_data(
+            request()->payload.data(), request()->payload.size(), this);
+        return wait_and_call(STATE(stream_write_sent));
+    }
+
+    Action stream_write_sent()
+    {
+        if (streamSender_->error())
+        {
+            return handle_stream_error(streamSender_->error());
+        }
+        streamSender_->close_stream(this);
+        return wait_and_call(STATE(stream_write_closed));
+    }
+
+    Action stream_write_closed()
+    {
+        if (streamSender_->error())
+        {
+            return handle_stream_error(streamSender_->error());
+        }
+        cleanup_stream();
+        return return_ok();
+    }
+
+    Action handle_stream_error(int error)
+    {
+        if (error == MemoryConfigDefs::ERROR_OUT_OF_BOUNDS &&
+            is_read_request())
+        {
+            // Same as for the datagram read: reading past the end is not an
+            // error.
+            cleanup_stream();
+            return return_ok();
+        }
+        cleanup_stream();
+        return return_with_error(error);
+    }
+
+    void cleanup_stream()
+    {
+        streaming_ = 0;
+        streamReceiver_->stop();
+        responsePayload_.clear();
+        dg_service()->client_allocator()->typed_insert(dgClient_);
+        memoryConfigHandler_->clear_client(&responseFlow_);
+        dgClient_ = nullptr;
+    }
+
+    /// Starts a read or write with multiple datagrams in flight.
+    Action do_windowed()
+    {
+        dgClient_ = full_allocation_result(dg_service()->client_allocator());
+        offset_ = request()->address;
+        payloadOffset_ = 0;
+        windowHead_ = 0;
+        windowCount_ = 0;
+        activeWindow_ = window_;
+        windowed_ = 1;
+        windowEnd_ = 0;
+        isWaitingForTimer_ = 0;
+        memoryConfigHandler_->set_client(&responseFlow_);
+        return call_immediately(STATE(window_step));
+    }
+
+    /// @param i index of an in-flight request, 0 is the oldest.
+    /// @return the slot of that request.
+    WindowSlot *window_slot(unsigned i)
+    {
+        return &slots_[(windowHead_ + i) % MAX_WINDOW];
+    }
+
+    /// @return true if there are more datagrams to send in the current
+    /// windowed operation.
+    bool window_has_more()
+    {
+        if (windowEnd_)
+        {
+            return false;
+        }
+        if (request()->cmd == MemoryConfigClientRequest::CMD_WRITE)
+        {
+            return payloadOffset_ < request()->payload.size();
+        }
+        return request()->size > 0;
+    }
+
+    /// Consumes the replies that arrived in order, then either sends the next
+    /// datagram or waits for more replies.
+    Action window_step()
+    {
+        while (windowCount_ && window_slot(0)->done)
+        {
+            int error = consume_window_head();
+            if (error)
+            {
+                return window_error(error);
+            }
+        }
+        if (window_has_more() && windowCount_ < activeWindow_)
+        {
+            return allocate_and_call(dg_service()->iface()->dispatcher(),
+                STATE(send_window_datagram));
+        }
+        if (!windowCount_)
+        {
+            cleanup_windowed();
+            return return_ok();
+        }
+        isWaitingForTimer_ = 1;
+        return sleep_and_call(
+            &timer_, SEC_TO_NSEC(3), STATE(window_wakeup));
+    }
+
+    /// Called when a reply arrived or the reply timeout expired.
+    Action window_wakeup()
+    {
+        isWaitingForTimer_ = 0;
+        if (!timer_.is_triggered() && !window_slot(0)->done)
+        {
+            return window_error(Defs::OPENMRN_TIMEOUT);
+        }
+        return call_immediately(STATE(window_step));
+    }
+
+    Action send_window_datagram()
+    {
+        auto *b = get_allocation_result(dg_service()->iface()->dispatcher());
+        b->set_done(bn_.reset(this));
+        WindowSlot *s = window_slot(windowCount_);
+        s->address = offset_;
+        s->done = false;
+        s->payload.clear();
+        if (request()->cmd == MemoryConfigClientRequest::CMD_WRITE)
+        {
+            unsigned sz = request()->payload.size() - payloadOffset_;
+            if (sz > MemoryConfigDefs::MAX_DATAGRAM_RW_BYTES)
+            {
+                sz = MemoryConfigDefs::MAX_DATAGRAM_RW_BYTES;
+            }
+            s->length = sz;
+            b->data()->reset(Defs::MTI_DATAGRAM, node_->node_id(),
+                request()->dst,
+                MemoryConfigDefs::write_datagram(request()->memory_space,
+                    offset_, request()->payload.substr(payloadOffset_, sz)));
+        }
+        else
+        {
+            unsigned sz = request()->size > 64 ? 64 : request()->size;
+            s->length = sz;
+            b->data()->reset(Defs::MTI_DATAGRAM, node_->node_id(),
+                request()->dst,
+                MemoryConfigDefs::read_datagram(
+                    request()->memory_space, offset_, sz));
+        }
+        // The reply may arrive before the datagram OK is processed, so the
+        // slot must already be in flight.
+        ++windowCount_;
+        dgClient_->write_datagram(b);
+        return wait_and_call(STATE(window_datagram_acked));
+    }
+
+    Action window_datagram_acked()
+    {
+        auto result = dgClient_->result();
+        WindowSlot *s = window_slot(windowCount_ - 1);
+        if (result & DatagramClient::OPERATION_SUCCESS)
+        {
+            offset_ += s->length;
+            if (request()->cmd == MemoryConfigClientRequest::CMD_WRITE)
+            {
+                payloadOffset_ += s->length;
+            }
+            else if (request()->size < 0xffffffffu)
+            {
+                request()->size -= s->length;
+            }
+            return call_immediately(STATE(window_step));
+        }
+        // The target will not reply to this request.
+        --windowCount_;
+        s->payload.clear();
+        if ((result & DatagramClient::RESEND_OK) && windowCount_)
+        {
+            // The target cannot take more requests at a time. Falls back to
+            // one request in flight; this one will be sent again after the
+            // outstanding replies arrived.
+            activeWindow_ = 1;
+            return call_immediately(STATE(window_step));
+        }
+        return window_error(result);
+    }
+
+    /// Processes the reply to the oldest in-flight request and removes the
+    /// request from the window.
+    /// @return 0 on success, or the error code to terminate the flow with.
+    int consume_window_head()
+    {
+        WindowSlot *s = window_slot(0);
+        int error = parse_window_reply(s);
+        s->payload.clear();
+        windowHead_ = (windowHead_ + 1) % MAX_WINDOW;
+        --windowCount_;
+        if (error == MemoryConfigDefs::ERROR_OUT_OF_BOUNDS)
+        {
+            // Same as in the sequential case: we read or wrote until the end
+            // of the space.
+            windowEnd_ = 1;
+            return 0;
+        }
+        return error;
+    }
+
+    /// Checks the reply in a slot and appends the read data to the result.
+    /// @param s the slot whose reply arrived.
+    /// @return 0 on success, or an error code.
+    int parse_window_reply(WindowSlot *s)
+    {
+        const string &p = s->payload;
+        const uint8_t *bytes = MemoryConfigDefs::payload_bytes(p);
+        if (MemoryConfigDefs::get_space(p) != request()->memory_space)
+        {
+            return Defs::ERROR_OUT_OF_ORDER;
+        }
+        unsigned ofs = MemoryConfigDefs::get_payload_offset(p);
+        uint8_t cmd = bytes[1] & MemoryConfigDefs::COMMAND_MASK;
+        if (cmd == MemoryConfigDefs::COMMAND_READ_FAILED ||
+            cmd == MemoryConfigDefs::COMMAND_WRITE_FAILED)
+        {
+            if (p.size() < ofs + 2)
+            {
+                return Defs::ERROR_INVALID_ARGS_MESSAGE_TOO_SHORT;
+            }
+            uint16_t error = bytes[ofs++];
+            error <<= 8;
+            error |= bytes[ofs];
+            return error;
+        }
+        if (request()->cmd == MemoryConfigClientRequest::CMD_WRITE)
+        {
+            return cmd == MemoryConfigDefs::COMMAND_WRITE_REPLY
+                ? 0
+                : Defs::ERROR_UNIMPLEMENTED;
+        }
+        if (cmd != MemoryConfigDefs::COMMAND_READ_REPLY)
+        {
+            return Defs::ERROR_UNIMPLEMENTED;
+        }
+        unsigned dlen = p.size() - ofs;
+        if (!windowEnd_)
+        {
+            request()->payload.append((const char *)(bytes + ofs), dlen);
+        }
+        if (dlen < s->length)
+        {
+            // Short read: end of the memory space.
+            windowEnd_ = 1;
+        }
+        return 0;
+    }
+
+    /// Terminates a windowed operation with an error. @param error the error
+    /// code to return.
+    Action window_error(int error)
+    {
+        cleanup_windowed();
+        return return_with_error(error);
+    }
+
+    void cleanup_windowed()
+    {
+        for (unsigned i = 0; i < MAX_WINDOW; ++i)
+        {
+            slots_[i].payload.clear();
+        }
+        windowCount_ = 0;
+        windowed_ = 0;
+        cleanup_read();
+    }
+
+    /// Called by the response flow with a reply in windowed mode.
+    /// @param payload the reply datagram; will be swapped out if it matches
+    /// an in-flight request.
+    /// @return true if the reply belonged to an in-flight request.
+    bool take_window_reply(string *payload)
+    {
+        if (!MemoryConfigDefs::payload_min_length_check(*payload, 0))
+        {
+            return false;
+        }
+        uint32_t address = MemoryConfigDefs::get_address(*payload);
+        for (unsigned i = 0; i < windowCount_; ++i)
+        {
+            WindowSlot *s = window_slot(i);
+            if (!s->done && s->address == address)
+            {
+                s->payload.swap(*payload);
+                s->done = true;
+                if (isWaitingForTimer_)
+                {
+                    timer_.trigger();
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
     Action do_meta_request()
     {
         dgClient_ = full_allocation_result(dg_service()->client_allocator());
@@ -595,6 +1185,10 @@ private:
                     {
                         break;
                     }
+                    if (parent_->windowed_)
+                    {
+                        return window_reply();
+                    }
                     parent_->responseCode_ = 0;
                     message()->data()->payload.swap(parent_->responsePayload_);
                     if (parent_->isWaitingForTimer_)
@@ -610,6 +1204,25 @@ private:
                     {
                         break;
                     }
+                    if (parent_->windowed_)
+                    {
+                        return window_reply();
+                    }
+                    parent_->responseCode_ = 0;
+                    message()->data()->payload.swap(parent_->responsePayload_);
+                    if (parent_->isWaitingForTimer_)
+                    {
+                        parent_->timer_.trigger();
+                    }
+                    return respond_ok(0);
+                case MemoryConfigDefs::COMMAND_READ_STREAM_REPLY:
+                case MemoryConfigDefs::COMMAND_READ_STREAM_FAILED:
+                case MemoryConfigDefs::COMMAND_WRITE_STREAM_REPLY:
+                case MemoryConfigDefs::COMMAND_WRITE_STREAM_FAILED:
+                    if (!parent_->streaming_)
+                    {
+                        break;
+                    }
                     parent_->responseCode_ = 0;
                     message()->data()->payload.swap(parent_->responsePayload_);
                     if (parent_->isWaitingForTimer_)
@@ -620,10 +1233,22 @@ private:
             }
             return respond_reject(Defs::ERROR_UNIMPLEMENTED_SUBCMD);
         }
+
+        /// Hands a reply over to the windowed parent flow.
+        Action window_reply()
+        {
+            if (parent_->take_window_reply(&message()->data()->payload))
+            {
+                return respond_ok(0);
+            }
+            return respond_reject(Defs::ERROR_OUT_OF_ORDER);
+        }
+
     private:
         MemoryConfigClient *parent_;        
     };
 
+
     DatagramService *dg_service()
     {
         return static_cast<DatagramService *>(service());
@@ -652,8 +1277,35 @@ private:
     string responsePayload_;
     /// error code that came with the response. 0 for success.
     int responseCode_;
+    /// Stream service to use; nullptr if streams are disabled.
+    StreamService *streamService_{nullptr};
+    /// Sends the data of stream writes. Allocated by set_use_streams().
+    std::unique_ptr<StreamSender> streamSender_;
+    /// Receives the data of stream reads. Allocated by set_use_streams().
+    std::unique_ptr<StreamReceiver> streamReceiver_;
+    /// Number of bytes the target announced for a stream read.
+    uint32_t streamCount_;
+    /// Local stream ID of the current stream request.
+    uint8_t streamId_;
+    /// Requests in flight in windowed mode. Allocated by set_window().
+    std::unique_ptr<WindowSlot[]> slots_;
+    /// Maximum number of datagrams in flight.
+    uint8_t window_{1};
+    /// Maximum number of datagrams in flight for the current request. Drops
+    /// to 1 when the target is busy.
+    uint8_t activeWindow_;
+    /// Index in slots_ of the oldest request in flight.
+    uint8_t windowHead_;
+    /// Number of requests in flight.
+    uint8_t windowCount_{0};
     /// 1 if we are pending on the timer.
     uint8_t isWaitingForTimer_ : 1;
+    /// 1 if the current request is processed in windowed mode.
+    uint8_t windowed_ : 1;
+    /// 1 if we reached the end of the memory space in windowed mode.
+    uint8_t windowEnd_ : 1;
+    /// 1 if the current request is processed with a stream.
+    uint8_t streaming_ : 1;
 };
 
 } // namespace openlcb
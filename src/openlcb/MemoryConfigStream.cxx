@@ -0,0 +1,510 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file MemoryConfigStream.cxx
+ *
+ * Server side of the stream read and stream write commands of the Memory
+ * Config Protocol.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#include "openlcb/MemoryConfigStream.hxx"
+
+#include "openlcb/StreamReceiver.hxx"
+#include "openlcb/StreamSender.hxx"
+
+namespace openlcb
+{
+
+/// Common parts of the stream read and write flows: sending the reply
+/// datagram.
+class MemoryConfigStreamServer::CommandFlow : public StateFlowBase
+{
+public:
+    /// @param service the datagram service of the memory config handler.
+    /// @param stream_service allocates the stream IDs.
+    CommandFlow(DatagramService *service, StreamService *stream_service)
+        : StateFlowBase(service)
+        , streamService_(stream_service)
+    {
+    }
+
+    /// Starts executing a command.
+    /// @param request the parameters of the command.
+    void start(const Request &request)
+    {
+        HASSERT(is_terminated());
+        req_ = request;
+        req_.space->set_node(req_.node);
+        start_flow(STATE(entry));
+    }
+
+    /// @return true if a command is being executed.
+    bool is_busy()
+    {
+        return !is_terminated();
+    }
+
+protected:
+    /// First state of the flow.
+    virtual Action entry() = 0;
+
+    /// Called after the reply datagram was sent (or failed to be sent, see
+    /// replyFailed_).
+    virtual Action reply_sent() = 0;
+
+    /// @return the datagram service.
+    DatagramService *dg_service()
+    {
+        return static_cast<DatagramService *>(service());
+    }
+
+    /// @return the OpenLCB interface.
+    If *iface()
+    {
+        return dg_service()->iface();
+    }
+
+    /// Starts the reply datagram with the command, address and space fields.
+    /// @param cmd the reply command byte.
+    void start_reply(uint8_t cmd)
+    {
+        reply_.clear();
+        reply_.push_back(DatagramDefs::CONFIGURATION);
+        reply_.push_back(cmd);
+        reply_.push_back(0xff & (req_.address >> 24));
+        reply_.push_back(0xff & (req_.address >> 16));
+        reply_.push_back(0xff & (req_.address >> 8));
+        reply_.push_back(0xff & (req_.address));
+        if (MemoryConfigDefs::is_special_space(req_.spaceNumber))
+        {
+            reply_[1] |= req_.spaceNumber & ~MemoryConfigDefs::SPACE_SPECIAL;
+        }
+        else
+        {
+            reply_.push_back(req_.spaceNumber);
+        }
+    }
+
+    /// Appends a 16-bit error code to the reply datagram.
+    /// @param error the error code.
+    void append_error(uint16_t error)
+    {
+        reply_.push_back(error >> 8);
+        reply_.push_back(error & 0xff);
+    }
+
+    /// Sends the datagram in reply_, then continues in reply_sent().
+    Action send_reply()
+    {
+        return allocate_and_call(
+            STATE(client_allocated), dg_service()->client_allocator());
+    }
+
+    /// Allocates a local stream ID for the command.
+    /// @param fail_cmd reply command to send if there is no free stream ID.
+    /// @return true if streamId_ is valid; false if the failed reply was
+    /// prepared in reply_.
+    bool allocate_stream_id(uint8_t fail_cmd)
+    {
+        streamId_ = streamService_->allocate_stream_id(req_.node);
+        if (streamId_ != StreamDefs::INVALID_STREAM_ID)
+        {
+            return true;
+        }
+        start_reply(fail_cmd);
+        append_error(Defs::ERROR_TEMPORARY);
+        return false;
+    }
+
+    /// Gives out the stream IDs.
+    StreamService *streamService_;
+    /// The parameters of the command being executed.
+    Request req_;
+    /// Local stream ID of the command being executed.
+    uint8_t streamId_;
+    /// Payload of the reply datagram.
+    DatagramPayload reply_;
+    /// true if the reply datagram could not be delivered.
+    bool replyFailed_{false};
+
+private:
+    Action client_allocated()
+    {
+        dgClient_ = full_allocation_result(dg_service()->client_allocator());
+        return allocate_and_call(
+            iface()->dispatcher(), STATE(send_reply_datagram));
+    }
+
+    Action send_reply_datagram()
+    {
+        auto *b = get_allocation_result(iface()->dispatcher());
+        b->set_done(bn_.reset(this));
+        b->data()->reset(Defs::MTI_DATAGRAM, req_.node->node_id(),
+            req_.remote, EMPTY_PAYLOAD);
+        b->data()->payload.swap(reply_);
+        dgClient_->write_datagram(b);
+        return wait_and_call(STATE(reply_done));
+    }
+
+    Action reply_done()
+    {
+        replyFailed_ =
+            !(dgClient_->result() & DatagramClient::OPERATION_SUCCESS);
+        if (replyFailed_)
+        {
+            LOG(WARNING,
+                "MemoryConfig: Failed to send stream reply datagram. error "
+                "code %x",
+                (unsigned)dgClient_->result());
+        }
+        dg_service()->client_allocator()->typed_insert(dgClient_);
+        dgClient_ = nullptr;
+        return call_immediately(STATE(reply_sent));
+    }
+
+    /// Datagram client for sending the reply.
+    DatagramClient *dgClient_{nullptr};
+    /// Notify helper.
+    BarrierNotifiable bn_;
+};
+
+/// Executes the stream read command: sends the memory space contents in a
+/// stream.
+class MemoryConfigStreamServer::ReadFlow : public CommandFlow
+{
+public:
+    /// @param service the datagram service of the memory config handler.
+    /// @param stream_service stream service of the interface.
+    ReadFlow(DatagramService *service, StreamService *stream_service)
+        : CommandFlow(service, stream_service)
+        , sender_(stream_service)
+    {
+    }
+
+    ~ReadFlow()
+    {
+        if (chunk_)
+        {
+            chunk_->unref();
+        }
+    }
+
+private:
+    /// Number of bytes read from the memory space at a time, at most. One
+    /// stream data message each, which is handed to the stream sender without
+    /// copying.
+    static constexpr unsigned CHUNK_SIZE = StreamSender::MAX_BYTES_PER_MESSAGE;
+
+    Action entry() override
+    {
+        uint32_t max_address = req_.space->max_address();
+        if (req_.address > max_address)
+        {
+            start_reply(MemoryConfigDefs::COMMAND_READ_STREAM_FAILED);
+            append_error(MemoryConfigDefs::ERROR_OUT_OF_BOUNDS);
+            isFailed_ = true;
+            return send_reply();
+        }
+        if (!allocate_stream_id(MemoryConfigDefs::COMMAND_READ_STREAM_FAILED))
+        {
+            isFailed_ = true;
+            return send_reply();
+        }
+        isFailed_ = false;
+        address_ = req_.address;
+        remaining_ = max_address - req_.address + 1;
+        if (req_.count && req_.count < remaining_)
+        {
+            remaining_ = req_.count;
+        }
+        bufLen_ = 0;
+        start_reply(MemoryConfigDefs::COMMAND_READ_STREAM_REPLY);
+        reply_.push_back(streamId_);
+        reply_.push_back(req_.remoteStreamId);
+        reply_.push_back(0xff & (remaining_ >> 24));
+        reply_.push_back(0xff & (remaining_ >> 16));
+        reply_.push_back(0xff & (remaining_ >> 8));
+        reply_.push_back(0xff & (remaining_));
+        return send_reply();
+    }
+
+    Action reply_sent() override
+    {
+        if (replyFailed_ || isFailed_)
+        {
+            return exit();
+        }
+        sender_.start_stream(
+            req_.node, req_.remote, streamId_, req_.remoteStreamId, 0, this);
+        return wait_and_call(STATE(stream_open));
+    }
+
+    Action stream_open()
+    {
+        if (sender_.error())
+        {
+            LOG(INFO, "MemoryConfig: failed to open read stream: %x",
+                sender_.error());
+            return exit();
+        }
+        chunkSize_ =
+            std::min((unsigned)CHUNK_SIZE, (unsigned)sender_.buffer_size());
+        return call_immediately(STATE(read_chunk));
+    }
+
+    /// Reads the next chunk from the memory space into a stream data message
+    /// buffer.
+    Action read_chunk()
+    {
+        unsigned len = std::min(remaining_, (uint32_t)chunkSize_);
+        if (!len)
+        {
+            return call_immediately(STATE(close));
+        }
+        if (!chunk_)
+        {
+            chunk_ = StreamSender::alloc_chunk(len);
+        }
+        string &payload = chunk_->data()->payload;
+        payload.resize(1 + len);
+        MemorySpace::errorcode_t error = 0;
+        size_t got = req_.space->read(address_ + bufLen_,
+            (uint8_t *)&payload[1 + bufLen_], len - bufLen_, &error, this);
+        bufLen_ += got;
+        if (error == MemorySpace::ERROR_AGAIN)
+        {
+            return wait_and_call(STATE(read_chunk));
+        }
+        if (error)
+        {
+            LOG(INFO, "MemoryConfig: stream read error %x at address %u",
+                (unsigned)error, (unsigned)(address_ + bufLen_));
+            // The receiver will see that the stream is shorter than
+            // announced.
+            remaining_ = 0;
+        }
+        if (!bufLen_)
+        {
+            chunk_->unref();
+            chunk_ = nullptr;
+            return call_immediately(STATE(close));
+        }
+        payload.resize(1 + bufLen_);
+        auto *b = chunk_;
+        chunk_ = nullptr;
+        sender_.send_chunk(b, this);
+        return wait_and_call(STATE(chunk_sent));
+    }
+
+    Action chunk_sent()
+    {
+        if (sender_.error())
+        {
+            LOG(INFO, "MemoryConfig: stream read aborted: %x",
+                sender_.error());
+            return exit();
+        }
+        address_ += bufLen_;
+        remaining_ = remaining_ > bufLen_ ? remaining_ - bufLen_ : 0;
+        bufLen_ = 0;
+        return call_immediately(STATE(read_chunk));
+    }
+
+    Action close()
+    {
+        sender_.close_stream(this);
+        return wait_and_call(STATE(closed));
+    }
+
+    Action closed()
+    {
+        return exit();
+    }
+
+    /// Sends the data.
+    StreamSender sender_;
+    /// Stream data message being filled from the memory space.
+    Buffer<GenMessage> *chunk_{nullptr};
+    /// Next address to read.
+    uint32_t address_;
+    /// Number of bytes left to send.
+    uint32_t remaining_;
+    /// Number of data bytes in chunk_.
+    unsigned bufLen_;
+    /// Number of bytes to put into one stream data message.
+    unsigned chunkSize_;
+    /// true if the command was rejected in the reply datagram.
+    bool isFailed_;
+};
+
+/// Executes the stream write command: writes the data arriving in a stream
+/// into the memory space.
+class MemoryConfigStreamServer::WriteFlow : public CommandFlow
+{
+public:
+    /// @param service the datagram service of the memory config handler.
+    /// @param stream_service stream service of the interface.
+    WriteFlow(DatagramService *service, StreamService *stream_service)
+        : CommandFlow(service, stream_service)
+        , receiver_(stream_service)
+    {
+    }
+
+private:
+    Action entry() override
+    {
+        address_ = req_.address;
+        if (!allocate_stream_id(
+                MemoryConfigDefs::COMMAND_WRITE_STREAM_FAILED))
+        {
+            isFailed_ = true;
+            return send_reply();
+        }
+        isFailed_ = false;
+        // The stream initiate may arrive as soon as the reply is out.
+        receiver_.start(req_.node, req_.remote, streamId_);
+        start_reply(MemoryConfigDefs::COMMAND_WRITE_STREAM_REPLY);
+        reply_.push_back(req_.remoteStreamId);
+        reply_.push_back(streamId_);
+        return send_reply();
+    }
+
+    Action reply_sent() override
+    {
+        if (isFailed_)
+        {
+            return exit();
+        }
+        if (replyFailed_)
+        {
+            receiver_.stop();
+            return exit();
+        }
+        return call_immediately(STATE(wait_for_data));
+    }
+
+    Action wait_for_data()
+    {
+        receiver_.wait_for_data(this);
+        return wait_and_call(STATE(have_data));
+    }
+
+    Action have_data()
+    {
+        if (receiver_.error())
+        {
+            LOG(INFO, "MemoryConfig: stream write error %x",
+                receiver_.error());
+            receiver_.stop();
+            return exit();
+        }
+        if (receiver_.front_size())
+        {
+            return call_immediately(STATE(write_data));
+        }
+        if (receiver_.is_closed())
+        {
+            receiver_.stop();
+            return exit();
+        }
+        return call_immediately(STATE(wait_for_data));
+    }
+
+    /// Writes the received data to the memory space.
+    Action write_data()
+    {
+        size_t len = receiver_.front_size();
+        MemorySpace::errorcode_t error = 0;
+        size_t written = req_.space->write(
+            address_, receiver_.front(), len, &error, this);
+        address_ += written;
+        if (error == MemorySpace::ERROR_AGAIN)
+        {
+            receiver_.consume(written);
+            return wait_and_call(STATE(write_data));
+        }
+        if (!error && written < len)
+        {
+            error = MemoryConfigDefs::ERROR_OUT_OF_BOUNDS;
+        }
+        if (error)
+        {
+            LOG(INFO, "MemoryConfig: stream write error %x at address %u",
+                (unsigned)error, (unsigned)address_);
+            receiver_.close_with_error(error);
+            return exit();
+        }
+        receiver_.consume(written);
+        return call_immediately(STATE(have_data));
+    }
+
+    /// Receives the data.
+    StreamReceiver receiver_;
+    /// Next address to write.
+    uint32_t address_;
+    /// true if the command was rejected in the reply datagram.
+    bool isFailed_;
+};
+
+MemoryConfigStreamServer::MemoryConfigStreamServer(
+    MemoryConfigHandler *handler, StreamService *stream_service)
+    : handler_(handler)
+    , readFlow_(new ReadFlow(handler->dg_service(), stream_service))
+    , writeFlow_(new WriteFlow(handler->dg_service(), stream_service))
+{
+    handler_->set_stream_handler(this);
+}
+
+MemoryConfigStreamServer::~MemoryConfigStreamServer()
+{
+    handler_->set_stream_handler(nullptr);
+}
+
+bool MemoryConfigStreamServer::is_busy(bool is_read)
+{
+    if (is_read)
+    {
+        return readFlow_->is_busy();
+    }
+    return writeFlow_->is_busy();
+}
+
+void MemoryConfigStreamServer::start(const Request &request)
+{
+    if (request.isRead)
+    {
+        readFlow_->start(request);
+    }
+    else
+    {
+        writeFlow_->start(request);
+    }
+}
+
+} // namespace openlcb
@@ -0,0 +1,89 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file MemoryConfigStream.hxx
+ *
+ * Server side of the stream read and stream write commands of the Memory
+ * Config Protocol.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#ifndef _OPENLCB_MEMORYCONFIGSTREAM_HXX_
+#define _OPENLCB_MEMORYCONFIGSTREAM_HXX_
+
+#include <memory>
+
+#include "openlcb/MemoryConfig.hxx"
+#include "openlcb/StreamService.hxx"
+
+namespace openlcb
+{
+
+/// Executes the stream read and stream write commands of the memory config
+/// protocol for a MemoryConfigHandler. Stream reads send the contents of the
+/// memory space in a stream to the requester; stream writes receive a stream
+/// from the requester and write it into the memory space. The flow control of
+/// the stream (buffer size negotiation and proceed messages) keeps the link
+/// busy without waiting for a reply after every 64 bytes, as the datagram
+/// based commands do.
+///
+/// Usage: instantiate next to the MemoryConfigHandler. At most one stream read
+/// and one stream write are executed at a time; further requests are
+/// rejected with a temporary error.
+class MemoryConfigStreamServer : public MemoryConfigStreamHandler
+{
+public:
+    /// Constructor. Registers the server with the memory config handler.
+    /// @param handler the memory config handler of the node(s) to serve.
+    /// @param stream_service the stream service of the interface of
+    /// handler. The stream IDs are allocated from it for each command.
+    MemoryConfigStreamServer(
+        MemoryConfigHandler *handler, StreamService *stream_service);
+
+    /// Destructor. Unregisters from the memory config handler.
+    ~MemoryConfigStreamServer();
+
+    bool is_busy(bool is_read) override;
+    void start(const Request &request) override;
+
+private:
+    class CommandFlow;
+    class ReadFlow;
+    class WriteFlow;
+
+    /// The memory config handler we are registered with.
+    MemoryConfigHandler *handler_;
+    /// Executes the stream read command.
+    std::unique_ptr<ReadFlow> readFlow_;
+    /// Executes the stream write command.
+    std::unique_ptr<WriteFlow> writeFlow_;
+};
+
+} // namespace openlcb
+
+#endif // _OPENLCB_MEMORYCONFIGSTREAM_HXX_
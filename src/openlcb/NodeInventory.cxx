@@ -0,0 +1,393 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file NodeInventory.cxx
+ * Collects the protocol support and simple node information of all nodes on
+ * the network.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#include "openlcb/NodeInventory.hxx"
+
+#include "nmranet_config.h"
+
+namespace openlcb
+{
+
+long long NODE_INVENTORY_TIMEOUT_NSEC = SEC_TO_NSEC(4);
+
+NodeInventory::NodeInventory(
+    Node *node, CallbackFunction cb, unsigned max_parallel)
+    : StateFlowBase(node->iface())
+    , node_(node)
+    , callback_(std::move(cb))
+    , browser_(node, std::bind(&NodeInventory::node_seen, this,
+                         std::placeholders::_1))
+    , maxParallel_(
+          max_parallel ? max_parallel : config_node_inventory_max_parallel())
+{
+    HASSERT(maxParallel_ > 0);
+    auto *d = node_->iface()->dispatcher();
+    d->register_handler(
+        &handler_, Defs::MTI_INITIALIZATION_COMPLETE, Defs::MTI_EXACT);
+    d->register_handler(
+        &handler_, Defs::MTI_PROTOCOL_SUPPORT_REPLY, Defs::MTI_EXACT);
+    d->register_handler(&handler_, Defs::MTI_IDENT_INFO_REPLY, Defs::MTI_EXACT);
+    d->register_handler(
+        &handler_, Defs::MTI_OPTIONAL_INTERACTION_REJECTED, Defs::MTI_EXACT);
+    d->register_handler(
+        &handler_, Defs::MTI_TERMINATE_DUE_TO_ERROR, Defs::MTI_EXACT);
+    start_flow(STATE(dispatch));
+}
+
+NodeInventory::~NodeInventory()
+{
+    node_->iface()->dispatcher()->unregister_handler_all(&handler_);
+}
+
+void NodeInventory::refresh()
+{
+    browser_.refresh();
+}
+
+void NodeInventory::clear()
+{
+    {
+        OSMutexLock h(&lock_);
+        // Replies to the queries in flight will not find an entry and get
+        // ignored.
+        cache_.clear();
+        queue_.clear();
+        inFlight_.clear();
+    }
+    // The timer may only be touched from the executor.
+    service()->executor()->add(new CallbackExecutable([this]() {
+        OSMutexLock h(&lock_);
+        wakeup();
+    }));
+}
+
+bool NodeInventory::lookup(NodeID id, NodeInfo *info)
+{
+    OSMutexLock h(&lock_);
+    auto it = cache_.find(id);
+    if (it == cache_.end())
+    {
+        return false;
+    }
+    *info = it->second.info;
+    return true;
+}
+
+std::vector<NodeInventory::NodeInfo> NodeInventory::snapshot()
+{
+    OSMutexLock h(&lock_);
+    std::vector<NodeInfo> ret;
+    ret.reserve(cache_.size());
+    for (const auto &kv : cache_)
+    {
+        ret.push_back(kv.second.info);
+    }
+    return ret;
+}
+
+bool NodeInventory::is_idle()
+{
+    OSMutexLock h(&lock_);
+    return queue_.empty() && inFlight_.empty();
+}
+
+void NodeInventory::node_seen(NodeID id)
+{
+    if (id == node_->node_id())
+    {
+        // We know everything about ourselves.
+        return;
+    }
+    OSMutexLock h(&lock_);
+    auto it = cache_.find(id);
+    if (it == cache_.end())
+    {
+        Entry &e = cache_[id];
+        e.info.node_id = id;
+        enqueue(&e);
+    }
+    else if (it->second.info.state == QUERY_TIMEOUT)
+    {
+        enqueue(&it->second);
+    }
+}
+
+void NodeInventory::enqueue(Entry *e)
+{
+    e->info.state = QUERY_QUEUED;
+    e->info.has_protocols = false;
+    e->info.has_snip = false;
+    e->info.protocols = 0;
+    e->info.snip.clear();
+    e->pipPending = false;
+    e->snipPending = false;
+    queue_.push_back(e->info.node_id);
+    wakeup();
+}
+
+void NodeInventory::release_slot(NodeID id)
+{
+    for (unsigned i = 0; i < inFlight_.size(); ++i)
+    {
+        if (inFlight_[i] == id)
+        {
+            inFlight_[i] = inFlight_.back();
+            inFlight_.pop_back();
+            break;
+        }
+    }
+    wakeup();
+}
+
+void NodeInventory::wakeup()
+{
+    if (isIdle_)
+    {
+        isIdle_ = false;
+        notify();
+    }
+    else if (isSleeping_)
+    {
+        isSleeping_ = false;
+        timer_.ensure_triggered();
+    }
+}
+
+void NodeInventory::handle_response(Buffer<GenMessage> *b)
+{
+    auto d = get_buffer_deleter(b);
+    GenMessage *m = b->data();
+    NodeID id;
+    if (m->mti == Defs::MTI_INITIALIZATION_COMPLETE)
+    {
+        if (m->payload.size() != 6)
+        {
+            return;
+        }
+        id = buffer_to_node_id(m->payload);
+    }
+    else
+    {
+        if (m->dstNode != node_ || !m->src.id)
+        {
+            return;
+        }
+        id = m->src.id;
+    }
+
+    NodeInfo done_info;
+    {
+        OSMutexLock h(&lock_);
+        auto it = cache_.find(id);
+        if (it == cache_.end())
+        {
+            // Unknown nodes are added by the node browser.
+            return;
+        }
+        Entry *e = &it->second;
+        if (m->mti == Defs::MTI_INITIALIZATION_COMPLETE)
+        {
+            // The node has restarted; its information may have changed.
+            if (e->info.state == QUERY_PENDING)
+            {
+                release_slot(id);
+            }
+            if (e->info.state != QUERY_QUEUED)
+            {
+                enqueue(e);
+            }
+            return;
+        }
+        if (e->info.state != QUERY_PENDING)
+        {
+            return;
+        }
+        switch (m->mti)
+        {
+            case Defs::MTI_PROTOCOL_SUPPORT_REPLY:
+            {
+                if (!e->pipPending)
+                {
+                    return;
+                }
+                // Nodes may send fewer than 6 bytes; the missing bytes are
+                // zero.
+                uint8_t data[6] = {0};
+                memcpy(data, m->payload.data(),
+                    std::min(m->payload.size(), sizeof(data)));
+                e->info.protocols = data_to_node_id(data);
+                e->info.has_protocols = true;
+                e->pipPending = false;
+                break;
+            }
+            case Defs::MTI_IDENT_INFO_REPLY:
+            {
+                if (!e->snipPending)
+                {
+                    return;
+                }
+                decode_snip_response(m->payload, &e->info.snip);
+                e->info.has_snip = true;
+                e->snipPending = false;
+                break;
+            }
+            default:
+            {
+                uint16_t error_code, mti;
+                buffer_to_error(m->payload, &error_code, &mti, nullptr);
+                if (mti == Defs::MTI_PROTOCOL_SUPPORT_INQUIRY)
+                {
+                    e->pipPending = false;
+                }
+                else if (mti == Defs::MTI_IDENT_INFO_REQUEST)
+                {
+                    e->snipPending = false;
+                }
+                else
+                {
+                    // Rejection of a different interaction.
+                    return;
+                }
+                break;
+            }
+        }
+        if (e->pipPending || e->snipPending)
+        {
+            return;
+        }
+        e->info.state = QUERY_DONE;
+        release_slot(id);
+        done_info = e->info;
+    }
+    if (callback_)
+    {
+        callback_(done_info);
+    }
+}
+
+void NodeInventory::send_queries(NodeID id)
+{
+    auto *flow = node_->iface()->addressed_message_write_flow();
+    auto *b = flow->alloc();
+    b->data()->reset(Defs::MTI_PROTOCOL_SUPPORT_INQUIRY, node_->node_id(),
+        NodeHandle(id), EMPTY_PAYLOAD);
+    flow->send(b);
+    b = flow->alloc();
+    b->data()->reset(Defs::MTI_IDENT_INFO_REQUEST, node_->node_id(),
+        NodeHandle(id), EMPTY_PAYLOAD);
+    flow->send(b);
+}
+
+StateFlowBase::Action NodeInventory::dispatch()
+{
+    std::vector<NodeID> to_send;
+    std::vector<NodeInfo> timed_out;
+    long long next_deadline = 0;
+    {
+        OSMutexLock h(&lock_);
+        isSleeping_ = false;
+        long long now = os_get_time_monotonic();
+        for (unsigned i = 0; i < inFlight_.size();)
+        {
+            auto it = cache_.find(inFlight_[i]);
+            if (it != cache_.end() && it->second.deadline > now)
+            {
+                ++i;
+                continue;
+            }
+            if (it != cache_.end())
+            {
+                Entry &e = it->second;
+                e.info.state = QUERY_TIMEOUT;
+                e.pipPending = false;
+                e.snipPending = false;
+                timed_out.push_back(e.info);
+            }
+            inFlight_[i] = inFlight_.back();
+            inFlight_.pop_back();
+        }
+        while (inFlight_.size() < maxParallel_ && !queue_.empty())
+        {
+            NodeID id = queue_.front();
+            queue_.pop_front();
+            auto it = cache_.find(id);
+            if (it == cache_.end() || it->second.info.state != QUERY_QUEUED)
+            {
+                continue;
+            }
+            Entry &e = it->second;
+            e.info.state = QUERY_PENDING;
+            e.pipPending = true;
+            e.snipPending = true;
+            e.deadline = now + NODE_INVENTORY_TIMEOUT_NSEC;
+            inFlight_.push_back(id);
+            to_send.push_back(id);
+        }
+        for (NodeID id : inFlight_)
+        {
+            long long deadline = cache_[id].deadline;
+            if (!next_deadline || deadline < next_deadline)
+            {
+                next_deadline = deadline;
+            }
+        }
+        if (inFlight_.empty())
+        {
+            isIdle_ = true;
+        }
+        else
+        {
+            isSleeping_ = true;
+            next_deadline -= now;
+        }
+    }
+    for (NodeID id : to_send)
+    {
+        send_queries(id);
+    }
+    if (callback_)
+    {
+        for (const auto &info : timed_out)
+        {
+            callback_(info);
+        }
+    }
+    if (!next_deadline)
+    {
+        return wait_and_call(STATE(dispatch));
+    }
+    return sleep_and_call(&timer_, next_deadline, STATE(dispatch));
+}
+
+} // namespace openlcb
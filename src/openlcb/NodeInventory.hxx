@@ -0,0 +1,232 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file NodeInventory.hxx
+ * Collects the protocol support and simple node information of all nodes on
+ * the network.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#ifndef _OPENLCB_NODEINVENTORY_HXX_
+#define _OPENLCB_NODEINVENTORY_HXX_
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "executor/StateFlow.hxx"
+#include "openlcb/NodeBrowser.hxx"
+#include "openlcb/SimpleNodeInfo.hxx"
+#include "os/OS.hxx"
+
+namespace openlcb
+{
+
+/** Specifies how long to wait for the PIP and SNIP responses of a node before
+ * giving up on it. Writable for unittesting purposes. Defaults to 4
+ * seconds. */
+extern long long NODE_INVENTORY_TIMEOUT_NSEC;
+
+/// Builds an inventory of all nodes on the network. Nodes are discovered via
+/// a NodeBrowser; every newly seen node gets a Protocol Identification (PIP)
+/// and a Simple Node Ident Info (SNIP) query. Queries to different nodes run
+/// concurrently, with up to a bounded number of nodes being queried at any
+/// time. The results are cached by node ID. An Initialization Complete
+/// message from a node invalidates its cache entry and queries it again. The
+/// local node that the queries are sent from is not part of the inventory.
+///
+/// Usage: create an instance, call @ref refresh() to discover all live nodes,
+/// then use @ref snapshot() or @ref lookup() from any thread, or get called
+/// back whenever a node's query completes.
+class NodeInventory : public StateFlowBase
+{
+public:
+    /// Query state of a single node.
+    enum QueryState : uint8_t
+    {
+        /// The node is waiting for a free query slot.
+        QUERY_QUEUED,
+        /// PIP and SNIP requests are outstanding.
+        QUERY_PENDING,
+        /// Both queries got an answer (possibly a rejection).
+        QUERY_DONE,
+        /// The node did not answer in NODE_INVENTORY_TIMEOUT_NSEC. A
+        /// refresh() will query it again.
+        QUERY_TIMEOUT,
+    };
+
+    /// Cached information about a remote node.
+    struct NodeInfo
+    {
+        /// Which node this entry is about.
+        NodeID node_id;
+        /// Where the queries of this node are at.
+        QueryState state;
+        /// True if the node answered the protocol support inquiry.
+        bool has_protocols;
+        /// True if the node answered the simple node ident info request.
+        bool has_snip;
+        /// Bitmask of Defs::Protocols from the PIP reply.
+        uint64_t protocols;
+        /// Decoded SNIP reply.
+        SnipDecodedData snip;
+    };
+
+    /// Function prototype for the callback. This function will be called on
+    /// the interface's executor.
+    /// @param info the entry of the node whose queries are completed (or
+    /// timed out).
+    typedef std::function<void(const NodeInfo &info)> CallbackFunction;
+
+    /// Constructor.
+    /// @param node is the *current* node, from which we send the queries.
+    /// @param cb will be called every time a node's queries are completed.
+    /// May be empty.
+    /// @param max_parallel is the number of nodes that are queried at the
+    /// same time. 0 takes the value from config_node_inventory_max_parallel().
+    NodeInventory(Node *node, CallbackFunction cb = nullptr,
+        unsigned max_parallel = 0);
+
+    /// Destructor. Must be called when there are no queries in flight (@ref
+    /// is_idle() is true).
+    ~NodeInventory();
+
+    /// Requests a pong from every live node. This function will return
+    /// immediately, then the nodes that are not cached yet (or have timed
+    /// out earlier) get queried.
+    void refresh();
+
+    /// Drops all cached entries. Nodes get added back as they are discovered.
+    void clear();
+
+    /// Looks up the cached entry of a node. Thread-safe.
+    /// @param id node to look up
+    /// @param info will be filled with the entry
+    /// @return false if the node is not known.
+    bool lookup(NodeID id, NodeInfo *info);
+
+    /// Thread-safe.
+    /// @return a copy of all known entries, sorted by node ID.
+    std::vector<NodeInfo> snapshot();
+
+    /// Thread-safe.
+    /// @return true if there are no nodes waiting for or being queried.
+    bool is_idle();
+
+private:
+    /// Helper class to register in the dispatcher. Incoming response messages
+    /// will be routed to this object.
+    class ResponseHandler : public MessageHandler
+    {
+    public:
+        /// @param parent is the NodeInventory that owns *this
+        ResponseHandler(NodeInventory *parent)
+            : parent_(parent)
+        {
+        }
+
+        /// @param b incoming message
+        void send(Buffer<GenMessage> *b, unsigned) override
+        {
+            parent_->handle_response(b);
+        }
+
+    private:
+        /// NodeInventory that owns *this.
+        NodeInventory *parent_;
+    };
+
+    /// Cache entry with the bookkeeping of an outstanding query.
+    struct Entry
+    {
+        /// Data visible to the users.
+        NodeInfo info;
+        /// When the outstanding query times out (OS monotonic time).
+        long long deadline;
+        /// True while the PIP reply is outstanding.
+        bool pipPending;
+        /// True while the SNIP reply is outstanding.
+        bool snipPending;
+    };
+
+    /// Called by the node browser for every node that is seen on the bus.
+    /// @param id the node ID of the remote node.
+    void node_seen(NodeID id);
+
+    /// Adds a node to the end of the query queue. Caller must hold lock_.
+    /// @param e the entry of the node to query.
+    void enqueue(Entry *e);
+
+    /// Processes an incoming message. @param b incoming message.
+    void handle_response(Buffer<GenMessage> *b);
+
+    /// Removes a node from the in-flight list and wakes up the flow. Caller
+    /// must hold lock_. @param id the node to remove.
+    void release_slot(NodeID id);
+
+    /// Wakes up the state flow if it is sleeping. Caller must hold lock_ and
+    /// be on the interface executor.
+    void wakeup();
+
+    /// Sends the PIP and SNIP requests to a node.
+    /// @param id destination node
+    void send_queries(NodeID id);
+
+    /// Main loop: times out stale queries and sends out queued ones.
+    Action dispatch();
+
+    /// Me-node.
+    Node *node_;
+    /// Client callback for completed nodes.
+    CallbackFunction callback_;
+    /// Discovers nodes on the bus.
+    NodeBrowser browser_;
+    /// Receives PIP/SNIP replies and initialization complete messages.
+    ResponseHandler handler_ {this};
+    /// Helper for sleeping until the next query times out.
+    StateFlowTimer timer_ {this};
+    /// Protects cache_, queue_ and inFlight_ against concurrent readers.
+    OSMutex lock_;
+    /// All known nodes.
+    std::map<NodeID, Entry> cache_;
+    /// Nodes waiting for a query slot.
+    std::deque<NodeID> queue_;
+    /// Nodes being queried.
+    std::vector<NodeID> inFlight_;
+    /// Maximum size of inFlight_.
+    unsigned maxParallel_;
+    /// True if the flow is waiting for something to be enqueued.
+    bool isIdle_ {false};
+    /// True if the flow is sleeping on the timer.
+    bool isSleeping_ {false};
+};
+
+} // namespace openlcb
+
+#endif // _OPENLCB_NODEINVENTORY_HXX_
@@ -31,6 +31,9 @@
  * @date 14 December 2014
  */
 
+#ifndef _OPENLCB_STREAMDEFS_HXX_
+#define _OPENLCB_STREAMDEFS_HXX_
+
 #include "openlcb/If.hxx"
 
 namespace openlcb
@@ -59,9 +62,19 @@ struct StreamDefs
         REJECT_TEMPORARY_OUT_OF_ORDER = 0x40,
     };
 
+    /// Stream ID value that is reserved; means "not assigned yet".
+    static constexpr uint8_t INVALID_STREAM_ID = 0xff;
+
+    /// Creates the payload of a stream initiate request message.
+    /// @param max_buffer_size proposed buffer size (bytes between proceeds)
+    /// @param has_ident true if the stream will start with a content type ID
+    /// @param src_stream_id stream ID assigned by the sender
+    /// @param dst_stream_id proposed stream ID at the receiver; if it is
+    /// INVALID_STREAM_ID then the receiver chooses.
+    /// @return message payload
     static Payload create_initiate_request(uint16_t max_buffer_size,
-                                           bool has_ident,
-                                           uint8_t src_stream_id)
+        bool has_ident, uint8_t src_stream_id,
+        uint8_t dst_stream_id = INVALID_STREAM_ID)
     {
         Payload p(5, 0);
         p[0] = max_buffer_size >> 8;
@@ -69,6 +82,44 @@ struct StreamDefs
         p[2] = has_ident ? FLAG_CARRIES_ID : 0;
         p[3] = 0;
         p[4] = src_stream_id;
+        if (dst_stream_id != INVALID_STREAM_ID)
+        {
+            p.push_back(dst_stream_id);
+        }
+        return p;
+    }
+
+    /// Creates the payload of a stream initiate reply message.
+    /// @param max_buffer_size negotiated buffer size, 0 if rejected
+    /// @param src_stream_id stream ID from the initiate request
+    /// @param dst_stream_id stream ID assigned by the receiver
+    /// @param flags FLAG_ACCEPT, or the reject flags
+    /// @param additional_flags reject reason
+    /// @return message payload
+    static Payload create_initiate_response(uint16_t max_buffer_size,
+        uint8_t src_stream_id, uint8_t dst_stream_id,
+        uint8_t flags = FLAG_ACCEPT, uint8_t additional_flags = 0)
+    {
+        Payload p(6, 0);
+        p[0] = max_buffer_size >> 8;
+        p[1] = max_buffer_size & 0xff;
+        p[2] = flags;
+        p[3] = additional_flags;
+        p[4] = src_stream_id;
+        p[5] = dst_stream_id;
+        return p;
+    }
+
+    /// Creates the payload of a stream proceed message.
+    /// @param src_stream_id stream ID assigned by the sender
+    /// @param dst_stream_id stream ID assigned by the receiver
+    /// @return message payload
+    static Payload create_data_proceed(
+        uint8_t src_stream_id, uint8_t dst_stream_id)
+    {
+        Payload p(4, 0);
+        p[0] = src_stream_id;
+        p[1] = dst_stream_id;
         return p;
     }
 
@@ -82,3 +133,5 @@ struct StreamDefs
 };
 
 } // namespace openlcb
+
+#endif // _OPENLCB_STREAMDEFS_HXX_
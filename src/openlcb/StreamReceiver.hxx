@@ -0,0 +1,519 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file StreamReceiver.hxx
+ *
+ * Flow that receives data from a remote node using the OpenLCB stream
+ * protocol.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#ifndef _OPENLCB_STREAMRECEIVER_HXX_
+#define _OPENLCB_STREAMRECEIVER_HXX_
+
+#include "executor/StateFlow.hxx"
+#include "nmranet_config.h"
+#include "openlcb/StreamService.hxx"
+
+namespace openlcb
+{
+
+/// Receiving side of an OpenLCB stream. Usage:
+///
+/// - start() arms the receiver. The stream initiate request from the sender
+///   is then accepted automatically.
+/// - wait_for_data() until there is data, the stream is closed or there was
+///   an error.
+/// - Process the data at front() (front_size() bytes) and call consume() with
+///   the number of bytes processed, or take over the whole message buffer
+///   with take_chunk().
+/// - stop() when done.
+///
+/// The receiver grants the sender stream_receiver_window buffers ahead: the
+/// proceed messages are sent when the consumed bytes free up a buffer, thus
+/// the sender can never get ahead of the consumer by more than that. The
+/// received stream data messages are queued without copying, small ones
+/// (e.g. single CAN frames) are merged.
+///
+/// All calls must be made on the executor of the interface.
+class StreamReceiver : public StateFlowBase
+{
+public:
+    /// @param service the stream service of the interface to receive on.
+    StreamReceiver(StreamService *service)
+        : StateFlowBase(service->iface())
+        , streamService_(service)
+        , isOpen_(0)
+        , isClosed_(0)
+        , isWaiting_(0)
+        , isRegistered_(0)
+    {
+    }
+
+    ~StreamReceiver()
+    {
+        stop();
+    }
+
+    /// Error codes in error().
+    enum ResultCodes
+    {
+        /// Timed out waiting for the stream data.
+        TIMEOUT = Defs::ERROR_PERMANENT | Defs::OPENMRN_TIMEOUT,
+    };
+
+    /// Stream data messages smaller than this are merged into the previous
+    /// queued message.
+    static constexpr unsigned MERGE_LIMIT = 256;
+
+    /// Arms the receiver for an incoming stream.
+    /// @param node local node receiving the stream
+    /// @param src the node that will send the stream. If empty (id and alias
+    /// both zero), a stream from any node is accepted.
+    /// @param dst_stream_id our stream ID, usually from
+    /// StreamService::allocate_stream_id().
+    /// @param max_buffer_size the largest buffer size we accept. 0 to use the
+    /// stream_buffer_size constant.
+    void start(Node *node, NodeHandle src, uint8_t dst_stream_id,
+        uint16_t max_buffer_size = 0)
+    {
+        HASSERT(is_terminated() && !isRegistered_);
+        node_ = node;
+        src_ = src;
+        dstStreamId_ = dst_stream_id;
+        srcStreamId_ = StreamDefs::INVALID_STREAM_ID;
+        maxBufferSize_ = max_buffer_size ? max_buffer_size
+                                         : config_stream_buffer_size();
+        bufferSize_ = 0;
+        consumed_ = 0;
+        totalBytes_ = 0;
+        error_ = 0;
+        isOpen_ = 0;
+        isClosed_ = 0;
+        streamService_->register_receiver(node_, dstStreamId_, this);
+        isRegistered_ = 1;
+    }
+
+    /// Disarms the receiver. Any data not consumed is dropped.
+    void stop()
+    {
+        if (isRegistered_)
+        {
+            streamService_->unregister_receiver(node_, dstStreamId_, this);
+            isRegistered_ = 0;
+        }
+        release_data();
+        isOpen_ = 0;
+    }
+
+    /// Tells the sender that the stream data could not be processed, then
+    /// disarms the receiver.
+    /// @param error_code the OpenLCB error code to send.
+    void close_with_error(uint16_t error_code)
+    {
+        if (isOpen_ && !isClosed_)
+        {
+            Payload p;
+            p.push_back(error_code >> 8);
+            p.push_back(error_code & 0xff);
+            p.push_back(Defs::MTI_STREAM_DATA >> 8);
+            p.push_back(Defs::MTI_STREAM_DATA & 0xff);
+            send_message(Defs::MTI_TERMINATE_DUE_TO_ERROR, std::move(p));
+        }
+        error_ = error_code;
+        stop();
+    }
+
+    /// Waits until there is some data, or the stream is closed, or an error
+    /// happened.
+    /// @param done will be notified.
+    void wait_for_data(Notifiable *done)
+    {
+        HASSERT(is_terminated());
+        done_ = done;
+        start_flow(STATE(wait_entry));
+    }
+
+    /// @return the number of bytes received and not yet consumed.
+    size_t available()
+    {
+        return available_;
+    }
+
+    /// @return the first byte not yet consumed. Valid until the next
+    /// consume() or take_chunk() call.
+    const uint8_t *front()
+    {
+        HASSERT(current_);
+        return (const uint8_t *)current_->data()->payload.data() + offset_;
+    }
+
+    /// @return the number of contiguous bytes at front(). Zero if there is
+    /// no data.
+    size_t front_size()
+    {
+        return current_ ? current_->data()->payload.size() - offset_ : 0;
+    }
+
+    /// Removes data from the beginning of the queue. Sends the proceed
+    /// messages as needed.
+    /// @param len number of bytes; at most front_size().
+    void consume(size_t len)
+    {
+        HASSERT(len <= front_size());
+        offset_ += len;
+        if (offset_ >= current_->data()->payload.size())
+        {
+            current_->unref();
+            next_current();
+        }
+        data_consumed(len);
+    }
+
+    /// Hands over the message buffer at the front of the queue without
+    /// copying. The data in it counts as consumed.
+    /// @param offset will be set to the offset of the first data byte in the
+    /// payload of the returned buffer.
+    /// @return the message buffer, ownership is transferred to the caller;
+    /// nullptr if there is no data.
+    Buffer<GenMessage> *take_chunk(size_t *offset)
+    {
+        if (!current_)
+        {
+            return nullptr;
+        }
+        auto *b = current_;
+        *offset = offset_;
+        size_t len = front_size();
+        next_current();
+        data_consumed(len);
+        return b;
+    }
+
+    /// @return true if the stream complete message arrived.
+    bool is_closed()
+    {
+        return isClosed_;
+    }
+
+    /// @return 0 if the stream is fine, otherwise an error code.
+    int error()
+    {
+        return error_;
+    }
+
+    /// @return the negotiated buffer size.
+    uint16_t buffer_size()
+    {
+        return bufferSize_;
+    }
+
+    /// @return the total number of data bytes received.
+    uint32_t total_bytes()
+    {
+        return totalBytes_;
+    }
+
+    /// Sets how long wait_for_data() waits. @param timeout_nsec timeout in
+    /// nanoseconds.
+    void set_timeout(long long timeout_nsec)
+    {
+        timeoutNsec_ = timeout_nsec;
+    }
+
+private:
+    friend class StreamService;
+
+    /// @return the interface we are sending to.
+    If *iface()
+    {
+        return streamService_->iface();
+    }
+
+    /// @return true if wait_for_data should return.
+    bool has_event()
+    {
+        return current_ || isClosed_ || error_;
+    }
+
+    Action wait_entry()
+    {
+        if (has_event())
+        {
+            return finish();
+        }
+        isWaiting_ = 1;
+        return sleep_and_call(&timer_, timeoutNsec_, STATE(wait_done));
+    }
+
+    Action wait_done()
+    {
+        isWaiting_ = 0;
+        if (!has_event())
+        {
+            LOG(INFO, "Stream %u: timeout waiting for data.",
+                (unsigned)dstStreamId_);
+            error_ = TIMEOUT;
+        }
+        return finish();
+    }
+
+    /// Notifies the caller.
+    Action finish()
+    {
+        Notifiable *d = done_;
+        done_ = nullptr;
+        if (d)
+        {
+            d->notify();
+        }
+        return exit();
+    }
+
+    /// Moves the next queued message to current_.
+    void next_current()
+    {
+        if (pending_.empty())
+        {
+            current_ = nullptr;
+            tail_ = nullptr;
+        }
+        else
+        {
+            current_ = static_cast<Buffer<GenMessage> *>(pending_.next().item);
+        }
+        offset_ = 1;
+    }
+
+    /// Accounts for consumed data and sends the proceed messages.
+    /// @param len number of bytes consumed.
+    void data_consumed(size_t len)
+    {
+        available_ -= len;
+        consumed_ += len;
+        while (bufferSize_ && consumed_ >= bufferSize_)
+        {
+            consumed_ -= bufferSize_;
+            send_proceed();
+        }
+    }
+
+    /// Drops all queued data.
+    void release_data()
+    {
+        if (current_)
+        {
+            current_->unref();
+        }
+        while (!pending_.empty())
+        {
+            static_cast<Buffer<GenMessage> *>(pending_.next().item)->unref();
+        }
+        current_ = nullptr;
+        tail_ = nullptr;
+        available_ = 0;
+    }
+
+    /// Sends a stream proceed message if the stream is still open.
+    void send_proceed()
+    {
+        if (isOpen_ && !isClosed_)
+        {
+            send_message(Defs::MTI_STREAM_PROCEED,
+                StreamDefs::create_data_proceed(srcStreamId_, dstStreamId_));
+        }
+    }
+
+    /// Sends a message to the stream sender.
+    /// @param mti message type
+    /// @param payload message contents
+    void send_message(Defs::MTI mti, Payload payload)
+    {
+        Buffer<GenMessage> *b;
+        mainBufferPool->alloc(&b);
+        b->data()->reset(mti, node_->node_id(), src_, std::move(payload));
+        iface()->addressed_message_write_flow()->send(b);
+    }
+
+    /// @param m an incoming message.
+    /// @return true if m is from the sender of our stream.
+    bool is_from_sender(GenMessage *m)
+    {
+        return iface()->matching_node(src_, m->src);
+    }
+
+    /// Wakes up the flow if it is waiting for an incoming message.
+    void wakeup()
+    {
+        if (isWaiting_)
+        {
+            // Only once: the timer is not active anymore until the flow runs.
+            isWaiting_ = 0;
+            timer_.ensure_triggered();
+        }
+    }
+
+    /// Called by the service to find a receiver for an initiate request that
+    /// did not name a destination stream ID.
+    /// @param m the initiate request.
+    /// @return true if this receiver is waiting for this stream.
+    bool can_accept(GenMessage *m)
+    {
+        return !isOpen_ && (!(src_.id || src_.alias) || is_from_sender(m));
+    }
+
+    /// Called by the service for the stream initiate request messages.
+    /// @param m the message.
+    void initiate_request(GenMessage *m)
+    {
+        const string &p = m->payload;
+        if (isOpen_ || !can_accept(m))
+        {
+            return;
+        }
+        src_ = m->src;
+        srcStreamId_ = p[4];
+        uint16_t size = ((uint8_t)p[0] << 8) | (uint8_t)p[1];
+        if (!size)
+        {
+            send_message(Defs::MTI_STREAM_INITIATE_REPLY,
+                StreamDefs::create_initiate_response(0, srcStreamId_,
+                    dstStreamId_, StreamDefs::FLAG_PERMANENT_ERROR,
+                    StreamDefs::REJECT_PERMANENT_INVALID_REQUEST));
+            return;
+        }
+        bufferSize_ = std::min(size, maxBufferSize_);
+        isOpen_ = 1;
+        send_message(Defs::MTI_STREAM_INITIATE_REPLY,
+            StreamDefs::create_initiate_response(
+                bufferSize_, srcStreamId_, dstStreamId_));
+        // The reply grants the first buffer, these the rest of the window.
+        for (int i = 1; i < config_stream_receiver_window(); ++i)
+        {
+            send_proceed();
+        }
+    }
+
+    /// Called by the service for the stream data messages.
+    /// @param b the message; ownership is transferred.
+    void data(Buffer<GenMessage> *b)
+    {
+        GenMessage *m = b->data();
+        size_t len = m->payload.size() - 1;
+        if (!isOpen_ || isClosed_ || !len || !is_from_sender(m))
+        {
+            b->unref();
+            return;
+        }
+        totalBytes_ += len;
+        available_ += len;
+        if (tail_ && tail_ != current_ &&
+            tail_->data()->payload.size() + len <= MERGE_LIMIT)
+        {
+            // Grows the merge target once to the limit.
+            payload_reserve(&tail_->data()->payload, MERGE_LIMIT);
+            tail_->data()->payload.append(m->payload, 1, string::npos);
+            b->unref();
+        }
+        else if (!current_)
+        {
+            current_ = tail_ = b;
+            offset_ = 1;
+        }
+        else
+        {
+            pending_.insert(b);
+            tail_ = b;
+        }
+        wakeup();
+    }
+
+    /// Called by the service for the stream complete messages.
+    /// @param m the message.
+    void complete(GenMessage *m)
+    {
+        const string &p = m->payload;
+        if (!isOpen_ || (uint8_t)p[0] != srcStreamId_ || !is_from_sender(m))
+        {
+            return;
+        }
+        isClosed_ = 1;
+        wakeup();
+    }
+
+    /// Service we are registered with.
+    StreamService *streamService_;
+    /// Local node receiving the stream.
+    Node *node_;
+    /// Remote node sending the stream.
+    NodeHandle src_;
+    /// Oldest stream data message with data not yet consumed.
+    Buffer<GenMessage> *current_{nullptr};
+    /// Newest stream data message, merge target for small messages. Never
+    /// the same as current_ when merging, so front() stays valid.
+    Buffer<GenMessage> *tail_{nullptr};
+    /// Stream data messages after current_.
+    Q pending_;
+    /// Offset of the first unconsumed byte in current_'s payload.
+    size_t offset_{1};
+    /// Number of bytes queued.
+    size_t available_{0};
+    /// Who to notify when wait_for_data is done.
+    Notifiable *done_{nullptr};
+    /// Timeout for the incoming data.
+    long long timeoutNsec_{SEC_TO_NSEC(3)};
+    /// Total number of data bytes received.
+    uint32_t totalBytes_{0};
+    /// Error code, 0 if all is fine.
+    int error_{0};
+    /// Number of bytes consumed since the last proceed message.
+    uint32_t consumed_;
+    /// Largest buffer size we accept.
+    uint16_t maxBufferSize_;
+    /// Negotiated buffer size.
+    uint16_t bufferSize_;
+    /// The sender's stream ID.
+    uint8_t srcStreamId_;
+    /// Our stream ID.
+    uint8_t dstStreamId_;
+    /// 1 if the stream is open.
+    uint8_t isOpen_ : 1;
+    /// 1 if the stream complete message arrived.
+    uint8_t isClosed_ : 1;
+    /// 1 if the flow is sleeping on the timer.
+    uint8_t isWaiting_ : 1;
+    /// 1 if we are registered with the stream service.
+    uint8_t isRegistered_ : 1;
+
+    /// Helper for sleeping.
+    StateFlowTimer timer_{this};
+};
+
+} // namespace openlcb
+
+#endif // _OPENLCB_STREAMRECEIVER_HXX_
@@ -0,0 +1,588 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file StreamSender.hxx
+ *
+ * Flow that sends data to a remote node using the OpenLCB stream protocol.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#ifndef _OPENLCB_STREAMSENDER_HXX_
+#define _OPENLCB_STREAMSENDER_HXX_
+
+#include "executor/StateFlow.hxx"
+#include "nmranet_config.h"
+#include "openlcb/StreamService.hxx"
+
+namespace openlcb
+{
+
+/// Sending side of an OpenLCB stream. Usage:
+///
+/// - start_stream() sends the stream initiate request and waits for the
+///   reply. This negotiates the buffer size, i.e. how many bytes may be sent
+///   before the receiver has to send a stream proceed message.
+/// - send_data() or send_chunk() any number of times. Whenever the buffer at
+///   the receiver is full, the flow waits for a stream proceed message.
+/// - close_stream() sends the stream complete message.
+///
+/// Each call notifies the done notifiable when it is completed. Check error()
+/// then; after an error the stream is closed. Only one call may be
+/// outstanding at a time. All calls must be made on the executor of the
+/// interface. The sender can be reused for another stream after it was
+/// closed.
+class StreamSender : public StateFlowBase
+{
+public:
+    /// @param service the stream service of the interface to send on.
+    StreamSender(StreamService *service)
+        : StateFlowBase(service->iface())
+        , streamService_(service)
+        , isOpen_(0)
+        , isReplied_(0)
+        , isWaiting_(0)
+        , isRegistered_(0)
+    {
+    }
+
+    ~StreamSender()
+    {
+        unregister();
+        release_chunk();
+    }
+
+    /// Error codes in error(), in addition to the OpenLCB error codes sent by
+    /// the remote node.
+    enum ResultCodes
+    {
+        /// Timed out waiting for the initiate reply or for a proceed message.
+        TIMEOUT = Defs::ERROR_PERMANENT | Defs::OPENMRN_TIMEOUT,
+    };
+
+    /// At most this many data bytes are copied into one stream data message
+    /// by send_data(). On CAN this is 32 frames.
+    static constexpr unsigned MAX_BYTES_PER_MESSAGE = 7 * 32;
+
+    /// Opens a stream.
+    /// @param node local node to send the stream from
+    /// @param dst the stream receiver
+    /// @param src_stream_id our stream ID, usually from
+    /// StreamService::allocate_stream_id().
+    /// @param dst_stream_id stream ID at the receiver, if it was already
+    /// agreed (e.g. in a datagram), otherwise StreamDefs::INVALID_STREAM_ID.
+    /// @param max_buffer_size proposed buffer size; the receiver may make it
+    /// smaller. 0 to use the stream_buffer_size constant.
+    /// @param done notified when the stream is open or failed to open.
+    void start_stream(Node *node, NodeHandle dst, uint8_t src_stream_id,
+        uint8_t dst_stream_id, uint16_t max_buffer_size, Notifiable *done)
+    {
+        HASSERT(is_terminated() && !isRegistered_);
+        node_ = node;
+        dst_ = dst;
+        srcStreamId_ = src_stream_id;
+        dstStreamId_ = dst_stream_id;
+        bufferSize_ = max_buffer_size ? max_buffer_size
+                                      : config_stream_buffer_size();
+        available_ = 0;
+        error_ = 0;
+        totalBytes_ = 0;
+        done_ = done;
+        isOpen_ = 0;
+        isReplied_ = 0;
+        isWaiting_ = 0;
+        streamService_->register_sender(node_, srcStreamId_, this);
+        isRegistered_ = 1;
+        start_flow(STATE(send_initiate));
+    }
+
+    /// Sends data on an open stream. The data is copied into the outgoing
+    /// messages.
+    /// @param data bytes to send; must stay valid until done is notified.
+    /// @param len number of bytes.
+    /// @param done notified when all the data was handed to the interface.
+    void send_data(const void *data, size_t len, Notifiable *done)
+    {
+        HASSERT(is_terminated());
+        data_ = static_cast<const uint8_t *>(data);
+        remaining_ = len;
+        done_ = done;
+        start_flow(STATE(send_next_message));
+    }
+
+    /// Sends data on an open stream without copying it. The buffer is handed
+    /// to the interface as the stream data message once the receiver has room
+    /// for all of it. Chunks larger than the negotiated buffer size are
+    /// copied into multiple messages instead.
+    /// @param chunk the data to send from payload offset 1 onwards; payload
+    /// byte 0 is overwritten with the destination stream ID. Ownership is
+    /// transferred.
+    /// @param done notified when all the data was handed to the interface.
+    void send_chunk(Buffer<GenMessage> *chunk, Notifiable *done)
+    {
+        HASSERT(is_terminated() && !chunk_);
+        HASSERT(!chunk->data()->payload.empty());
+        chunk_ = chunk;
+        done_ = done;
+        start_flow(STATE(send_chunk_entry));
+    }
+
+    /// Allocates a buffer for send_chunk().
+    /// @param reserve_bytes how many data bytes will be added.
+    /// @return a buffer with one placeholder byte in the payload.
+    static Buffer<GenMessage> *alloc_chunk(size_t reserve_bytes)
+    {
+        Buffer<GenMessage> *b;
+        mainBufferPool->alloc(&b);
+        b->data()->payload.reserve(reserve_bytes + 1);
+        b->data()->payload.push_back(0);
+        return b;
+    }
+
+    /// Closes the stream by sending the stream complete message.
+    /// @param done notified when the message was handed to the interface.
+    void close_stream(Notifiable *done)
+    {
+        HASSERT(is_terminated());
+        done_ = done;
+        start_flow(STATE(send_close));
+    }
+
+    /// @return 0 if the last operation succeeded, otherwise an error code.
+    int error()
+    {
+        return error_;
+    }
+
+    /// @return true if the stream is open for sending data.
+    bool is_open()
+    {
+        return isOpen_;
+    }
+
+    /// @return the negotiated buffer size.
+    uint16_t buffer_size()
+    {
+        return bufferSize_;
+    }
+
+    /// @return the stream ID at the receiver.
+    uint8_t dst_stream_id()
+    {
+        return dstStreamId_;
+    }
+
+    /// @return the total number of data bytes sent on this stream.
+    uint32_t total_bytes()
+    {
+        return totalBytes_;
+    }
+
+    /// Sets how long to wait for the initiate reply and the proceed
+    /// messages. @param timeout_nsec timeout in nanoseconds.
+    void set_timeout(long long timeout_nsec)
+    {
+        timeoutNsec_ = timeout_nsec;
+    }
+
+private:
+    friend class StreamService;
+
+    /// @return the interface we are sending to.
+    If *iface()
+    {
+        return streamService_->iface();
+    }
+
+    Action send_initiate()
+    {
+        return allocate_and_call(
+            iface()->addressed_message_write_flow(), STATE(fill_initiate));
+    }
+
+    Action fill_initiate()
+    {
+        auto *b =
+            get_allocation_result(iface()->addressed_message_write_flow());
+        b->data()->reset(Defs::MTI_STREAM_INITIATE_REQUEST, node_->node_id(),
+            dst_,
+            StreamDefs::create_initiate_request(
+                bufferSize_, false, srcStreamId_, dstStreamId_));
+        iface()->addressed_message_write_flow()->send(b);
+        isWaiting_ = 1;
+        return sleep_and_call(&timer_, timeoutNsec_, STATE(initiate_done));
+    }
+
+    Action initiate_done()
+    {
+        isWaiting_ = 0;
+        if (!isReplied_)
+        {
+            error_ = TIMEOUT;
+        }
+        else if (!(flags_ & StreamDefs::FLAG_ACCEPT))
+        {
+            error_ = (flags_ & StreamDefs::FLAG_PERMANENT_ERROR)
+                ? Defs::ERROR_PERMANENT
+                : Defs::ERROR_TEMPORARY;
+            error_ |= additionalFlags_;
+        }
+        else if (!bufferSize_)
+        {
+            error_ = Defs::ERROR_INVALID_ARGS;
+        }
+        else
+        {
+            isOpen_ = 1;
+        }
+        return finish();
+    }
+
+    /// Waits until the receiver has room for the given number of bytes.
+    /// @param needed number of bytes that must fit
+    /// @param next state to continue with
+    Action wait_for_window(size_t needed, Callback next)
+    {
+        if (error_ || !isOpen_)
+        {
+            return finish();
+        }
+        if (available_ >= needed)
+        {
+            return call_immediately(next);
+        }
+        waitNeeded_ = needed;
+        waitNext_ = next;
+        isWaiting_ = 1;
+        return sleep_and_call(&timer_, timeoutNsec_, STATE(proceed_done));
+    }
+
+    Action proceed_done()
+    {
+        isWaiting_ = 0;
+        if (!error_ && available_ < waitNeeded_)
+        {
+            LOG(INFO, "Stream %u: timeout waiting for proceed.",
+                (unsigned)srcStreamId_);
+            error_ = TIMEOUT;
+        }
+        return wait_for_window(waitNeeded_, waitNext_);
+    }
+
+    Action send_next_message()
+    {
+        if (!remaining_)
+        {
+            return finish();
+        }
+        return wait_for_window(1, STATE(allocate_data));
+    }
+
+    Action allocate_data()
+    {
+        return allocate_and_call(
+            iface()->addressed_message_write_flow(), STATE(fill_data));
+    }
+
+    Action fill_data()
+    {
+        auto *b =
+            get_allocation_result(iface()->addressed_message_write_flow());
+        size_t len = remaining_;
+        if (len > available_)
+        {
+            len = available_;
+        }
+        if (len > MAX_BYTES_PER_MESSAGE)
+        {
+            len = MAX_BYTES_PER_MESSAGE;
+        }
+        string payload;
+        payload.reserve(len + 1);
+        payload.push_back(dstStreamId_);
+        payload.append((const char *)data_, len);
+        b->data()->reset(
+            Defs::MTI_STREAM_DATA, node_->node_id(), dst_, std::move(payload));
+        iface()->addressed_message_write_flow()->send(b);
+        data_ += len;
+        remaining_ -= len;
+        available_ -= len;
+        totalBytes_ += len;
+        return call_immediately(STATE(send_next_message));
+    }
+
+    Action send_chunk_entry()
+    {
+        size_t len = chunk_->data()->payload.size() - 1;
+        if (len > bufferSize_)
+        {
+            // Does not fit into the receiver's buffer in one piece.
+            data_ = (const uint8_t *)chunk_->data()->payload.data() + 1;
+            remaining_ = len;
+            return call_immediately(STATE(send_chunk_copy));
+        }
+        return wait_for_window(len, STATE(send_chunk_whole));
+    }
+
+    Action send_chunk_whole()
+    {
+        size_t len = chunk_->data()->payload.size() - 1;
+        auto *b = chunk_;
+        chunk_ = nullptr;
+        GenMessage *m = b->data();
+        m->payload[0] = dstStreamId_;
+        m->mti = Defs::MTI_STREAM_DATA;
+        m->src.id = node_->node_id();
+        m->src.alias = 0;
+        m->dst = dst_;
+        m->flagsSrc = 0;
+        m->flagsDst = 0;
+        m->dstNode = nullptr;
+        iface()->addressed_message_write_flow()->send(b);
+        available_ -= len;
+        totalBytes_ += len;
+        return finish();
+    }
+
+    /// Sends a large chunk by copying it into messages.
+    Action send_chunk_copy()
+    {
+        if (!remaining_)
+        {
+            release_chunk();
+            return finish();
+        }
+        return wait_for_window(1, STATE(allocate_chunk_data));
+    }
+
+    Action allocate_chunk_data()
+    {
+        return allocate_and_call(
+            iface()->addressed_message_write_flow(), STATE(fill_chunk_data));
+    }
+
+    Action fill_chunk_data()
+    {
+        fill_data();
+        return call_immediately(STATE(send_chunk_copy));
+    }
+
+    Action send_close()
+    {
+        if (!isOpen_)
+        {
+            return finish();
+        }
+        return allocate_and_call(
+            iface()->addressed_message_write_flow(), STATE(fill_close));
+    }
+
+    Action fill_close()
+    {
+        auto *b =
+            get_allocation_result(iface()->addressed_message_write_flow());
+        b->data()->reset(Defs::MTI_STREAM_COMPLETE, node_->node_id(), dst_,
+            StreamDefs::create_close_request(srcStreamId_, dstStreamId_));
+        iface()->addressed_message_write_flow()->send(b);
+        isOpen_ = 0;
+        return finish();
+    }
+
+    /// Notifies the caller of the current operation. Unregisters from the
+    /// service if the stream is closed.
+    Action finish()
+    {
+        if (error_)
+        {
+            isOpen_ = 0;
+            release_chunk();
+        }
+        if (!isOpen_)
+        {
+            unregister();
+        }
+        Notifiable *d = done_;
+        done_ = nullptr;
+        if (d)
+        {
+            d->notify();
+        }
+        return exit();
+    }
+
+    /// Frees the chunk given to send_chunk() if it was not sent.
+    void release_chunk()
+    {
+        if (chunk_)
+        {
+            chunk_->unref();
+            chunk_ = nullptr;
+        }
+    }
+
+    /// Removes this sender from the stream service.
+    void unregister()
+    {
+        if (isRegistered_)
+        {
+            streamService_->unregister_sender(node_, srcStreamId_, this);
+            isRegistered_ = 0;
+        }
+    }
+
+    /// @param m an incoming message.
+    /// @return true if m is from the receiver of our stream.
+    bool is_from_receiver(GenMessage *m)
+    {
+        return iface()->matching_node(dst_, m->src);
+    }
+
+    /// Wakes up the flow if it is waiting for an incoming message.
+    void wakeup()
+    {
+        if (isWaiting_)
+        {
+            // Only once: the timer is not active anymore until the flow runs.
+            isWaiting_ = 0;
+            timer_.ensure_triggered();
+        }
+    }
+
+    /// Called by the service for the stream initiate reply messages.
+    /// @param m the message.
+    void initiate_reply(GenMessage *m)
+    {
+        const string &p = m->payload;
+        if (isReplied_ || !is_from_receiver(m))
+        {
+            return;
+        }
+        uint16_t size = ((uint8_t)p[0] << 8) | (uint8_t)p[1];
+        if (size < bufferSize_)
+        {
+            bufferSize_ = size;
+        }
+        flags_ = p[2];
+        additionalFlags_ = p[3];
+        dstStreamId_ = p[5];
+        available_ = bufferSize_;
+        if (!dst_.alias)
+        {
+            dst_.alias = m->src.alias;
+        }
+        isReplied_ = 1;
+        wakeup();
+    }
+
+    /// Called by the service for the stream proceed messages.
+    /// @param m the message.
+    void proceed(GenMessage *m)
+    {
+        const string &p = m->payload;
+        // The receiver may send proceed messages right after the initiate
+        // reply, before the flow has seen the reply.
+        if (!isReplied_ || !(flags_ & StreamDefs::FLAG_ACCEPT) ||
+            !is_from_receiver(m) || (uint8_t)p[1] != dstStreamId_)
+        {
+            return;
+        }
+        available_ += bufferSize_;
+        wakeup();
+    }
+
+    /// Called by the service for the terminate due to error messages. The
+    /// receiver sends these when it can not process the stream data.
+    /// @param m the message.
+    void terminate(GenMessage *m)
+    {
+        const string &p = m->payload;
+        if (!is_from_receiver(m))
+        {
+            return;
+        }
+        error_ = ((uint8_t)p[0] << 8) | (uint8_t)p[1];
+        if (!error_)
+        {
+            error_ = Defs::ERROR_PERMANENT;
+        }
+        LOG(INFO, "Stream %u: terminated by receiver, error 0x%04x.",
+            (unsigned)srcStreamId_, error_);
+        wakeup();
+    }
+
+    /// Service we are registered with.
+    StreamService *streamService_;
+    /// Local node sending the stream.
+    Node *node_;
+    /// Remote node receiving the stream.
+    NodeHandle dst_;
+    /// Next byte to send.
+    const uint8_t *data_;
+    /// Number of bytes left to send from data_.
+    size_t remaining_{0};
+    /// State to continue with when the window opens up.
+    Callback waitNext_;
+    /// Number of bytes the flow is waiting to fit into the window.
+    size_t waitNeeded_;
+    /// Chunk given to send_chunk() and not sent yet.
+    Buffer<GenMessage> *chunk_{nullptr};
+    /// Who to notify when the current operation is done.
+    Notifiable *done_{nullptr};
+    /// Timeout for the incoming messages.
+    long long timeoutNsec_{SEC_TO_NSEC(3)};
+    /// Total number of data bytes sent.
+    uint32_t totalBytes_{0};
+    /// Error code, 0 if all is fine.
+    int error_{0};
+    /// How many bytes we may send before the next proceed message.
+    uint32_t available_;
+    /// Negotiated buffer size.
+    uint16_t bufferSize_;
+    /// Our stream ID.
+    uint8_t srcStreamId_;
+    /// The receiver's stream ID.
+    uint8_t dstStreamId_;
+    /// Flags from the initiate reply.
+    uint8_t flags_;
+    /// Additional flags from the initiate reply.
+    uint8_t additionalFlags_;
+    /// 1 if the stream is open.
+    uint8_t isOpen_ : 1;
+    /// 1 if the initiate reply arrived.
+    uint8_t isReplied_ : 1;
+    /// 1 if the flow is sleeping on the timer.
+    uint8_t isWaiting_ : 1;
+    /// 1 if we are registered with the stream service.
+    uint8_t isRegistered_ : 1;
+
+    /// Helper for sleeping.
+    StateFlowTimer timer_{this};
+};
+
+} // namespace openlcb
+
+#endif // _OPENLCB_STREAMSENDER_HXX_
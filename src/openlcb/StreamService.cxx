@@ -0,0 +1,282 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ * \file StreamService.cxx
+ *
+ * Dispatches the incoming stream protocol messages to the stream senders and
+ * receivers of the local nodes.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#include "openlcb/StreamService.hxx"
+
+#include "openlcb/StreamReceiver.hxx"
+#include "openlcb/StreamSender.hxx"
+
+namespace openlcb
+{
+
+StreamService::StreamService(If *iface)
+    : iface_(iface)
+{
+    auto *d = iface_->dispatcher();
+    d->register_handler(&initiateRequestHandler_,
+        Defs::MTI_STREAM_INITIATE_REQUEST, Defs::MTI_EXACT);
+    d->register_handler(&initiateReplyHandler_,
+        Defs::MTI_STREAM_INITIATE_REPLY, Defs::MTI_EXACT);
+    d->register_handler(
+        &proceedHandler_, Defs::MTI_STREAM_PROCEED, Defs::MTI_EXACT);
+    d->register_handler(&dataHandler_, Defs::MTI_STREAM_DATA, Defs::MTI_EXACT);
+    d->register_handler(
+        &completeHandler_, Defs::MTI_STREAM_COMPLETE, Defs::MTI_EXACT);
+    d->register_handler(
+        &terminateHandler_, Defs::MTI_TERMINATE_DUE_TO_ERROR, Defs::MTI_EXACT);
+}
+
+StreamService::~StreamService()
+{
+    auto *d = iface_->dispatcher();
+    d->unregister_handler(&initiateRequestHandler_,
+        Defs::MTI_STREAM_INITIATE_REQUEST, Defs::MTI_EXACT);
+    d->unregister_handler(&initiateReplyHandler_,
+        Defs::MTI_STREAM_INITIATE_REPLY, Defs::MTI_EXACT);
+    d->unregister_handler(
+        &proceedHandler_, Defs::MTI_STREAM_PROCEED, Defs::MTI_EXACT);
+    d->unregister_handler(
+        &dataHandler_, Defs::MTI_STREAM_DATA, Defs::MTI_EXACT);
+    d->unregister_handler(
+        &completeHandler_, Defs::MTI_STREAM_COMPLETE, Defs::MTI_EXACT);
+    d->unregister_handler(
+        &terminateHandler_, Defs::MTI_TERMINATE_DUE_TO_ERROR, Defs::MTI_EXACT);
+}
+
+uint8_t StreamService::allocate_stream_id(Node *node)
+{
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        uint8_t id = nextId_++;
+        if (id == 0 || id == StreamDefs::INVALID_STREAM_ID)
+        {
+            continue;
+        }
+        if (!is_id_used(node, id))
+        {
+            return id;
+        }
+    }
+    return StreamDefs::INVALID_STREAM_ID;
+}
+
+bool StreamService::is_id_used(Node *node, uint8_t id)
+{
+    return senders_.lookup(node, id) || receivers_.lookup(node, id);
+}
+
+void StreamService::register_sender(
+    Node *node, uint8_t id, StreamSender *sender)
+{
+    HASSERT(!senders_.lookup(node, id));
+    senders_.insert(node, id, sender);
+}
+
+void StreamService::unregister_sender(
+    Node *node, uint8_t id, StreamSender *sender)
+{
+    senders_.erase(node, id, sender);
+}
+
+void StreamService::register_receiver(
+    Node *node, uint8_t id, StreamReceiver *receiver)
+{
+    HASSERT(!receivers_.lookup(node, id));
+    receivers_.insert(node, id, receiver);
+}
+
+void StreamService::unregister_receiver(
+    Node *node, uint8_t id, StreamReceiver *receiver)
+{
+    receivers_.erase(node, id, receiver);
+}
+
+void StreamService::initiate_request(Buffer<GenMessage> *b)
+{
+    auto rb = get_buffer_deleter(b);
+    GenMessage *m = b->data();
+    const string &p = m->payload;
+    if (!m->dstNode || p.size() < 5)
+    {
+        return;
+    }
+    StreamReceiver *r = nullptr;
+    if (p.size() >= 6 && (uint8_t)p[5] != StreamDefs::INVALID_STREAM_ID)
+    {
+        r = receivers_.lookup(m->dstNode, (uint8_t)p[5]);
+        if (!r || !r->can_accept(m))
+        {
+            return reject_initiate(m, StreamDefs::FLAG_PERMANENT_ERROR,
+                StreamDefs::REJECT_PERMANENT_INVALID_REQUEST);
+        }
+    }
+    else
+    {
+        bool found_any = false;
+        for (auto it = receivers_.begin(); it != receivers_.end(); ++it)
+        {
+            auto e = *it;
+            if (e.first.first != m->dstNode)
+            {
+                continue;
+            }
+            found_any = true;
+            if (e.second->can_accept(m))
+            {
+                r = e.second;
+                break;
+            }
+        }
+        if (!r)
+        {
+            if (found_any)
+            {
+                return reject_initiate(
+                    m, 0, StreamDefs::REJECT_TEMPORARY_BUFFER_FULL);
+            }
+            return reject_initiate(m, StreamDefs::FLAG_PERMANENT_ERROR,
+                StreamDefs::REJECT_PERMANENT_STREAMS_NOT_ACCEPTED);
+        }
+    }
+    r->initiate_request(m);
+}
+
+void StreamService::reject_initiate(
+    GenMessage *m, uint8_t flags, uint8_t additional_flags)
+{
+    const string &p = m->payload;
+    uint8_t dst_id = p.size() >= 6 ? p[5] : StreamDefs::INVALID_STREAM_ID;
+    Buffer<GenMessage> *b;
+    mainBufferPool->alloc(&b);
+    b->data()->reset(Defs::MTI_STREAM_INITIATE_REPLY,
+        m->dstNode->node_id(), m->src,
+        StreamDefs::create_initiate_response(
+            0, p[4], dst_id, flags, additional_flags));
+    iface_->addressed_message_write_flow()->send(b);
+}
+
+void StreamService::initiate_reply(Buffer<GenMessage> *b)
+{
+    auto rb = get_buffer_deleter(b);
+    GenMessage *m = b->data();
+    if (!m->dstNode || m->payload.size() < 6)
+    {
+        return;
+    }
+    StreamSender *s = senders_.lookup(m->dstNode, (uint8_t)m->payload[4]);
+    if (s)
+    {
+        s->initiate_reply(m);
+    }
+}
+
+void StreamService::proceed(Buffer<GenMessage> *b)
+{
+    auto rb = get_buffer_deleter(b);
+    GenMessage *m = b->data();
+    if (!m->dstNode || m->payload.size() < 2)
+    {
+        return;
+    }
+    StreamSender *s = senders_.lookup(m->dstNode, (uint8_t)m->payload[0]);
+    if (s)
+    {
+        s->proceed(m);
+    }
+}
+
+void StreamService::data(Buffer<GenMessage> *b)
+{
+    GenMessage *m = b->data();
+    StreamReceiver *r = nullptr;
+    if (m->dstNode && !m->payload.empty())
+    {
+        r = receivers_.lookup(m->dstNode, (uint8_t)m->payload[0]);
+    }
+    if (!r)
+    {
+        b->unref();
+        return;
+    }
+    // The receiver queues the message buffer itself.
+    r->data(b);
+}
+
+void StreamService::complete(Buffer<GenMessage> *b)
+{
+    auto rb = get_buffer_deleter(b);
+    GenMessage *m = b->data();
+    if (!m->dstNode || m->payload.size() < 2)
+    {
+        return;
+    }
+    StreamReceiver *r = receivers_.lookup(m->dstNode, (uint8_t)m->payload[1]);
+    if (r)
+    {
+        r->complete(m);
+    }
+}
+
+void StreamService::terminate(Buffer<GenMessage> *b)
+{
+    auto rb = get_buffer_deleter(b);
+    GenMessage *m = b->data();
+    const string &p = m->payload;
+    if (!m->dstNode || p.size() < 4)
+    {
+        return;
+    }
+    uint16_t mti = ((uint8_t)p[2] << 8) | (uint8_t)p[3];
+    if (mti != Defs::MTI_STREAM_DATA &&
+        mti != Defs::MTI_STREAM_INITIATE_REQUEST &&
+        mti != Defs::MTI_STREAM_COMPLETE)
+    {
+        // Not about a stream.
+        return;
+    }
+    // The message does not carry the stream ID; every stream sent to the
+    // terminating node is affected.
+    for (auto it = senders_.begin(); it != senders_.end(); ++it)
+    {
+        auto e = *it;
+        if (e.first.first == m->dstNode)
+        {
+            e.second->terminate(m);
+        }
+    }
+}
+
+} // namespace openlcb
@@ -0,0 +1,158 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file StreamService.hxx
+ *
+ * Dispatches the incoming OpenLCB stream protocol messages to the stream
+ * senders and receivers of the local nodes.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#ifndef _OPENLCB_STREAMSERVICE_HXX_
+#define _OPENLCB_STREAMSERVICE_HXX_
+
+#include "openlcb/If.hxx"
+#include "openlcb/StreamDefs.hxx"
+#include "utils/NodeHandlerMap.hxx"
+
+namespace openlcb
+{
+
+class StreamSender;
+class StreamReceiver;
+
+/// Owns the stream protocol message handlers of an interface. Keeps track of
+/// the open streams keyed by (local node, local stream ID), and routes every
+/// incoming stream message to the StreamSender or StreamReceiver it belongs
+/// to. Incoming stream initiate requests that no receiver is waiting for are
+/// rejected.
+///
+/// There should be one StreamService per interface. The senders and
+/// receivers are created by the modules that use streams (e.g. memory config
+/// and the bootloader client), and register themselves here while their
+/// stream is open.
+class StreamService
+{
+public:
+    /// Constructor. Registers the message handlers.
+    /// @param iface the interface to send and receive streams on.
+    StreamService(If *iface);
+
+    /// Destructor. Unregisters the message handlers.
+    ~StreamService();
+
+    /// @return the interface.
+    If *iface()
+    {
+        return iface_;
+    }
+
+    /// Allocates a stream ID that no sender or receiver of a local node is
+    /// using. The IDs are given out in a round-robin manner, so an ID that was
+    /// just released will not be reused soon.
+    /// @param node the local node that will use the stream ID.
+    /// @return the stream ID, or StreamDefs::INVALID_STREAM_ID if all are in
+    /// use.
+    uint8_t allocate_stream_id(Node *node);
+
+private:
+    friend class StreamSender;
+    friend class StreamReceiver;
+
+    /// Registers an open stream sender. @param node local node; @param id
+    /// source stream ID; @param sender the sender.
+    void register_sender(Node *node, uint8_t id, StreamSender *sender);
+    /// Unregisters a stream sender. @param node local node; @param id source
+    /// stream ID; @param sender the sender.
+    void unregister_sender(Node *node, uint8_t id, StreamSender *sender);
+    /// Registers an armed stream receiver. @param node local node; @param id
+    /// destination stream ID; @param receiver the receiver.
+    void register_receiver(Node *node, uint8_t id, StreamReceiver *receiver);
+    /// Unregisters a stream receiver. @param node local node; @param id
+    /// destination stream ID; @param receiver the receiver.
+    void unregister_receiver(
+        Node *node, uint8_t id, StreamReceiver *receiver);
+
+    /// @param node local node
+    /// @param id stream ID
+    /// @return true if a sender or a receiver is using this stream ID.
+    bool is_id_used(Node *node, uint8_t id);
+
+    /// Handles incoming stream initiate request messages.
+    void initiate_request(Buffer<GenMessage> *m);
+    /// Handles incoming stream initiate reply messages.
+    void initiate_reply(Buffer<GenMessage> *m);
+    /// Handles incoming stream proceed messages.
+    void proceed(Buffer<GenMessage> *m);
+    /// Handles incoming stream data messages.
+    void data(Buffer<GenMessage> *m);
+    /// Handles incoming stream complete messages.
+    void complete(Buffer<GenMessage> *m);
+    /// Handles incoming terminate due to error messages.
+    void terminate(Buffer<GenMessage> *m);
+
+    /// Rejects a stream initiate request that no receiver wants.
+    /// @param m the initiate request.
+    /// @param flags the reject flags for the initiate reply.
+    /// @param additional_flags the reject reason.
+    void reject_initiate(
+        GenMessage *m, uint8_t flags, uint8_t additional_flags);
+
+    /// Interface we are registered on.
+    If *iface_;
+    /// Open stream senders by (node, source stream ID).
+    TypedNodeHandlerMap<Node, StreamSender> senders_;
+    /// Armed stream receivers by (node, destination stream ID).
+    TypedNodeHandlerMap<Node, StreamReceiver> receivers_;
+    /// Next stream ID to try in allocate_stream_id().
+    uint8_t nextId_{0};
+
+    /// Handler for the stream initiate request.
+    MessageHandler::GenericHandler initiateRequestHandler_{
+        this, &StreamService::initiate_request};
+    /// Handler for the stream initiate reply.
+    MessageHandler::GenericHandler initiateReplyHandler_{
+        this, &StreamService::initiate_reply};
+    /// Handler for the stream proceed.
+    MessageHandler::GenericHandler proceedHandler_{
+        this, &StreamService::proceed};
+    /// Handler for the stream data.
+    MessageHandler::GenericHandler dataHandler_{this, &StreamService::data};
+    /// Handler for the stream complete.
+    MessageHandler::GenericHandler completeHandler_{
+        this, &StreamService::complete};
+    /// Handler for the terminate due to error.
+    MessageHandler::GenericHandler terminateHandler_{
+        this, &StreamService::terminate};
+
+    DISALLOW_COPY_AND_ASSIGN(StreamService);
+};
+
+} // namespace openlcb
+
+#endif // _OPENLCB_STREAMSERVICE_HXX_
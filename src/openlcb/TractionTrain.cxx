@@ -101,6 +101,7 @@ struct TrainService::Impl
             : IncomingMessageStateFlow(service->iface())
             , reserved_(0)
             , trainService_(service)
+            , trainNode_(nullptr)
             , response_(nullptr)
         {
             iface()->dispatcher()->register_handler(
@@ -116,7 +117,7 @@ struct TrainService::Impl
     protected:
         TrainNode *train_node()
         {
-            return static_cast<TrainNode *>(nmsg()->dstNode);
+            return trainNode_;
         }
 
         Action maybe_alloc_response(Callback c)
@@ -150,12 +151,12 @@ struct TrainService::Impl
                 return release_and_exit();
             }
             // Checks if destination is a local traction-enabled node.
-            if (trainService_->nodes_.find(train_node()) ==
-                trainService_->nodes_.end())
+            trainNode_ = trainService_->find_train(nmsg()->dstNode);
+            if (!trainNode_)
             {
                 LOG(VERBOSE, "Traction message for node %p that is not "
                              "traction enabled.",
-                    train_node());
+                    nmsg()->dstNode);
                 /** @TODO(balazs.racz): This is probably not the good solution
                  * here; since this is an addressed message we should rather
                  * send a reject response. */
@@ -177,7 +178,6 @@ struct TrainService::Impl
                 {
                     SpeedType sp = fp16_to_speed(payload() + 1);
                     train_node()->train()->set_speed(sp);
-                    nextConsistIndex_ = 0;
                     return call_immediately(STATE(maybe_forward_consist));
                 }
                 case TractionDefs::REQ_SET_FN:
@@ -191,13 +191,11 @@ struct TrainService::Impl
                     value <<= 8;
                     value |= payload()[5];
                     train_node()->train()->set_fn(address, value);
-                    nextConsistIndex_ = 0;
                     return call_immediately(STATE(maybe_forward_consist));
                 }
                 case TractionDefs::REQ_EMERGENCY_STOP:
                 {
                     train_node()->train()->set_emergencystop();
-                    nextConsistIndex_ = 0;
                     return call_immediately(STATE(maybe_forward_consist));
                 }
                 case TractionDefs::REQ_QUERY_SPEED: // fall through
@@ -414,88 +412,86 @@ struct TrainService::Impl
             }
         }
 
+        /// Forwards a speed, function or estop command to all members of
+        /// the consist. The forwarded messages are built in one pass over the
+        /// consist list and then handed to the interface back-to-back, so that
+        /// the consist members get their commands without the flow yielding in
+        /// between. The incoming message buffer is reused for the last member.
         Action maybe_forward_consist()
         {
-            auto* train_node = this->train_node();
-            unsigned count = train_node->query_consist_length();
-            if (count <= nextConsistIndex_)
-                return release_and_exit();
-            uint8_t flags = 0;
-            NodeID dst = train_node->query_consist(nextConsistIndex_, &flags);
-            if (iface()->matching_node(nmsg()->src, NodeHandle(dst)))
-            {
-                ++nextConsistIndex_;
-                return again();
-            }
+            auto *train_node = this->train_node();
             uint8_t cmd = payload()[0];
-            bool flip_speed = false;
-            if (cmd == TractionDefs::REQ_SET_SPEED) {
-                if (flags & TractionDefs::CNSTFLAGS_REVERSE) {
-                    flip_speed = true;
-                }
-            } else if (cmd == TractionDefs::REQ_SET_FN) {
+            // Which link flag a member needs to get this command.
+            uint8_t link_flag = 0;
+            if (cmd == TractionDefs::REQ_SET_FN)
+            {
                 uint32_t address = payload()[1];
                 address <<= 8;
                 address |= payload()[2];
                 address <<= 8;
                 address |= payload()[3];
-                if (address == 0) {
-                    if ((flags & TractionDefs::CNSTFLAGS_LINKF0) == 0) {
-                        // skip
-                        ++nextConsistIndex_;
-                        return again();
-                    }
-                } else {
-                    if ((flags & TractionDefs::CNSTFLAGS_LINKFN) == 0) {
-                        // skip
-                        ++nextConsistIndex_;
-                        return again();
-                    }
-                }
+                link_flag = address == 0 ? TractionDefs::CNSTFLAGS_LINKF0
+                                         : TractionDefs::CNSTFLAGS_LINKFN;
             }
-            if (count == nextConsistIndex_ + 1u)
+            TypedQueue<Buffer<GenMessage>> burst;
+            auto tail = burst.begin();
+            // Target and flags of the previous member; its message gets
+            // built once we know whether it is the last one.
+            NodeID pending_dst = 0;
+            uint8_t pending_flags = 0;
+            for (auto it = train_node->consist_begin();
+                 it != train_node->consist_end(); ++it)
             {
-                // last node: we can transfer the message.
-                auto *b = transfer_message();
-                b->data()->src = NodeHandle(train_node->node_id());
-                b->data()->dst = NodeHandle(dst);
-                b->data()->dstNode = nullptr;
-                if (flip_speed) {
-                    b->data()->payload[1] ^= 0x80;
+                NodeID dst = it->get_slave();
+                uint8_t flags = it->get_flags();
+                if ((flags & link_flag) != link_flag ||
+                    iface()->matching_node(nmsg()->src, NodeHandle(dst)))
+                {
+                    continue;
                 }
-                iface()->addressed_message_write_flow()->send(b);
-                return exit();
+                if (pending_dst)
+                {
+                    auto *b = iface()->addressed_message_write_flow()->alloc();
+                    b->data()->reset(message()->data()->mti,
+                        train_node->node_id(), NodeHandle(pending_dst),
+                        message()->data()->payload);
+                    fix_consist_payload(cmd, pending_flags, b->data());
+                    burst.insert(tail, b);
+                    ++tail;
+                }
+                pending_dst = dst;
+                pending_flags = flags;
             }
-            else
+            if (!pending_dst)
             {
-                return allocate_and_call(
-                    iface()->addressed_message_write_flow(),
-                    STATE(forward_consist));
+                return release_and_exit();
+            }
+            // last node: we can transfer the message.
+            auto *b = transfer_message();
+            b->data()->src = NodeHandle(train_node->node_id());
+            b->data()->dst = NodeHandle(pending_dst);
+            b->data()->dstNode = nullptr;
+            fix_consist_payload(cmd, pending_flags, b->data());
+            burst.insert(tail, b);
+            while (!burst.empty())
+            {
+                iface()->addressed_message_write_flow()->send(
+                    burst.pop_front());
             }
+            return exit();
         }
 
-        Action forward_consist()
+        /// Adjusts a forwarded command for a consist member. @param cmd is
+        /// the traction command byte. @param flags are the consist flags of
+        /// the member. @param m is the forwarded message.
+        static void fix_consist_payload(
+            uint8_t cmd, uint8_t flags, GenMessage *m)
         {
-            auto *b =
-                get_allocation_result(iface()->addressed_message_write_flow());
-            uint8_t flags;
-            NodeID dst = train_node()->query_consist(nextConsistIndex_, &flags);
-            if (!dst)
+            if ((cmd == TractionDefs::REQ_SET_SPEED) &&
+                (flags & TractionDefs::CNSTFLAGS_REVERSE))
             {
-                // Strange. The consist destination should exist and never be
-                // zero once we got here.
-                b->unref();
-                return release_and_exit();
-            }
-            b->data()->reset(message()->data()->mti, train_node()->node_id(),
-                             NodeHandle(dst), message()->data()->payload);
-            if ((payload()[0] == TractionDefs::REQ_SET_SPEED) &&
-                (flags & TractionDefs::CNSTFLAGS_REVERSE)) {
-                b->data()->payload[1] ^= 0x80;
+                m->payload[1] ^= 0x80;
             }
-            iface()->addressed_message_write_flow()->send(b);
-            ++nextConsistIndex_;
-            return call_immediately(STATE(maybe_forward_consist));
         }
 
         Action handle_traction_mgmt()
@@ -595,10 +591,11 @@ struct TrainService::Impl
     private:
         /// error code for reject_permanent().
         unsigned errorCode_ : 16;
-        unsigned nextConsistIndex_ : 8;
         /// 1 if the voluntary lock protocol has set this train to be reserved.
         unsigned reserved_ : 1;
         TrainService *trainService_;
+        /// Train node the current message is addressed to.
+        TrainNode *trainNode_;
         Buffer<GenMessage> *response_;
     };
 
@@ -623,9 +620,19 @@ void TrainService::register_train(TrainNode *node)
     extern void StartInitializationFlow(Node * node);
     StartInitializationFlow(node);
     AtomicHolder h(this);
-    nodes_.insert(node);
+    nodes_[node] = node;
     LOG(VERBOSE, "Registered node %p for traction.", node);
-    HASSERT(nodes_.find(node) != nodes_.end());
+}
+
+TrainNode *TrainService::find_train(Node *node)
+{
+    AtomicHolder h(this);
+    auto it = nodes_.find(node);
+    if (it == nodes_.end())
+    {
+        return nullptr;
+    }
+    return it->second;
 }
 
 } // namespace openlcb
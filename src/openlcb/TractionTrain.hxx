@@ -35,7 +35,7 @@
 #ifndef _OPENLCB_TRACTIONTRAIN_HXX_
 #define _OPENLCB_TRACTIONTRAIN_HXX_
 
-#include <set>
+#include <unordered_map>
 
 #include "executor/Service.hxx"
 #include "openlcb/Node.hxx"
@@ -183,6 +183,19 @@ public:
         return 0;
     }
 
+    /** @return iterator to the first consist target. Used by the traction
+     * service to walk the consist in one pass when forwarding commands. */
+    TypedQueue<ConsistEntry>::iterator consist_begin()
+    {
+        return consistSlaves_.begin();
+    }
+
+    /** @return sentinel marking the end of the consist targets. */
+    SimpleQueue::end_iterator consist_end()
+    {
+        return consistSlaves_.end();
+    }
+
     /** Returns the number of slaves in this consist. */
     int query_consist_length()
     {
@@ -250,13 +263,19 @@ public:
     void register_train(TrainNode *node);
 
 private:
+    /** Looks up a local node in the train index. @param node is the
+     * destination node of an incoming message. @return the train node, or
+     * nullptr if node is not a train managed by this service. */
+    TrainNode *find_train(Node *node);
+
     struct Impl;
     /** Implementation flows. */
     Impl *impl_;
 
     If *iface_;
-    /** List of train nodes managed by this Service. */
-    std::set<TrainNode *> nodes_;
+    /** Train nodes managed by this Service, indexed by their Node base
+     * pointer as it appears in the incoming messages. */
+    std::unordered_map<Node *, TrainNode *> nodes_;
 };
 
 } // namespace openlcb
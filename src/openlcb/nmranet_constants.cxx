@@ -63,3 +63,31 @@ DEFAULT_CONST_FALSE(enable_all_memory_space);
  * identified messages at boot time. This is required by the OpenLCB
  * standard. */
 DEFAULT_CONST_TRUE(node_init_identify);
+
+/** Set to CONSTANT_TRUE if the event service should collect the matching event
+ * handlers and call them back-to-back instead of yielding to the executor
+ * between each handler call. */
+DEFAULT_CONST_FALSE(event_batched_dispatch);
+
+/** Stream buffer size in bytes proposed by the stream senders and accepted by
+ * the stream receivers, unless the caller asks for a different size. */
+DEFAULT_CONST(stream_buffer_size, 1024);
+
+/** How many stream buffers a stream receiver allows the sender to send ahead
+ * of the data consumed. */
+DEFAULT_CONST(stream_receiver_window, 2);
+
+/** Number of message payload buffers kept for reuse after the messages
+ * carrying them are freed. 0 disables the cache. Off by default to save
+ * memory on MCUs; host applications (e.g. the hub) turn it on. */
+DEFAULT_CONST(payload_cache_size, 0);
+
+/** Maximum number of CAN frames of a single message that the CAN write flows
+ * render and send back-to-back before yielding to the executor. Small, because
+ * each frame of a burst is a buffer allocated at once; host applications can
+ * raise it. */
+DEFAULT_CONST(can_write_burst_frames, 4);
+
+/** How many nodes the NodeInventory queries for PIP and SNIP at the same
+ * time. */
+DEFAULT_CONST(node_inventory_max_parallel, 16);
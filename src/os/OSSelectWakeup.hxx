@@ -48,6 +48,10 @@
 #include <signal.h>
 #endif
 
+#if OPENMRN_HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #ifdef __WINNT__
 #include <winsock2.h>
 #elif OPENMRN_HAVE_SELECT
@@ -243,6 +247,78 @@ public:
         return ret;
     }
 
+#if OPENMRN_HAVE_EPOLL
+    /** Waits for events on an epoll instance. Can be woken up asynchronously
+     * from a different thread the same way as select.
+     *
+     * @param epfd is the epoll file descriptor.
+     * @param events is the output array of ready events.
+     * @param max_events is the length of the events array.
+     * @param deadline_nsec is the maximum time to sleep if no fd activity and
+     * no wakeup happens. -1 to sleep indefinitely, 0 to return immediately.
+     *
+     * @return what epoll_wait would return (number of ready events, 0 in case
+     * of timeout), or -1 and errno==EINTR if the wait was woken up
+     * asynchronously
+     */
+    int epoll_wait(int epfd, struct epoll_event *events, int max_events,
+        long long deadline_nsec)
+    {
+        {
+            AtomicHolder l(this);
+            inSelect_ = true;
+            if (pendingWakeup_)
+            {
+                deadline_nsec = 0;
+            }
+        }
+        int ret = -1;
+        bool waited = false;
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 35)
+        if (deadline_nsec >= 0 && havePwait2_)
+        {
+            // Same nanosecond resolution as ::pselect, so that timers fire
+            // on time.
+            struct timespec timeout;
+            timeout.tv_sec = deadline_nsec / 1000000000;
+            timeout.tv_nsec = deadline_nsec % 1000000000;
+            ret = ::epoll_pwait2(
+                epfd, events, max_events, &timeout, &origMask_);
+            if (ret < 0 && errno == ENOSYS)
+            {
+                // Kernel older than 5.11.
+                havePwait2_ = false;
+            }
+            else
+            {
+                waited = true;
+            }
+        }
+#endif
+        if (!waited)
+        {
+            int timeout_msec;
+            if (deadline_nsec < 0)
+            {
+                timeout_msec = -1;
+            }
+            else
+            {
+                // Rounds up, so that we do not return before the deadline.
+                timeout_msec = (deadline_nsec + 999999) / 1000000;
+            }
+            ret = ::epoll_pwait(
+                epfd, events, max_events, timeout_msec, &origMask_);
+        }
+        {
+            AtomicHolder l(this);
+            pendingWakeup_ = false;
+            inSelect_ = false;
+        }
+        return ret;
+    }
+#endif
+
 private:
 #ifdef ESP32
     void esp_allocate_vfs_fd();
@@ -281,6 +357,10 @@ private:
     /// using to wake up.
     sigset_t origMask_;
 #endif
+#if OPENMRN_HAVE_EPOLL
+    /// false if the kernel does not support epoll_pwait2.
+    bool havePwait2_{true};
+#endif
 };
 
 #endif // _OS_OSSELECTWAKEUP_HXX_
@@ -33,6 +33,8 @@
 
 #include "utils/Buffer.hxx"
 
+#include "nmranet_config.h"
+
 DynamicPool *mainBufferPool = nullptr;
 
 Pool* init_main_buffer_pool()
@@ -41,6 +43,10 @@ Pool* init_main_buffer_pool()
     {
         mainBufferPool =
             new DynamicPool(Bucket::init(32, 48, LARGEST_BUFFERPOOL_BUCKET, 0));
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+        mainBufferPool->enable_thread_cache(
+            config_buffer_pool_thread_cache_size());
+#endif
     }
     return mainBufferPool;
 }
@@ -100,11 +106,18 @@ BufferBase *DynamicPool::alloc_untyped(size_t size, Executable *flow)
 {
     BufferBase *result = NULL;
 
-    for (Bucket *current = buckets; current->size() != 0; ++current)
+    unsigned index = 0;
+    for (Bucket *current = buckets; current->size() != 0; ++current, ++index)
     {
         if (size <= current->size())
         {
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+            result = cacheSize_ && index < MAX_CACHED_BUCKETS
+                ? cache_alloc(index, current)
+                : static_cast<BufferBase *>(current->next().item);
+#else
             result = static_cast<BufferBase*>(current->next().item);
+#endif
             if (result == NULL)
             {
                 result = (BufferBase*)buffer_malloc(current->size());
@@ -164,10 +177,18 @@ void DynamicPool::free(BufferBase *item)
         g_alloc_source.erase(item);
     }
 #endif
-    for (Bucket *current = buckets; current->size() != 0; ++current)
+    unsigned index = 0;
+    for (Bucket *current = buckets; current->size() != 0; ++current, ++index)
     {
         if (item->size() <= current->size())
         {
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+            if (cacheSize_ && index < MAX_CACHED_BUCKETS)
+            {
+                cache_free(index, current, item);
+                return;
+            }
+#endif
             current->insert(item);
             return;
         }
@@ -180,6 +201,187 @@ void DynamicPool::free(BufferBase *item)
     free_large(item);
 }
 
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+/// Free buffers cached by one thread for one DynamicPool.
+struct DynamicPool::ThreadCache
+{
+    /// Free buffers of one bucket.
+    struct Magazine
+    {
+        /// First free buffer; the others are linked through QMember::next.
+        QMember *head = nullptr;
+        /// Number of buffers in the list.
+        unsigned count = 0;
+        /// Hits not yet added to the pool's counters.
+        uint32_t hits = 0;
+        /// Misses not yet added to the pool's counters.
+        uint32_t misses = 0;
+    };
+
+    /// Returns the cached buffers to the pool when the thread exits.
+    ~ThreadCache()
+    {
+        if (pool)
+        {
+            pool->flush_thread_cache();
+        }
+    }
+
+    /// Pool whose buffers are cached, or nullptr if this thread did not use
+    /// any pool with a thread cache yet.
+    DynamicPool *pool = nullptr;
+    /// Free buffers for each bucket.
+    Magazine magazines[MAX_CACHED_BUCKETS];
+};
+
+thread_local DynamicPool::ThreadCache DynamicPool::threadCache_;
+
+BufferBase *DynamicPool::cache_alloc(unsigned index, Bucket *bucket)
+{
+    ThreadCache *c = &threadCache_;
+    if (c->pool != this)
+    {
+        if (c->pool)
+        {
+            // This thread caches the buffers of a different pool.
+            return static_cast<BufferBase *>(bucket->next().item);
+        }
+        c->pool = this;
+    }
+    ThreadCache::Magazine *m = &c->magazines[index];
+    if (m->head)
+    {
+        ++m->hits;
+    }
+    else
+    {
+        ++m->misses;
+        unsigned batch = cacheSize_ > 1 ? cacheSize_ / 2 : 1;
+        {
+            AtomicHolder h(bucket->lock());
+            while (m->count < batch)
+            {
+                QMember *item = bucket->next_locked().item;
+                if (!item)
+                {
+                    break;
+                }
+                item->next = m->head;
+                m->head = item;
+                ++m->count;
+            }
+        }
+        publish_stats(c, index);
+        if (!m->head)
+        {
+            return nullptr;
+        }
+    }
+    QMember *item = m->head;
+    m->head = item->next;
+    item->next = nullptr;
+    --m->count;
+    return static_cast<BufferBase *>(item);
+}
+
+void DynamicPool::cache_free(unsigned index, Bucket *bucket, BufferBase *item)
+{
+    ThreadCache *c = &threadCache_;
+    if (c->pool != this)
+    {
+        if (c->pool)
+        {
+            bucket->insert(item);
+            return;
+        }
+        c->pool = this;
+    }
+    ThreadCache::Magazine *m = &c->magazines[index];
+    item->next = m->head;
+    m->head = item;
+    if (++m->count > cacheSize_)
+    {
+        drain(c, index, cacheSize_ / 2);
+        cacheDrains_[index].fetch_add(1, std::memory_order_relaxed);
+        publish_stats(c, index);
+    }
+}
+
+void DynamicPool::drain(ThreadCache *c, unsigned index, unsigned keep)
+{
+    ThreadCache::Magazine *m = &c->magazines[index];
+    Bucket *bucket = &buckets[index];
+    AtomicHolder h(bucket->lock());
+    while (m->count > keep)
+    {
+        QMember *item = m->head;
+        m->head = item->next;
+        item->next = nullptr;
+        --m->count;
+        bucket->insert_locked(item);
+    }
+}
+
+void DynamicPool::publish_stats(ThreadCache *c, unsigned index)
+{
+    ThreadCache::Magazine *m = &c->magazines[index];
+    if (m->hits)
+    {
+        cacheHits_[index].fetch_add(m->hits, std::memory_order_relaxed);
+        m->hits = 0;
+    }
+    if (m->misses)
+    {
+        cacheMisses_[index].fetch_add(m->misses, std::memory_order_relaxed);
+        m->misses = 0;
+    }
+}
+
+void DynamicPool::flush_thread_cache()
+{
+    ThreadCache *c = &threadCache_;
+    if (c->pool != this)
+    {
+        return;
+    }
+    for (unsigned i = 0; i < MAX_CACHED_BUCKETS && buckets[i].size() != 0; ++i)
+    {
+        drain(c, i, 0);
+        publish_stats(c, i);
+    }
+    c->pool = nullptr;
+}
+
+bool DynamicPool::get_cache_stats(unsigned bucket, CacheStats *stats)
+{
+    if (bucket >= MAX_CACHED_BUCKETS)
+    {
+        return false;
+    }
+    for (unsigned i = 0; i <= bucket; ++i)
+    {
+        if (buckets[i].size() == 0)
+        {
+            return false;
+        }
+    }
+    ThreadCache *c = &threadCache_;
+    if (c->pool == this)
+    {
+        // Makes the calling thread's own counters exact.
+        publish_stats(c, bucket);
+    }
+    stats->hits = cacheHits_[bucket].load(std::memory_order_relaxed);
+    stats->misses = cacheMisses_[bucket].load(std::memory_order_relaxed);
+    stats->drains = cacheDrains_[bucket].load(std::memory_order_relaxed);
+    {
+        AtomicHolder h(this);
+        stats->highWater = buckets[bucket].allocCount_;
+    }
+    return true;
+}
+#endif // OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+
 /** Get a free item out of the pool.
  * @param size how many payload bytes should he allocated buffer have. Usually
  * sizeof<T> for Buffer<T>.
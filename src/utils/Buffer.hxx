@@ -46,6 +46,7 @@
 
 #include "executor/Executable.hxx"
 #include "executor/Notifiable.hxx"
+#include "openmrn_features.h"
 #include "os/OS.hxx"
 #include "utils/Atomic.hxx"
 #include "utils/MultiMap.hxx"
@@ -486,6 +487,11 @@ public:
     /** default destructor */
     ~DynamicPool()
     {
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+        // Buffers cached by other threads would be dangling; the pool must
+        // outlive those threads or they must call flush_thread_cache().
+        flush_thread_cache();
+#endif
 #ifdef GTEST
         for (unsigned i = 0; buckets[i].size() != 0; ++i)
         {
@@ -515,6 +521,50 @@ public:
      */
     size_t free_items(size_t size) override;
 
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+    /// Counters of the per-thread caches for one bucket.
+    struct CacheStats
+    {
+        /// Allocations served from a thread cache without locking.
+        uint32_t hits;
+        /// Allocations that found the thread cache empty and refilled it from
+        /// the bucket.
+        uint32_t misses;
+        /// How many times a thread cache was full and returned buffers to the
+        /// bucket.
+        uint32_t drains;
+        /// Number of buffers allocated from the heap for this bucket. Since
+        /// these are never returned to the heap, this is the high-water mark
+        /// of the buffers in use, including the ones held in thread caches.
+        uint32_t highWater;
+    };
+
+    /** Enables a per-thread cache of free buffers in front of the buckets.
+     * Each thread keeps up to size free buffers per bucket, and moves buffers
+     * between its cache and the bucket in batches of size / 2, taking the
+     * bucket lock only once per batch. A thread caches buffers for only one
+     * pool; other pools are used directly from that thread. Must be called
+     * before other threads start using the pool.
+     * @param size maximum number of buffers per bucket in each thread's cache.
+     * 0 disables the cache. */
+    void enable_thread_cache(unsigned size)
+    {
+        cacheSize_ = size;
+    }
+
+    /** Returns the buffers cached by the calling thread to the buckets. Called
+     * automatically when a thread exits. */
+    void flush_thread_cache();
+
+    /** Reads the counters of the thread caches. Hits and misses of other
+     * threads are added to the counters only when they next touch the
+     * bucket.
+     * @param bucket index of the bucket, 0 is the smallest.
+     * @param stats will be filled with the counters.
+     * @return false if there is no such bucket or it is not cached. */
+    bool get_cache_stats(unsigned bucket, CacheStats *stats);
+#endif
+
 protected:
     /** Free buffer queue */
     Bucket *buckets;
@@ -542,6 +592,45 @@ private:
      */
     void free(BufferBase *item) override;
 
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+    /// Only the first this many buckets are cached in the threads.
+    static constexpr unsigned MAX_CACHED_BUCKETS = 8;
+
+    /// Free buffers cached by one thread. Defined in Buffer.cxx.
+    struct ThreadCache;
+
+    /** Allocates an item using the calling thread's cache.
+     * @param index is the bucket index. @param bucket is the bucket.
+     * @return a free item, or nullptr if the bucket is empty too. */
+    BufferBase *cache_alloc(unsigned index, Bucket *bucket);
+
+    /** Releases an item to the calling thread's cache.
+     * @param index is the bucket index. @param bucket is the bucket.
+     * @param item the item to release. */
+    void cache_free(unsigned index, Bucket *bucket, BufferBase *item);
+
+    /** Moves items from a thread cache back to a bucket.
+     * @param c the thread cache. @param index which bucket.
+     * @param keep how many items to leave in the thread cache. */
+    void drain(ThreadCache *c, unsigned index, unsigned keep);
+
+    /** Adds the counters of a thread cache to the pool's counters.
+     * @param c the thread cache. @param index which bucket. */
+    void publish_stats(ThreadCache *c, unsigned index);
+
+    /// Each thread's cache. Points to at most one pool.
+    static thread_local ThreadCache threadCache_;
+
+    /// Maximum number of items per bucket in a thread cache. 0 if disabled.
+    unsigned cacheSize_{0};
+    /// Published hit counters for each bucket.
+    std::atomic<uint32_t> cacheHits_[MAX_CACHED_BUCKETS] {};
+    /// Published miss counters for each bucket.
+    std::atomic<uint32_t> cacheMisses_[MAX_CACHED_BUCKETS] {};
+    /// Drain counters for each bucket.
+    std::atomic<uint32_t> cacheDrains_[MAX_CACHED_BUCKETS] {};
+#endif
+
     /** Default constructor.
      */
     DynamicPool();
@@ -0,0 +1,162 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file FanoutPool.hxx
+ *
+ * Pool that hands out a fixed number of buffers from a single allocation. Used
+ * by the dispatcher to make the per-handler copies of a message without one
+ * pool allocation per handler.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#ifndef _UTILS_FANOUTPOOL_HXX_
+#define _UTILS_FANOUTPOOL_HXX_
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <stdlib.h>
+
+#include "utils/Buffer.hxx"
+
+/// Implementation of a Pool interface that carves a fixed number of
+/// equal-sized buffers out of one block of memory. The pool object lives at
+/// the start of the block and is reference counted: the creator holds one
+/// reference and every allocated buffer holds one. The block is freed when
+/// the creator has called release() and the last buffer is unreffed, so the
+/// buffers may outlive the creator and may be freed on any thread.
+///
+/// Only synchronous allocation from a single thread is supported. A buffer
+/// that is held for a long time keeps the entire block allocated.
+class FanoutPool : public Pool
+{
+public:
+    /// Allocates a new block.
+    /// @param entry_size is the byte size of the objects to be
+    /// allocated. Usually sizeof(Buffer<YourType>).
+    /// @param entry_count how many buffers the block has room for.
+    /// @return the new pool. The caller owns a reference, which has to be
+    /// dropped with release().
+    static FanoutPool *create(size_t entry_size, unsigned entry_count)
+    {
+        size_t item_size = align(entry_size);
+        void *m = malloc(align(sizeof(FanoutPool)) + item_size * entry_count);
+        HASSERT(m);
+        return new (m) FanoutPool(item_size, entry_count);
+    }
+
+    /// Drops the creator's reference. No more buffers may be allocated
+    /// afterwards.
+    void release()
+    {
+        unref_block();
+    }
+
+    /// @return true if all the buffers in this block have been allocated.
+    bool full()
+    {
+        return used_ >= count_;
+    }
+
+    /// Number of free items in the pool.
+    size_t free_items() override
+    {
+        return count_ - used_;
+    }
+
+    /// Number of free items in the pool for a given allocation size.
+    /// @param size size of interest
+    /// @return number of free items in the pool for a given allocation size
+    size_t free_items(size_t size) override
+    {
+        return align(size) == itemSize_ ? count_ - used_ : 0;
+    }
+
+protected:
+    /// Internal helper funciton used by the Buffer implementation.
+    BufferBase *alloc_untyped(size_t size, Executable *flow) override
+    {
+        if (flow)
+        {
+            DIE("FanoutPool only supports sync allocation.");
+        }
+        HASSERT(align(size) == itemSize_);
+        HASSERT(used_ < count_);
+        refCount_.fetch_add(1);
+        uint8_t *base = reinterpret_cast<uint8_t *>(this);
+        return reinterpret_cast<BufferBase *>(
+            base + align(sizeof(FanoutPool)) + itemSize_ * used_++);
+    }
+
+    /// Function called when a buffer refcount reaches zero.
+    void free(BufferBase *item) override
+    {
+        unref_block();
+    }
+
+private:
+    /// Constructor. @param item_size aligned size of each buffer.
+    /// @param count number of buffers.
+    FanoutPool(size_t item_size, unsigned count)
+        : itemSize_(item_size)
+        , count_(count)
+        , used_(0)
+        , refCount_(1)
+    {
+        totalSize = item_size * count;
+    }
+
+    /// Drops a reference to the block, and frees it if it was the last one.
+    void unref_block()
+    {
+        if (refCount_.fetch_sub(1) == 1u)
+        {
+            this->~FanoutPool();
+            ::free(this);
+        }
+    }
+
+    /// @param size a byte size. @return size rounded up so that every buffer
+    /// in the block is suitably aligned.
+    static size_t align(size_t size)
+    {
+        static constexpr size_t A = alignof(std::max_align_t);
+        return (size + A - 1) & ~(A - 1);
+    }
+
+    /// How many bytes each entry takes.
+    size_t itemSize_;
+    /// How many entries the block has.
+    unsigned count_;
+    /// How many entries were handed out.
+    unsigned used_;
+    /// Creator reference and one reference for each live buffer.
+    std::atomic<unsigned> refCount_;
+};
+
+#endif // _UTILS_FANOUTPOOL_HXX_
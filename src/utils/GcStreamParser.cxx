@@ -32,9 +32,12 @@
  * @date 26 May 2016
  */
 
+#include <algorithm>
+#include <string.h>
 #include <string>
 
 #include "utils/GcStreamParser.hxx"
+#include "can_frame.h"
 #include "utils/gc_format.h"
 
 bool GcStreamParser::consume_byte(char c)
@@ -75,6 +78,84 @@ bool GcStreamParser::consume_byte(char c)
     return false;
 }
 
+size_t GcStreamParser::consume_bytes(
+    const char *buf, size_t len, bool *complete)
+{
+    *complete = false;
+    size_t i = 0;
+    while (i < len)
+    {
+        if (offset_ < 0)
+        {
+            // Not in a frame: skips to the next sync byte.
+            const char *p =
+                static_cast<const char *>(memchr(buf + i, ':', len - i));
+            if (!p)
+            {
+                return len;
+            }
+            i = p - buf + 1;
+            offset_ = 0;
+            continue;
+        }
+        // Room left in cbuf_ (keeping one byte for the terminating zero).
+        size_t room = sizeof(cbuf_) - 1 - offset_;
+        const char *p = buf + i;
+        const char *e = buf + std::min(len, i + room + 1);
+        const char *d = p;
+        while (d < e && *d != ':' && *d != ';')
+        {
+            ++d;
+        }
+        if (d == e && (size_t)(e - p) > room)
+        {
+            // We overran the buffer, so this can't be a valid frame.
+            offset_ = -1;
+            i += room + 1;
+            continue;
+        }
+        memcpy(cbuf_ + offset_, p, d - p);
+        offset_ += d - p;
+        i = d - buf;
+        if (i == len)
+        {
+            // Frame continues in the next block.
+            return len;
+        }
+        ++i;
+        if (*d == ':')
+        {
+            // Frame is restarting here.
+            offset_ = 0;
+            continue;
+        }
+        // Frame ends here.
+        cbuf_[offset_] = 0;
+        offset_ = -1;
+        *complete = true;
+        return i;
+    }
+    return len;
+}
+
+unsigned GcStreamParser::parse_frames(const char *buf, size_t len,
+    struct can_frame *frames, unsigned max_frames, size_t *consumed)
+{
+    unsigned count = 0;
+    size_t ofs = 0;
+    while (ofs < len && count < max_frames)
+    {
+        bool complete;
+        ofs += consume_bytes(buf + ofs, len - ofs, &complete);
+        if (complete && parse_frame_to_output(frames + count))
+        {
+            ++count;
+        }
+    }
+    *consumed = ofs;
+    return count;
+}
+
 void GcStreamParser::frame_buffer(std::string* payload) {
     if (offset_ >= 0) {
         payload->assign(cbuf_, offset_);
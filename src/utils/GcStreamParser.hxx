@@ -35,8 +35,11 @@
 #ifndef _UTILS_GCSTREAMPARSER_HXX_
 #define _UTILS_GCSTREAMPARSER_HXX_
 
+#include <stddef.h>
 #include <string>
 
+struct can_frame;
+
 /**
    Parses a sequence of characters; finds GridConnect protocol packet
    boundaries in the sequence of packets. Contains an internal buffer holding
@@ -56,6 +59,34 @@ public:
      * internal buffer contains a complete frame. @param c next character. */
     bool consume_byte(char c);
 
+    /** Adds a block of characters from the source stream, stopping after the
+     * first complete frame. Equivalent to calling consume_byte for each
+     * character until it returns true, but skips the characters between
+     * frames with memchr and copies the frame contents in one go.
+     *
+     * @param buf is the next characters from the source stream.
+     * @param len is the number of characters in buf.
+     * @param complete will be set to true if the internal buffer contains a
+     * complete frame after the last consumed character, false otherwise.
+     * @return the number of characters consumed. If less than len, then
+     * *complete is true. */
+    size_t consume_bytes(const char *buf, size_t len, bool *complete);
+
+    /** Decodes all complete frames from a block of characters. Frames with a
+     * syntax error are dropped. A partial frame at the end of the block is
+     * kept and completed by the next call.
+     *
+     * @param buf is the next characters from the source stream.
+     * @param len is the number of characters in buf.
+     * @param frames is the output array.
+     * @param max_frames is the length of the frames array.
+     * @param consumed will be set to the number of characters consumed. Less
+     * than len only if max_frames frames were decoded; call again with the
+     * remaining characters.
+     * @return the number of frames written to the output array. */
+    unsigned parse_frames(const char *buf, size_t len,
+        struct can_frame *frames, unsigned max_frames, size_t *consumed);
+
     /** Parses the current contents of the frame buffer to a can_frame
      * struct. Should be called if and inly if the previous consume_char call
      * returned true.
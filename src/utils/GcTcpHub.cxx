@@ -37,16 +37,31 @@
 
 #include "nmranet_config.h"
 #include "utils/GridConnectHub.hxx"
+#include "utils/ShardedCanHub.hxx"
 
 void GcTcpHub::OnNewConnection(int fd)
 {
     const bool use_select =
         (config_gridconnect_tcp_use_select() == CONSTANT_TRUE);
+    if (shardedHub_)
+    {
+        shardedHub_->add_gc_port(fd, nullptr, use_select);
+        return;
+    }
     create_gc_port_for_can_hub(canHub_, fd, nullptr, use_select);
 }
 
 GcTcpHub::GcTcpHub(CanHubFlow *can_hub, int port)
     : canHub_(can_hub)
+    , shardedHub_(nullptr)
+    , tcpListener_(port, std::bind(&GcTcpHub::OnNewConnection, this,
+                                   std::placeholders::_1))
+{
+}
+
+GcTcpHub::GcTcpHub(ShardedCanHub *can_hub, int port)
+    : canHub_(can_hub->shard(0))
+    , shardedHub_(can_hub)
     , tcpListener_(port, std::bind(&GcTcpHub::OnNewConnection, this,
                                    std::placeholders::_1))
 {
@@ -38,6 +38,7 @@
 #include "utils/Hub.hxx"
 
 class ExecutorBase;
+class ShardedCanHub;
 
 /** This class runs a CAN-bus HUB listening on TCP socket using the gridconnect
  * format. Any new incoming connection will be wired into the same virtual CAN
@@ -52,6 +53,13 @@ public:
     /// onto.
     /// @param port TCp port number to listen on.
     GcTcpHub(CanHubFlow *can_hub, int port);
+    /// Constructor. Each new connection is added to the least loaded shard
+    /// of a sharded hub.
+    ///
+    /// @param can_hub Which sharded CAN-hub should we attach the TCP
+    /// gridconnect hub onto.
+    /// @param port TCp port number to listen on.
+    GcTcpHub(ShardedCanHub *can_hub, int port);
     ~GcTcpHub();
 
     /// @return true of the listener is ready to accept incoming connections.
@@ -70,6 +78,8 @@ private:
     /// @param can_hub Which CAN-hub should we attach the TCP gridconnect hub
     /// onto.
     CanHubFlow *canHub_;
+    /// If not null, new connections are added to this hub instead of canHub_.
+    ShardedCanHub *shardedHub_;
     /// Helper object representing the listening on the socket.
     SocketListener tcpListener_;
 };
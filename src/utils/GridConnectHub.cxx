@@ -241,10 +241,14 @@ public:
         /// frames. @return next state.
         Action parse_more_data()
         {
-            while (inBufSize_--)
+            while (inBufSize_)
             {
-                char c = *inBuf_++;
-                if (streamSegmenter_.consume_byte(c))
+                bool complete;
+                size_t consumed = streamSegmenter_.consume_bytes(
+                    inBuf_, inBufSize_, &complete);
+                inBuf_ += consumed;
+                inBufSize_ -= consumed;
+                if (complete)
                 {
                     // End of frame. Allocate an output buffer and parse the
                     // frame.
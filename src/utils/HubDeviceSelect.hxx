@@ -43,8 +43,12 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <fcntl.h>
+#if OPENMRN_HAVE_WRITEV
+#include <sys/uio.h>
+#endif
 
 #include "executor/StateFlow.hxx"
+#include "nmranet_config.h"
 #include "utils/Hub.hxx"
 
 /// Generic template for the buffer traits. HubDeviceSelect will not compile on
@@ -282,7 +286,7 @@ public:
     /// @param on_error notifiable that will be called when a write or read
     /// error is encountered.
     HubDeviceSelect(HFlow *hub, int fd, Notifiable *on_error = nullptr)
-        : FdHubPortService(hub->service()->executor(), fd)
+        : FdHubPortService(hub->service()->executor(), set_nonblocking(fd))
         , hub_(hub)
         , readFlow_(this, hub, &writeFlow_)
         , writeFlow_(this)
@@ -291,12 +295,6 @@ public:
         barrier_.reset(
             on_error ? on_error : EmptyNotifiable::DefaultInstance());
         barrier_.new_child();
-#ifdef __WINNT__
-        unsigned long par = 1;
-        ioctlsocket(fd_, FIONBIO, &par);
-#else
-        ::fcntl(fd, F_SETFL, O_RDWR | O_NONBLOCK);
-#endif
         hub_->register_port(write_port());
     }
 
@@ -357,6 +355,19 @@ public:
         return writeFlow_.is_waiting();
     }
 
+    /// @return how many write system calls were made to the fd. Together with
+    /// num_written_buffers() tells how well the writes are batched.
+    unsigned num_write_calls()
+    {
+        return numWriteCalls_;
+    }
+
+    /// @return how many hub buffers were written to the fd.
+    unsigned num_written_buffers()
+    {
+        return numWrittenBuffers_;
+    }
+
 protected:
     /// Base stateflow for the WriteFlow.
     typedef StateFlow<typename HFlow::buffer_type, QList<1>> WriteFlowBase;
@@ -403,10 +414,21 @@ protected:
             if (device()->fd() < 0) {
                 return this->release_and_exit();
             }
+#if OPENMRN_HAVE_WRITEV
+            batch_[0] = this->message();
+            batchSize_ = 1;
+            batchIndex_ = 0;
+            batchOffset_ = 0;
+            flushWaited_ = false;
+            return this->call_immediately(STATE(collect_batch));
+#else
+            ++device()->numWriteCalls_;
+            ++device()->numWrittenBuffers_;
             return this->write_repeated(&selectHelper_, device()->fd(),
                 this->message()->data()->data(),
                 this->message()->data()->size(), STATE(write_done),
                 this->priority());
+#endif
         }
 
         /// State flow call. @return next state.
@@ -418,12 +440,181 @@ protected:
             return this->release_and_exit();
         }
 
+#if OPENMRN_HAVE_WRITEV
+        /// Takes more buffers from the queue to be written together with the
+        /// current one. @return next state.
+        StateFlowBase::Action collect_batch()
+        {
+            unsigned max_batch = config_hub_device_write_batch_size();
+            if (max_batch > MAX_BATCH)
+            {
+                max_batch = MAX_BATCH;
+            }
+            while (batchSize_ < max_batch)
+            {
+                unsigned priority;
+                BufferBase *b = this->take_queued_message(&priority);
+                if (!b)
+                {
+                    break;
+                }
+                batch_[batchSize_++] = static_cast<buffer_type *>(b);
+            }
+            long long delay = config_hub_device_write_flush_usec();
+            if (delay > 0 && !flushWaited_ && batchSize_ < max_batch)
+            {
+                // Holds back the data for a bit to gather more buffers.
+                flushWaited_ = true;
+                return this->sleep_and_call(
+                    &timer_, USEC_TO_NSEC(delay), STATE(collect_batch));
+            }
+            return this->call_immediately(STATE(write_batch));
+        }
+
+        /// Writes all the collected buffers with a single writev call if the
+        /// fd accepts them. @return next state.
+        StateFlowBase::Action write_batch()
+        {
+            int fd = device()->fd();
+            // Skips empty buffers.
+            advance(0);
+            if (fd < 0 || batchIndex_ >= batchSize_)
+            {
+                return release_batch();
+            }
+            struct iovec iov[MAX_BATCH];
+            unsigned n = 0;
+            size_t total = 0;
+            for (unsigned i = batchIndex_; i < batchSize_; ++i)
+            {
+                size_t ofs = (i == batchIndex_) ? batchOffset_ : 0;
+                size_t len = batch_[i]->data()->size() - ofs;
+                if (!len)
+                {
+                    continue;
+                }
+                iov[n].iov_base = (void *)(
+                    (const uint8_t *)batch_[i]->data()->data() + ofs);
+                iov[n].iov_len = len;
+                total += len;
+                ++n;
+            }
+            ssize_t ret = ::writev(fd, iov, n);
+            if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+                errno != EINTR)
+            {
+                device()->report_write_error();
+                return release_batch();
+            }
+            if (ret > 0)
+            {
+                ++device()->numWriteCalls_;
+                advance(ret);
+                if ((size_t)ret == total)
+                {
+                    return release_batch();
+                }
+            }
+            // The fd did not accept everything. Waits until it is writable
+            // and writes the rest of the current buffer, then continues with
+            // the next ones.
+            return this->write_repeated(&selectHelper_, fd,
+                (const uint8_t *)batch_[batchIndex_]->data()->data() +
+                    batchOffset_,
+                batch_[batchIndex_]->data()->size() - batchOffset_,
+                STATE(partial_write_done), this->priority());
+        }
+
+        /// Called when the remainder of a buffer was written with
+        /// write_repeated. @return next state.
+        StateFlowBase::Action partial_write_done()
+        {
+            if (selectHelper_.hasError_)
+            {
+                device()->report_write_error();
+                return release_batch();
+            }
+            ++device()->numWriteCalls_;
+            advance(batch_[batchIndex_]->data()->size() - batchOffset_);
+            return this->call_immediately(STATE(write_batch));
+        }
+#endif
+
     private:
+#if OPENMRN_HAVE_WRITEV
+        /// Largest number of buffers to write in one system call.
+        static constexpr unsigned MAX_BATCH = 32;
+
+        /// Type of the buffers we are writing.
+        typedef typename HFlow::buffer_type buffer_type;
+
+        /// Moves the write position forward.
+        /// @param count how many bytes were written.
+        void advance(size_t count)
+        {
+            while (batchIndex_ < batchSize_)
+            {
+                size_t size = batch_[batchIndex_]->data()->size();
+                size_t left = size - batchOffset_;
+                if (count < left)
+                {
+                    batchOffset_ += count;
+                    return;
+                }
+                count -= left;
+                ++batchIndex_;
+                batchOffset_ = 0;
+                if (size)
+                {
+                    ++device()->numWrittenBuffers_;
+                }
+            }
+        }
+
+        /// Releases all buffers of the current batch. @return next state.
+        StateFlowBase::Action release_batch()
+        {
+            // batch_[0] is the current message.
+            this->release();
+            for (unsigned i = 1; i < batchSize_; ++i)
+            {
+                batch_[i]->unref();
+            }
+            batchSize_ = 0;
+            return this->exit();
+        }
+
+        /// Buffers being written. The first one is the current message.
+        buffer_type *batch_[MAX_BATCH];
+        /// Number of entries in batch_.
+        unsigned batchSize_{0};
+        /// Index of the first buffer in batch_ that is not yet written.
+        unsigned batchIndex_{0};
+        /// Number of bytes written from batch_[batchIndex_].
+        size_t batchOffset_{0};
+        /// True if we have already waited for the flush delay.
+        bool flushWaited_{false};
+        /// Timer for the flush delay.
+        StateFlowBase::StateFlowTimer timer_{this};
+#endif
         /// Helper class for asynchronous writes.
         StateFlowBase::StateFlowSelectHelper selectHelper_{this};
     };
 
 protected:
+    /// Puts an fd into non-blocking mode. This has to happen before the read
+    /// flow is started, otherwise its first read could block the executor.
+    /// @param fd the file descriptor. @return fd.
+    static int set_nonblocking(int fd)
+    {
+#ifdef __WINNT__
+        unsigned long par = 1;
+        ioctlsocket(fd, FIONBIO, &par);
+#else
+        ::fcntl(fd, F_SETFL, O_RDWR | O_NONBLOCK);
+#endif
+        return fd;
+    }
 
     /** The assumption here is that the write flow still has entries in its
      * queue that need to be removed. */
@@ -456,6 +647,10 @@ protected:
     /// StateFlow for writing data to the fd. Woken by data to send or the fd
     /// being writeable.
     WriteFlow writeFlow_;
+    /// Number of write system calls made.
+    unsigned numWriteCalls_{0};
+    /// Number of hub buffers written.
+    unsigned numWrittenBuffers_{0};
 };
 
 #endif // FEATURE_EXECUTOR_SELECT
@@ -0,0 +1,220 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ShardedCanHub.cxx
+ * A CAN hub that spreads its ports across multiple executor threads.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#include "utils/ShardedCanHub.hxx"
+
+#include <unistd.h>
+
+#include "executor/Executor.hxx"
+#include "executor/Service.hxx"
+#include "utils/GridConnectHub.hxx"
+#include "utils/format_utils.hxx"
+
+/// Port of one shard's hub that forwards the frames to another shard's hub.
+class ShardedCanHub::Link : public CanHubPortInterface
+{
+public:
+    /// Sets up the link. @param parent is the owning sharded hub. @param
+    /// target is the hub to forward frames to. @param peer is the link going
+    /// in the opposite direction.
+    void init(ShardedCanHub *parent, CanHubFlow *target, Link *peer)
+    {
+        parent_ = parent;
+        target_ = target;
+        peer_ = peer;
+    }
+
+    /// Called on the executor of the source shard for every frame.
+    /// @param message frame to forward; ownership is transferred.
+    /// @param priority priority of the frame.
+    void send(Buffer<CanHubData> *message, unsigned priority) OVERRIDE
+    {
+        if (parent_->is_link(message->data()->skipMember_))
+        {
+            // Came from a different shard, which forwards it to every shard
+            // by itself.
+            message->unref();
+            return;
+        }
+        // The target hub must not send the frame back to us.
+        message->data()->skipMember_ = peer_;
+        target_->send(message, priority);
+    }
+
+private:
+    /// Owning sharded hub.
+    ShardedCanHub *parent_;
+    /// Hub of the destination shard.
+    CanHubFlow *target_;
+    /// Link from the destination shard to the source shard.
+    Link *peer_;
+};
+
+/// Keeps track of the number of open ports on a shard.
+struct ShardedCanHub::PortExit : public Notifiable
+{
+    /// @param shard where the port was added. @param on_exit is the
+    /// application's notifiable, may be null.
+    PortExit(Shard *shard, Notifiable *on_exit)
+        : shard_(shard)
+        , onExit_(on_exit)
+    {
+    }
+
+    /// Called when the port is closed.
+    void notify() OVERRIDE
+    {
+        shard_->numPorts.fetch_sub(1);
+        if (onExit_)
+        {
+            onExit_->notify();
+        }
+        delete this;
+    }
+
+    /// Shard where the port was added.
+    Shard *shard_;
+    /// Notifiable to forward the exit to.
+    Notifiable *onExit_;
+};
+
+ShardedCanHub::ShardedCanHub(CanHubFlow *primary, unsigned num_shards)
+{
+    HASSERT(num_shards >= 1);
+    for (unsigned i = 0; i < num_shards; ++i)
+    {
+        Shard *s = new Shard;
+        shards_.emplace_back(s);
+        if (i == 0)
+        {
+            s->hub = primary;
+            continue;
+        }
+        s->name = "hub_shard" + integer_to_string(i);
+        s->executor.reset(new Executor<1>(s->name.c_str(), 0, 1024));
+        s->service.reset(new Service(s->executor.get()));
+        s->ownHub.reset(new CanHubFlow(s->service.get()));
+        s->hub = s->ownHub.get();
+    }
+    links_.reset(new Link[num_shards * num_shards]);
+    for (unsigned from = 0; from < num_shards; ++from)
+    {
+        for (unsigned to = 0; to < num_shards; ++to)
+        {
+            if (from == to)
+            {
+                continue;
+            }
+            link(from, to)->init(this, shard(to), link(to, from));
+            shard(from)->register_port(link(from, to));
+        }
+    }
+}
+
+ShardedCanHub::~ShardedCanHub()
+{
+    for (unsigned from = 0; from < size(); ++from)
+    {
+        for (unsigned to = 0; to < size(); ++to)
+        {
+            if (from != to)
+            {
+                shard(from)->unregister_port(link(from, to));
+            }
+        }
+    }
+    drain();
+    // The Shard destructor deletes the hub and the service before stopping
+    // the executor thread.
+    shards_.clear();
+}
+
+ShardedCanHub::Link *ShardedCanHub::link(unsigned from, unsigned to)
+{
+    return &links_[from * size() + to];
+}
+
+bool ShardedCanHub::is_link(CanHubPortInterface *port)
+{
+    if (size() < 2)
+    {
+        return false;
+    }
+    // Compares the base class pointers, so that the link's base class offset
+    // does not matter.
+    CanHubPortInterface *first = &links_[0];
+    CanHubPortInterface *last = &links_[size() * size() - 1];
+    uintptr_t p = reinterpret_cast<uintptr_t>(port);
+    return p >= reinterpret_cast<uintptr_t>(first) &&
+        p <= reinterpret_cast<uintptr_t>(last);
+}
+
+void ShardedCanHub::add_gc_port(int fd, Notifiable *on_exit, bool use_select)
+{
+    Shard *best = shards_[0].get();
+    for (auto &s : shards_)
+    {
+        if (s->numPorts.load() < best->numPorts.load())
+        {
+            best = s.get();
+        }
+    }
+    best->numPorts.fetch_add(1);
+    create_gc_port_for_can_hub(
+        best->hub, fd, new PortExit(best, on_exit), use_select);
+}
+
+void ShardedCanHub::drain()
+{
+    bool idle = false;
+    while (!idle)
+    {
+        idle = true;
+        for (auto &s : shards_)
+        {
+            // Makes sure the executor finished what it was doing.
+            SyncNotifiable n;
+            s->hub->service()->executor()->add(
+                new CallbackExecutable([&n]() { n.notify(); }));
+            n.wait_for_notification();
+            if (!s->hub->is_waiting())
+            {
+                idle = false;
+            }
+        }
+        if (!idle)
+        {
+            usleep(100);
+        }
+    }
+}
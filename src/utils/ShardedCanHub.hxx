@@ -0,0 +1,140 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ShardedCanHub.hxx
+ * A CAN hub that spreads its ports across multiple executor threads.
+ *
+ * @author agent
+ * @date 18 Oct 2026
+ */
+
+#ifndef _UTILS_SHARDEDCANHUB_HXX_
+#define _UTILS_SHARDEDCANHUB_HXX_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "utils/Hub.hxx"
+
+class ExecutorBase;
+
+/** A virtual CAN hub made of several CanHubFlow shards, each running on its
+ * own executor thread. Ports (typically gridconnect TCP connections) are
+ * placed on the shard that has the fewest ports, so that the reading,
+ * parsing, formatting and writing of the ports is spread across CPU cores.
+ *
+ * The shards are connected by a full mesh of link ports. The link from shard
+ * A to shard B is a port of hub A, and forwards each frame it gets into hub B,
+ * marking the frame with the link from B to A as skipMember_. Frames that
+ * arrived from another shard are not forwarded again. Thus every frame
+ * reaches every port exactly once, except for the port it originated from,
+ * same as with a single CanHubFlow. Since every hub queue is FIFO, the frames
+ * of a given source port arrive at every other port in the order they were
+ * sent.
+ *
+ * Shard 0 is the hub passed to the constructor; it keeps running on its own
+ * executor. */
+class ShardedCanHub
+{
+public:
+    /// Constructor.
+    ///
+    /// @param primary the hub to use as shard 0. Other components (upstream
+    /// connections, devices, packet printers) can be registered to this hub
+    /// directly, and will see all traffic.
+    /// @param num_shards total number of shards (including primary). Each
+    /// shard except the primary gets a new executor thread.
+    ShardedCanHub(CanHubFlow *primary, unsigned num_shards);
+
+    /// Destructor. All ports except the ones created by the constructor must
+    /// be unregistered before.
+    ~ShardedCanHub();
+
+    /// @return the number of shards.
+    unsigned size()
+    {
+        return shards_.size();
+    }
+
+    /// @param i shard index, 0 <= i < size().
+    /// @return the hub of a given shard.
+    CanHubFlow *shard(unsigned i)
+    {
+        return shards_[i]->hub;
+    }
+
+    /// Creates a new gridconnect port for a file descriptor on the shard with
+    /// the least number of ports. See create_gc_port_for_can_hub() in
+    /// GridConnectHub.hxx for the parameters.
+    ///
+    /// @param fd the file descriptor of the port.
+    /// @param on_exit (may be null) will be notified when the port is closed.
+    /// @param use_select true to use select, false to use threads for the fd.
+    void add_gc_port(int fd, Notifiable *on_exit, bool use_select);
+
+private:
+    class Link;
+    struct PortExit;
+
+    /// One shard of the hub.
+    struct Shard
+    {
+        /// Name of the executor thread.
+        std::string name;
+        /// Executor of this shard, null for the primary.
+        std::unique_ptr<ExecutorBase> executor;
+        /// Service of this shard, null for the primary.
+        std::unique_ptr<Service> service;
+        /// Hub flow of this shard, null for the primary.
+        std::unique_ptr<CanHubFlow> ownHub;
+        /// Hub flow of this shard.
+        CanHubFlow *hub;
+        /// How many ports were added by add_gc_port and are still open.
+        std::atomic<unsigned> numPorts{0};
+    };
+
+    /// @param from source shard index
+    /// @param to destination shard index
+    /// @return the link from shard from to shard to.
+    Link *link(unsigned from, unsigned to);
+
+    /// @param port a port of any shard.
+    /// @return true if port is one of the links between the shards.
+    bool is_link(CanHubPortInterface *port);
+
+    /// Waits until all shards are idle.
+    void drain();
+
+    /// All shards. The primary is at index 0.
+    std::vector<std::unique_ptr<Shard>> shards_;
+    /// Links between the shards, size() * size() entries. The diagonal is
+    /// unused.
+    std::unique_ptr<Link[]> links_;
+};
+
+#endif // _UTILS_SHARDEDCANHUB_HXX_
@@ -152,3 +152,7 @@ DEFAULT_CONST(gridconnect_bridge_max_incoming_packets, 1);
 DEFAULT_CONST(gridconnect_bridge_max_outgoing_packets, 1);
 
 DEFAULT_CONST_FALSE(gridconnect_tcp_use_select);
+
+DEFAULT_CONST(hub_device_write_batch_size, 16);
+DEFAULT_CONST(hub_device_write_flush_usec, 0);
+DEFAULT_CONST(buffer_pool_thread_cache_size, 0);
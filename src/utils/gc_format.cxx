@@ -40,42 +40,47 @@
 
 extern "C" {
 
+/// Uppercase hex digits, indexed by nibble value.
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
 /** Build an ASCII character representation of a nibble value (uppercase hex).
  * @param nibble to convert
  * @return converted value
  */
-static char nibble_to_ascii(int nibble)
+static inline char nibble_to_ascii(int nibble)
 {
-    nibble &= 0xf;
-
-    if (nibble < 10)
-    {
-        return ('0' + nibble);
-    }
-    
-    return ('A' + (nibble - 10));
+    return HEX_DIGITS[nibble & 0xf];
 }
 
+/// Nibble value of each character, or -1 if the character is not a hex
+/// digit. Avoids the comparison chain for each incoming character.
+static const int8_t NIBBLE_VALUES[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, -1, -1, -1, -1, // '0'..'9'
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, // 'A'..
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, // 'a'..
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, //
+};
+
 /** Tries to parse a hex character to a nibble. Understands both upper and
     lowercase hex.
     @param c is the character to convert.
     @return a converted value, or -1 if an invalid character was encountered.
 */
-static int ascii_to_nibble(const char c)
+static inline int ascii_to_nibble(const char c)
 {
-    if ('0' <= c && '9' >= c)
-    {
-        return c - '0';
-    }
-    else if ('A' <= c && 'F' >= c)
-    {
-        return c - 'A' + 10;
-    }
-    else if ('a' <= c && 'f' >= c)
-    {
-        return c - 'a' + 10;
-    }
-    return -1;
+    return NIBBLE_VALUES[(uint8_t)c];
 }
 
 
@@ -143,6 +148,12 @@ int gc_format_parse(const char* buf, struct can_frame* can_frame)
     int index = 0;
     while ((*buf != 0) && (*buf != ';'))
     {
+        if (index >= 8)
+        {
+            // Too much data for a CAN frame.
+            SET_CAN_FRAME_ERR(*can_frame);
+            return -1;
+        }
         int nh = ascii_to_nibble(*buf++);
         int nl = ascii_to_nibble(*buf++);
         if (nh < 0 || nl < 0)